@@ -0,0 +1,215 @@
+/**
+ * Edge Gunshot Detector - DSP table generator
+ * Host tool run by the Makefile: prints gunshot_dsp_tables.h with the Hann window,
+ * Q15 twiddles and librosa-compatible mel filter bank for gunshot_dsp_config.h.
+ * Usage: gen_dsp_tables > gunshot_dsp_tables.h
+ * © 2025 Claude Coding. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "gunshot_dsp_config.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static float mel_filter_bank[N_MELS][N_FFT_BINS];
+static int mel_bin_start[N_MELS];
+static int mel_bin_end[N_MELS];
+
+/**
+ * Convert frequency to mel scale
+ */
+static float hz_to_mel(float hz) {
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+/**
+ * Convert mel scale to frequency
+ */
+static float mel_to_hz(float mel) {
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+/**
+ * Compute the mel filter bank matrix (librosa-compatible) and each filter's non-zero span
+ */
+static void compute_mel_filter_bank(void) {
+    float mel_min = hz_to_mel(MEL_FMIN);
+    float mel_max = hz_to_mel(MEL_FMAX);
+
+    float mel_points[N_MELS + 2];
+    for (int i = 0; i < N_MELS + 2; i++) {
+        mel_points[i] = mel_min + (mel_max - mel_min) * i / (N_MELS + 1);
+    }
+
+    float hz_points[N_MELS + 2];
+    for (int i = 0; i < N_MELS + 2; i++) {
+        hz_points[i] = mel_to_hz(mel_points[i]);
+    }
+
+    int bin_points[N_MELS + 2];
+    for (int i = 0; i < N_MELS + 2; i++) {
+        float bin = floorf(hz_points[i] * N_FFT / TARGET_SAMPLE_RATE);
+        bin_points[i] = (int)bin;
+        if (bin_points[i] >= N_FFT_BINS) {
+            bin_points[i] = N_FFT_BINS - 1;
+        }
+    }
+
+    for (int m = 0; m < N_MELS; m++) {
+        int left = bin_points[m];
+        int center = bin_points[m + 1];
+        int right = bin_points[m + 2];
+
+        for (int k = left; k < center; k++) {
+            if (center > left) {
+                mel_filter_bank[m][k] = (float)(k - left) / (center - left);
+            }
+        }
+
+        for (int k = center; k < right; k++) {
+            if (right > center) {
+                mel_filter_bank[m][k] = (float)(right - k) / (right - center);
+            }
+        }
+
+        if (MEL_NORM_SLANEY) {
+            float area = 0.0f;
+            for (int k = 0; k < N_FFT_BINS; k++) {
+                area += mel_filter_bank[m][k];
+            }
+            if (area > 0.0f) {
+                for (int k = 0; k < N_FFT_BINS; k++) {
+                    mel_filter_bank[m][k] /= area;
+                }
+            }
+        }
+
+        // Non-zero span, shared by the float and Q15 paths (Q15 weights round to zero at the same edges)
+        mel_bin_start[m] = 0;
+        mel_bin_end[m] = 0;
+        for (int k = 0; k < N_FFT_BINS; k++) {
+            if (lroundf(mel_filter_bank[m][k] * 32768.0f) != 0) {
+                if (mel_bin_end[m] == 0) {
+                    mel_bin_start[m] = k;
+                }
+                mel_bin_end[m] = k + 1;
+            }
+        }
+    }
+}
+
+static float hann(int i) {
+    return 0.5f * (1.0f - cosf(2.0f * M_PI * i / (N_FFT - 1)));
+}
+
+/**
+ * Print a float so it round-trips exactly
+ */
+static void print_float(float v) {
+    printf("%.9ef", v);
+}
+
+static void print_hann_window(void) {
+    printf("static const float hann_window[N_FFT] DSP_TABLE_ALIGN = {");
+    for (int i = 0; i < N_FFT; i++) {
+        printf(i % 6 ? " " : "\n    ");
+        print_float(hann(i));
+        printf(",");
+    }
+    printf("\n};\n\n");
+}
+
+static void print_mel_filter_bank(void) {
+    printf("static const float mel_filter_bank[N_MELS][N_FFT_BINS] DSP_TABLE_ALIGN = {\n");
+    for (int m = 0; m < N_MELS; m++) {
+        printf("    {");
+        for (int k = 0; k < N_FFT_BINS; k++) {
+            printf(k % 6 ? " " : "\n        ");
+            print_float(mel_filter_bank[m][k]);
+            printf(",");
+        }
+        printf("\n    },\n");
+    }
+    printf("};\n\n");
+}
+
+static void print_mel_spans(void) {
+    printf("static const uint16_t mel_bin_start[N_MELS] = {");
+    for (int m = 0; m < N_MELS; m++) {
+        printf("%s%d,", m % 14 ? " " : "\n    ", mel_bin_start[m]);
+    }
+    printf("\n};\n\n");
+    printf("static const uint16_t mel_bin_end[N_MELS] = {");
+    for (int m = 0; m < N_MELS; m++) {
+        printf("%s%d,", m % 14 ? " " : "\n    ", mel_bin_end[m]);
+    }
+    printf("\n};\n\n");
+}
+
+static void print_q15_tables(void) {
+    printf("static const int16_t hann_window_q15[N_FFT] DSP_TABLE_ALIGN = {");
+    for (int i = 0; i < N_FFT; i++) {
+        long q = lroundf(hann(i) * 32768.0f);
+        printf("%s%ld,", i % 12 ? " " : "\n    ", q > 32767 ? 32767 : q);
+    }
+    printf("\n};\n\n");
+
+    // cos/sin of 2*pi*k/N_FFT, 1.0 = 32768
+    printf("static const int32_t fft_cos_q15[N_FFT / 2 + 1] DSP_TABLE_ALIGN = {");
+    for (int k = 0; k <= N_FFT / 2; k++) {
+        printf("%s%ld,", k % 12 ? " " : "\n    ", lround(cos(2.0 * M_PI * k / N_FFT) * 32768.0));
+    }
+    printf("\n};\n\n");
+    printf("static const int32_t fft_sin_q15[N_FFT / 2 + 1] DSP_TABLE_ALIGN = {");
+    for (int k = 0; k <= N_FFT / 2; k++) {
+        printf("%s%ld,", k % 12 ? " " : "\n    ", lround(sin(2.0 * M_PI * k / N_FFT) * 32768.0));
+    }
+    printf("\n};\n\n");
+
+    printf("static const uint16_t mel_weights_q15[N_MELS][N_FFT_BINS] DSP_TABLE_ALIGN = {\n");
+    for (int m = 0; m < N_MELS; m++) {
+        printf("    {");
+        for (int k = 0; k < N_FFT_BINS; k++) {
+            long q = lroundf(mel_filter_bank[m][k] * 32768.0f);
+            printf("%s%ld,", k % 12 ? " " : "\n        ", q > 32768 ? 32768 : q);
+        }
+        printf("\n    },\n");
+    }
+    printf("};\n\n");
+
+    printf("static const float log2_mantissa[256] DSP_TABLE_ALIGN = {");
+    for (int i = 0; i < 256; i++) {
+        printf(i % 6 ? " " : "\n    ");
+        print_float(log2f(1.0f + (i + 0.5f) / 256.0f));
+        printf(",");
+    }
+    printf("\n};\n\n");
+}
+
+int main(void) {
+    compute_mel_filter_bank();
+
+    printf("/* Generated by gen_dsp_tables from gunshot_dsp_config.h - do not edit */\n\n");
+    printf("#ifndef GUNSHOT_DSP_TABLES_H\n#define GUNSHOT_DSP_TABLES_H\n\n");
+    printf("#include <stdint.h>\n#include \"gunshot_dsp_config.h\"\n\n");
+
+    // Refuse to compile against tables baked for a different configuration
+    printf("#if TARGET_SAMPLE_RATE != %d || N_FFT != %d || N_MELS != %d || MEL_NORM_SLANEY != %d\n",
+           TARGET_SAMPLE_RATE, N_FFT, N_MELS, MEL_NORM_SLANEY);
+    printf("#error \"gunshot_dsp_tables.h is stale, rerun gen_dsp_tables\"\n#endif\n\n");
+    printf("#define DSP_TABLE_ALIGN __attribute__((aligned(64)))\n\n");
+
+    print_mel_spans();
+    printf("#ifdef GUNSHOT_FIXED_POINT\n");
+    print_q15_tables();
+    printf("#else\n");
+    print_hann_window();
+    print_mel_filter_bank();
+    printf("#endif\n\n#endif\n");
+    return 0;
+}
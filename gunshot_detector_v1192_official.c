@@ -5,9 +5,12 @@
  * © 2025 Claude Coding. All rights reserved.
  */
 
+#define _GNU_SOURCE  // accept4()
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
@@ -18,8 +21,20 @@
 #include <time.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
+#include <dirent.h>
+#include <sched.h>
 #include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <arpa/inet.h>
 #include <poll.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <glib.h>
 #include <gio/gio.h>
 
@@ -40,28 +55,131 @@
 #include <complex.h>
 #include <fftw3.h>
 
-// Audio processing constants (from v1.1.78 working model)
+// Shared-memory stats block layout
+#include "gunshot_stats.h"
+
+// DSP configuration and the window, twiddle and mel tables generated for it at build time
+#include "gunshot_dsp_config.h"
+#include "gunshot_dsp_tables.h"
+
 #define SAMPLE_RATE 48000
-#define TARGET_SAMPLE_RATE 22050
-#define N_FFT 1024
-#define HOP_LENGTH 512
-#define N_MELS 28
-#define N_FRAMES 160
 #define EXPECTED_INPUT_SIZE (N_MELS * N_FRAMES)
 
-// Audio buffer (sized for gunshot detection)
-#define AUDIO_BUFFER_SIZE 180800  // Enough for 160 frames at 48kHz
-#define INFERENCE_THRESHOLD 88000  // ~2 seconds at 48kHz
+// Audio buffer (sized for gunshot detection, samples at TARGET_SAMPLE_RATE after conversion)
+#define AUDIO_BUFFER_SIZE 180800  // Window plus generous room for large capture quanta
+#define WINDOW_SAMPLES (N_FFT + N_FRAMES * HOP_LENGTH)  // 160 full frames, ~3.8 s
+#define INFERENCE_THRESHOLD WINDOW_SAMPLES
+#define MIN_RMS_THRESHOLD 0.001f  // -60 dB, quieter windows skip analysis
 
-// Mel filter bank parameters
-#define N_FFT_BINS (N_FFT / 2 + 1)  // 513 bins
-#define MEL_FMIN 0.0f
-#define MEL_FMAX (TARGET_SAMPLE_RATE / 2.0f)  // Nyquist frequency
-#define MEL_NORM_SLANEY 1  // Use Slaney normalization (librosa default)
+// Sample representation: S16 capture with a Q15 front-end (make FIXED_POINT=1) or F32
+#ifdef GUNSHOT_FIXED_POINT
+typedef int16_t sample_t;
+#define CAPTURE_FORMAT SPA_AUDIO_FORMAT_S16
+#else
+typedef float sample_t;
+#define CAPTURE_FORMAT SPA_AUDIO_FORMAT_F32
+#endif
 
 // Configuration
 #define CONFIG_PATH "/usr/local/packages/gunshot_detector/conf/gunshot_detector.conf"
 static float confidence_threshold = 0.45f;  // Default 45%
+static uint32_t threshold_generation = 1;   // Bumped on every threshold change
+
+// Event classes: the gunshot model plus up to MAX_EXTRA_HEADS extra heads (see extra_models)
+#define MAX_EXTRA_HEADS 3
+#define HEAD_LABEL_MAX 16
+#define PRIMARY_LABEL "gunshot"
+
+// Cascade first stage: linear screen over the mel frames, 0 sends every non-silent window to the model
+#define SCREEN_WEIGHTS_PATH "/usr/local/packages/gunshot_detector/screen_weights.txt"
+#define SCREEN_N_WEIGHTS (2 * N_MELS)  // Per band: mean level, peak above mean
+static float cascade_threshold = 0.0f;  // Off until trained screen weights ship
+static float screen_bias = -6.0f;
+static float screen_weights[SCREEN_N_WEIGHTS];
+
+// Decision engine: an event opens when k of the last n windows exceed the threshold and
+// closes once confidence falls release_margin below it; stride 0 = back-to-back windows
+#define MAX_VOTE_WINDOWS 32
+static int vote_k = 1;
+static int vote_n = 1;
+static int release_margin = 5;  // Percent
+static int window_stride_ms = 0;
+
+// Onset trigger: a streaming transient detector schedules an extra window as soon as enough audio after
+// the onset has arrived, instead of waiting for the next regular window to fill
+#define ONSET_BLOCK 256                  // Energy block, ~12 ms
+#define ONSET_RATIO 30.0f                // Block energy over background (~15 dB) that counts as an onset
+#define ONSET_BACKGROUND_BLOCKS 64       // Background energy time constant, ~0.75 s
+#define ONSET_POST_MS 300                // Audio after the onset in an early window (onset sits this far from its end)
+#define ONSET_REFRACTORY_MS 1000
+static bool onset_trigger = true;
+
+struct onset_state {
+    float background;        // Slow mean energy of non-onset blocks
+    float block_energy;
+    uint32_t block_fill;
+    bool primed;
+    uint64_t last;           // Stream position of the latest onset, 0 = none yet
+    uint64_t due;            // Stream position an early window ends at, 0 = none scheduled
+};
+
+static struct onset_state onset;
+
+// Confirmation burst: a window scoring within confirm_margin of the threshold is a coin flip, so it is
+// re-run on windows shifted by up to CONFIRM_SHIFT_HOPS hops either way and the burst's majority decides
+#define CONFIRM_SHIFT_HOPS 8
+#define CONFIRM_STEP_HOPS 4              // Shifts of -8, -4, +4 and +8 hops: four extra inferences
+static int confirm_margin = 5;           // Percent either side of the threshold, 0 = off
+
+struct confirm_state {
+    bool pending;            // Ambiguous window waiting for the audio after it
+    bool regular;            // A regular window: the stride is applied once it is decided
+    uint64_t window_end;     // Stream position
+    uint32_t stride;
+    float probability;
+    float rms;
+    bool vote;
+};
+
+static struct confirm_state confirm;
+static uint64_t confirm_bursts = 0;
+static uint64_t confirm_inferences = 0;
+static uint64_t confirm_overturned = 0;  // Bursts that reversed the single window's vote
+static uint64_t confirm_carry_us = 0;    // Burst time, charged to the next window's real-time factor
+
+// Mel frames by stream position, shared by overlapping, onset and burst windows on the hop grid
+#define MEL_RING_FRAMES 256              // Power of two, covers a window plus the burst shifts
+
+struct mel_frame {
+    uint64_t tag;            // Stream position + 1, 0 = empty
+    float mel[N_MELS];
+};
+
+static struct mel_frame mel_ring[MEL_RING_FRAMES];
+static uint64_t mel_frames_computed = 0;
+static uint64_t mel_frames_reused = 0;
+
+// Real-time analysis: pinned, pre-faulted buffers, SCHED_FIFO, CPU affinity and flush-to-zero,
+// applied once on the analysis thread when capture starts (changes need a restart)
+static bool realtime_mode = false;
+static int realtime_priority = 10;
+static int realtime_cpu = -1;  // -1 = no pinning
+static bool realtime_active = false;
+
+// Load shedding: when analysis falls behind, step down the gunshot_stats.h ladder (losing resolution,
+// not audio) and step back up once the real-time factor has stayed low; a quick relapse doubles the wait
+#define LOAD_SHED_RTF 0.8f              // Real-time factor that counts as falling behind
+#define LOAD_RESTORE_RTF 0.3f           // Real-time factor calm enough to try the next better level
+#define LOAD_SHED_LAG_MS 1000.0f        // Ring lag that counts as falling behind
+#define LOAD_SHED_HOLD_MS 5000          // Let the real-time factor settle before shedding again
+#define LOAD_RESTORE_HOLD_MS 30000      // Calm time before restoring a level
+#define LOAD_RESTORE_HOLD_MAX_MS 600000
+#define ENERGY_ONLY_CREST 8.0f          // Peak over RMS (18 dB) that counts as an impulse without the mel
+static bool load_shedding = true;
+static enum gunshot_load_level load_level = GUNSHOT_LOAD_FULL;
+static uint64_t load_level_changed_us = 0;
+static uint64_t load_calm_since_us = 0;
+static uint32_t load_restore_hold_ms = LOAD_RESTORE_HOLD_MS;
 
 // Parameter configuration via manifest.json
 
@@ -72,41 +190,178 @@ static int smtp_port = 587;
 static char smtp_username[256] = "";
 static char smtp_password[256] = "";
 static char recipient_email[256] = "";
-static time_t last_email_time = 0;
-static const int EMAIL_RATE_LIMIT_SECONDS = 120;  // 2 minutes between emails
 
-// Global mel filter bank matrix (pre-computed)
-static float mel_filter_bank[N_MELS][N_FFT_BINS];
-static bool mel_filters_initialized = false;
+// Email coalescing: the first event after a quiet period is sent at once, later ones wait for a digest
+#define EMAIL_QUIET_SECONDS 120          // Digest goes out once events have stopped for this long
+#define EMAIL_DIGEST_MAX_SECONDS 600     // ... or this long after its first event, whichever is sooner
+#define EMAIL_DIGEST_MAX_LISTED 32
+
+struct email_digest {
+    uint32_t count;
+    uint32_t ids[EMAIL_DIGEST_MAX_LISTED];
+    uint64_t times_ms[EMAIL_DIGEST_MAX_LISTED];
+    float confidences[EMAIL_DIGEST_MAX_LISTED];
+    char labels[EMAIL_DIGEST_MAX_LISTED][HEAD_LABEL_MAX];
+    bool gunshots_only;
+    uint64_t first_ms;
+    uint64_t last_ms;
+    float peak;
+    uint64_t started_us;
+    uint64_t last_event_us;
+    uint64_t retry_at_us;
+    uint32_t retry_backoff_ms;
+};
+
+static struct email_digest email_digest;  // Owned by the email sink thread
+static uint64_t last_email_us = 0;
+
+// Evidence clips: the analysis thread copies the window that opened an event into a staging slot; the email
+// sink writes it out as WAV (plus a mel spectrogram PNG) and streams the files from their mappings as
+// attachments, so alert memory stays constant whatever the clip length
+#define CLIP_DIR SPOOL_DIR "/clips"
+#define CLIP_SLOTS 2                     // Events opened while the sink is still writing an older clip
+#define CLIP_KEEP 16                     // Newest clips kept on disk, for spooled retries and later review
+#define EMAIL_ATTACHMENT_MAX_BYTES (1024 * 1024)
+#define SPECTROGRAM_X_SCALE 2            // Pixels per mel frame
+#define SPECTROGRAM_Y_SCALE 4            // Pixels per mel band
+static bool email_attach_clip = false;
+static bool email_attach_spectrogram = false;
 
+struct clip_slot {
+    _Atomic uint32_t seq;    // Odd while the analysis thread is writing
+    uint32_t event_id;
+    uint64_t time_ms;
+    uint32_t samples;
+    bool has_mel;            // No mel at the energy-only load level
+    sample_t audio[WINDOW_SAMPLES];
+    float mel[EXPECTED_INPUT_SIZE];
+};
+
+static struct clip_slot clip_slots[CLIP_SLOTS];
+static uint32_t clip_slot_next = 0;
+
+// Webhook alerts: JSON POST per event to each endpoint, see webhook_refresh_config for the list format
+#define MAX_WEBHOOKS 4
+#define WEBHOOK_RETRY_BACKOFF_MS 250     // Doubles with each retry
+static char webhook_urls[1024] = "";
+static int webhook_timeout_ms = 2000;
+static int webhook_retries = 2;
+
+// MQTT publisher: events, heartbeats and a retained online/offline status under mqtt_topic (plain TCP)
+#define MQTT_PORT 1883
+#define MQTT_KEEPALIVE_S 60
+#define MQTT_TIMEOUT_MS 3000            // TCP connect, CONNACK and PUBACK
+#define MQTT_RECONNECT_MIN_MS 1000
+#define MQTT_RECONNECT_MAX_MS 60000
+#define MQTT_MAX_PACKET 1024
+static char mqtt_broker[256] = "";      // host[:port], empty = disabled
+static char mqtt_topic[128] = "axis/gunshot";
+static int mqtt_qos = 1;
+static char mqtt_username[128] = "";
+static char mqtt_password[128] = "";
+static int mqtt_heartbeat_s = 60;       // 0 = no heartbeat
+
+// Prometheus metrics endpoint: "" = disabled, "9464" = TCP port on 127.0.0.1, "/path" = Unix socket
+static char metrics_endpoint[256] = "";
+
+#ifdef GUNSHOT_FIXED_POINT
+// Extra fraction bits kept after windowing; full-scale FFT growth (x512) still fits int32
+#define FFT_GUARD_BITS 5
+
+// Q15 FFT workspace (window, twiddles and sparse mel weights come from gunshot_dsp_tables.h)
+static int32_t fft_re[N_FFT / 2];
+static int32_t fft_im[N_FFT / 2];
+#else
 // FFT workspace
 static fftwf_complex *fft_in = NULL;
 static fftwf_complex *fft_out = NULL;
 static fftwf_plan fft_plan = NULL;
-static float *hann_window = NULL;
-static bool fft_initialized = false;
-
-// LAROD variables
-static larodConnection *conn = NULL;
-static const larodDevice *dev = NULL;
-static larodModel *model = NULL;
-static larodJobRequest *infReq = NULL;
-static larodTensor **inputTensors = NULL;
-static larodTensor **outputTensors = NULL;
-static size_t numInputs = 0;
-static size_t numOutputs = 0;
-
-// Tensor file descriptors and memory mapping
-static int inputTensorFd = -1;
-static int outputTensorFd = -1;
-static void *inputTensorAddr = NULL;
-static void *outputTensorAddr = NULL;
-static size_t inputTensorSize = EXPECTED_INPUT_SIZE * sizeof(int8_t);
-static size_t outputTensorSize = 2 * sizeof(int8_t);
+#endif
+
+// LAROD model backend: connection, model, tensors and job request, swapped as one unit
+#define DEFAULT_MODEL_PATH "/usr/local/packages/gunshot_detector/gunshot_model_real_audio.tflite"
+
+// Streaming models take a few new mel frames per step and carry their state in extra input/output pairs
+#define STREAM_MAX_FRAMES 16
+#define MODEL_MAX_STATES 8
+
+struct model_state_tensor {
+    int inputFd;
+    int outputFd;
+    void *inputAddr;
+    void *outputAddr;
+    size_t size;
+    larodTensorDataType type;
+    int32_t zeroPoint;        // Quantized zero state
+};
+
+struct model_backend {
+    larodConnection *conn;
+    const larodDevice *dev;
+    larodModel *model;
+    larodJobRequest *infReq;
+    larodTensor **inputTensors;
+    larodTensor **outputTensors;
+    size_t numInputs;
+    size_t numOutputs;
+
+    // Tensor file descriptors and memory mapping
+    int inputTensorFd;
+    int outputTensorFd;
+    void *inputTensorAddr;
+    void *outputTensorAddr;
+
+    // Tensor metadata read at load time (larod for shapes and types, the .tflite for quantization)
+    larodTensorDataType inputType;
+    larodTensorDataType outputType;
+    size_t inputTensorSize;
+    size_t outputTensorSize;
+    bool inputMelMajor;       // [.., N_MELS, N_FRAMES] rather than [.., N_FRAMES, N_MELS]
+    int inputFrames;          // N_FRAMES for window models, new frames per step for streaming ones
+    float inputScale;
+    int32_t inputZeroPoint;
+    float outputScale;
+    int32_t outputZeroPoint;
+    bool outputSoftmax;       // Output holds class probabilities rather than logits
+    
+    // Detection threshold folded into the output domain, refreshed when the threshold changes
+    float ownThreshold;       // Extra heads with their own threshold; 0 follows confidence_threshold
+    uint32_t thresholdGeneration;
+    int32_t voteThresholdQ;   // Quantized outputs: compare against the int difference / int value
+    float voteThreshold;      // Float outputs
+    
+    // Streaming models: state output i is copied into state input i after every step
+    bool streaming;
+    size_t numStates;
+    struct model_state_tensor states[MODEL_MAX_STATES];
+    
+    char path[256];
+    time_t mtime;
+    uint32_t generation;
+};
+
+// Model hot-swap: the audio thread owns active_backend, the loader thread hands over via staged_backend
+static struct model_backend *active_backend = NULL;
+static struct model_backend *_Atomic staged_backend = NULL;
+static _Atomic bool model_loading = false;
+static volatile sig_atomic_t model_reload_requested = 0;
+static char model_path[256] = DEFAULT_MODEL_PATH;
+static char model_attempt_path[256] = "";
+static time_t model_attempt_mtime = 0;
+static uint32_t model_generation = 0;
+static _Atomic uint64_t model_reloads = 0;
+static _Atomic uint64_t model_reload_failures = 0;
+static float canned_window_features[EXPECTED_INPUT_SIZE];  // Silent window mel features for sanity checks
+static float window_mel_features[EXPECTED_INPUT_SIZE];     // Mel features of the last analysed window
+static bool window_mel_valid = false;
 
 // Audio processing state
-static float audio_buffer[AUDIO_BUFFER_SIZE];
+static sample_t audio_buffer[AUDIO_BUFFER_SIZE];
 static uint32_t samples_accumulated = 0;
+static uint32_t window_start = 0;        // Buffer index of the next regular window; audio before it is history
+static uint64_t samples_total = 0;       // Stream position of the end of audio_buffer
+static uint64_t stream_anchor_ms = 0;    // Wall clock at stream position 0: events carry when the audio was heard
+static uint64_t last_window_end = 0;     // Stream position where the last analysed window ended
 static uint32_t debug_counter = 0;
 
 // Global running flag and ML state
@@ -115,6 +370,248 @@ static volatile bool ml_ready = false;
 static uint32_t inference_count = 0;
 static uint32_t detection_count = 0;
 
+// Startup: the initial model loads on its own thread while PipeWire connects and discovers nodes
+static uint64_t startup_begin_us = 0;
+static bool startup_complete = false;          // First window analysed, timeline closed
+static uint64_t startup_first_window_ms = 0;
+static char startup_model_path[256];
+static pthread_t model_startup_thread;
+static bool model_startup_running = false;
+static struct model_backend *_Atomic startup_backend = NULL;
+static _Atomic bool startup_model_failed = false;
+static struct spa_source *model_startup_event = NULL;
+static bool startup_failed = false;
+
+// Temporal decision engine: one event per burst of positive windows instead of one alert per window
+enum decision_result {
+    DECISION_NONE = 0,
+    DECISION_EVENT_START,
+    DECISION_EVENT_END
+};
+
+struct decision_state {
+    float smoothed;          // EMA of the gunshot probability
+    uint32_t votes;          // Per-window threshold votes, bit 0 is the newest window
+    bool active;             // Inside an event
+    uint64_t run_start_ms;   // Audio start of the first positive window of the current run
+    uint64_t start_ms;
+    uint64_t end_ms;         // End of the last window at or above the release threshold
+    uint64_t peak_ms;
+    float peak;
+    float peak_rms;
+    uint32_t windows;
+};
+
+static struct decision_state decision;
+static uint32_t event_count = 0;          // Event id source, shared by all heads
+static uint32_t gunshot_event_count = 0;  // Events opened by the gunshot model, for the stats block
+
+// Extra classifier heads (glass break, scream, ...): window models fed the mel features already computed
+// for the gunshot model, each with its own threshold, decision engine and alert routing. The set is
+// loaded on a background thread and swapped in at a window boundary like a reloaded model
+struct classifier_head {
+    char label[HEAD_LABEL_MAX];
+    float threshold;
+    uint32_t routes;             // EVENT_ROUTE_* bits
+    struct model_backend *backend;
+    struct decision_state decision;
+    uint64_t inferences;
+    uint64_t events;
+    float last_confidence;
+};
+
+struct head_set {
+    char spec[1024];             // extra_models value the set was loaded from
+    size_t count;
+    struct classifier_head heads[MAX_EXTRA_HEADS];
+};
+
+static char extra_models[1024] = "";                  // "label path[ threshold=N][ alerts=a+b], ..."
+static struct head_set *active_heads = NULL;          // Owned by the audio thread
+static struct head_set *_Atomic staged_heads = NULL;
+static _Atomic bool heads_loading = false;
+static char heads_attempt_spec[1024] = "";
+static volatile sig_atomic_t heads_reload_requested = 0;
+
+// Detection event bus: the analysis thread publishes fixed-size events into a broadcast ring without
+// waiting; each sink thread follows the ring at its own pace and counts the events it was lapped on
+#define EVENT_BUS_SLOTS 64  // Power of two
+#define MAX_EVENT_SINKS 8
+
+enum detection_event_kind {
+    DETECTION_EVENT_OPENED = 0,
+    DETECTION_EVENT_CLOSED
+};
+
+// Alert routing, a bit per sink: gunshot events go everywhere, an extra head's events where configured
+enum event_route {
+    EVENT_ROUTE_JOURNAL = 1u << 0,
+    EVENT_ROUTE_EMAIL = 1u << 1,
+    EVENT_ROUTE_WEBHOOK = 1u << 2,
+    EVENT_ROUTE_MQTT = 1u << 3,
+    EVENT_ROUTE_ALL = 0xfu
+};
+
+struct detection_event {
+    enum detection_event_kind kind;
+    uint32_t id;
+    char label[HEAD_LABEL_MAX];  // PRIMARY_LABEL or the extra head's label
+    uint32_t routes;             // Sinks that handle the event
+    uint64_t time_ms;        // Unix time of publication
+    uint64_t start_ms;
+    uint64_t end_ms;
+    uint64_t peak_ms;
+    float confidence;        // Window that opened the event
+    float rms;
+    float peak;
+    float peak_rms;
+    uint32_t windows;
+    float threshold;         // Decision settings the event was opened under
+    int vote_k;
+    int vote_n;
+    enum gunshot_load_level load_level;
+};
+
+struct event_bus_slot {
+    _Atomic uint64_t sequence;  // 2 * position + 1 while being written, 2 * position + 2 once published
+    struct detection_event event;
+};
+
+enum sink_result {
+    SINK_DELIVERED = 0,
+    SINK_SKIPPED,            // Not for this sink (disabled, wrong event kind)
+    SINK_COALESCED,          // Held back to go out with others (email digest)
+    SINK_FAILED,             // Worth retrying: spooled for the destinations still owed the event
+    SINK_REJECTED            // Refused for good (HTTP 4xx), not spooled
+};
+
+#define SINK_TARGETS_ALL 0xffffffffu  // Every destination of a sink is owed the event
+
+// Alert spool: events a network sink fails to deliver are appended to its spool file and retried with
+// exponential backoff from the sink's thread, including after a restart
+#ifndef SPOOL_DIR
+#define SPOOL_DIR "/usr/local/packages/gunshot_detector/localdata"
+#endif
+#define SPOOL_MAGIC 0x53415347u         // "GSAS"
+#define SPOOL_MAX_PENDING 256
+#define SPOOL_COMPACT_RECORDS 1024      // Rewrite the file once it holds this many records
+#define SPOOL_RETRY_MIN_MS 5000
+#define SPOOL_RETRY_MAX_MS 600000
+
+enum spool_record_kind {
+    SPOOL_PENDING = 1,
+    SPOOL_DONE                  // Retires the pending record with the same sequence
+};
+
+struct spool_record {
+    uint32_t magic;
+    uint32_t kind;
+    uint64_t sequence;
+    struct detection_event event;
+    uint32_t targets;        // Destinations still owed the event; a later pending record narrows them
+    uint32_t checksum;
+};
+
+struct spool_entry {
+    uint64_t sequence;
+    struct detection_event event;
+    uint32_t targets;        // Bit per sink destination (webhook endpoint) still owed the event
+    bool held;               // Coalesced by the sink; retired once the sink no longer holds it
+};
+
+struct event_sink {
+    const char *name;
+    uint32_t route;          // EVENT_ROUTE_* bit; events not routed here are skipped
+    // Runs on the sink's own thread. *targets holds the destinations owed the event (SINK_TARGETS_ALL
+    // when it is new); on SINK_FAILED the sink leaves in it those that should be retried
+    enum sink_result (*deliver)(const struct detection_event *e, uint32_t *targets);
+    int (*poll)(void);       // Optional periodic work between events, returns ms until it wants to run again (-1: idle)
+    void (*cleanup)(void);   // Optional, runs on the sink's thread before it exits
+    bool (*holding)(void);   // Optional, whether coalesced events are still waiting to go out
+    pthread_t thread;
+    bool started;
+    sem_t wake;
+    uint64_t cursor;         // Next bus position to read, owned by the sink thread
+    _Atomic uint64_t delivered;
+    _Atomic uint64_t skipped;
+    _Atomic uint64_t coalesced;
+    _Atomic uint64_t failed;
+    _Atomic uint64_t dropped;  // Overwritten before the sink got to them, or given up on by the spool
+    
+    // Spool, owned by the sink thread
+    bool spooled;            // Failed deliveries are spooled and retried
+    int spool_fd;            // -1 when not spooling
+    struct spool_entry spool[SPOOL_MAX_PENDING];  // Ring, oldest at spool_head
+    size_t spool_head;
+    size_t spool_count;
+    uint64_t spool_sequence;
+    uint64_t spool_records;  // Records in the file, pending and retired
+    uint64_t spool_retry_at_us;
+    uint32_t spool_backoff_ms;
+    _Atomic uint64_t spool_added;
+    _Atomic size_t spool_pending;
+};
+
+static struct event_bus_slot event_bus[EVENT_BUS_SLOTS];
+static _Atomic uint64_t event_bus_head = 0;
+static _Atomic bool event_bus_running = false;
+static struct event_sink *event_sinks[MAX_EVENT_SINKS];
+static size_t event_sink_count = 0;
+static pthread_mutex_t alert_config_lock = PTHREAD_MUTEX_INITIALIZER;  // Sinks read alert settings off-thread
+
+// Live stats block (POSIX shared memory, falls back to process-local memory)
+static struct gunshot_stats local_stats;
+static struct gunshot_stats *stats = &local_stats;
+static bool stats_shm_mapped = false;
+static uint32_t capture_rate = SAMPLE_RATE;
+
+// Latency histograms exported on the metrics endpoint (bounds in microseconds)
+#define LATENCY_BUCKETS 13
+static const uint64_t latency_bucket_bounds_us[LATENCY_BUCKETS] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 10000000, 30000000
+};
+
+struct latency_histogram {
+    _Atomic uint64_t buckets[LATENCY_BUCKETS + 1];  // Last bucket is +Inf
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_us;
+};
+
+static struct latency_histogram inference_latency_hist;
+static struct latency_histogram alert_send_latency_hist;
+static struct latency_histogram detection_latency_hist;
+static float *replay_latencies = NULL;   // Set by --replay to collect each event's latency
+static size_t replay_latency_count = 0;
+static size_t replay_latency_cap = 0;
+static _Atomic uint32_t alerts_pending = 0;
+
+// Capture conversion chain: format convert -> downmix -> resample to TARGET_SAMPLE_RATE mono
+#define CHAIN_BLOCK_FRAMES 1024
+#define RESAMPLER_TAPS 16
+#define RESAMPLER_MAX_PHASES 512
+
+typedef void (*convert_fn)(const void *src, uint32_t frames, uint32_t channels, float *dst);
+
+struct conversion_chain {
+    bool bound;
+    enum spa_audio_format format;
+    uint32_t rate;
+    uint32_t channels;
+    size_t frame_bytes;
+    convert_fn convert;     // NULL: native format, mono, target rate -> straight copy
+    bool resample;
+    uint32_t up;            // Rational resampling ratio TARGET_SAMPLE_RATE / rate = up / down
+    uint32_t down;
+    uint64_t position;      // Next output position in units of 1/up input samples
+    float history[RESAMPLER_TAPS - 1];
+    float coeffs[RESAMPLER_MAX_PHASES * RESAMPLER_TAPS];
+};
+
+static struct conversion_chain capture_chain;
+static float chain_scratch[RESAMPLER_TAPS - 1 + CHAIN_BLOCK_FRAMES];
+static float chain_resampled[CHAIN_BLOCK_FRAMES * 2 + 2];
+
 // Stream data (based on official audiocapture.c structure)
 struct stream_data {
     struct pw_stream *stream;
@@ -122,6 +619,9 @@ struct stream_data {
     char name[64];
     float peak[SPA_AUDIO_MAX_CHANNELS];
     bool is_target_stream;
+    uint32_t node_id;        // Registry id, PW_ID_ANY until the registry announces the node
+    bool warm_start;         // Connected from the node cache before discovery
+    bool streaming;
 };
 
 // PipeWire globals (from official example)
@@ -131,6 +631,49 @@ struct pw_core *core;
 struct pw_registry *registry;
 struct spa_hook registry_listener;
 
+// Audio sources: PipeWire capture on the camera, or a synthetic driver that feeds the same capture path
+// without a PipeWire graph (--synthetic) for load tests on a build machine
+struct audio_source {
+    const char *name;
+    bool (*start)(void);
+    void (*stop)(void);
+};
+
+struct synthetic_config {
+    uint32_t rate;
+    uint32_t channels;
+    enum spa_audio_format format;
+    uint32_t quantum;            // Frames per buffer
+    float jitter;                // Maximum late delivery, as a fraction of a buffer period
+    float noise_dbfs;            // Background noise RMS
+    float impulse_dbfs;          // Peak of injected impulses
+    float impulse_interval_s;    // Audio time between impulses, 0 = none
+    float speed;                 // Multiple of real time, 0 = as fast as analysis allows
+    float duration_s;            // Audio time to deliver, 0 = until stopped
+};
+
+static struct synthetic_config synthetic = {
+    48000, 2, SPA_AUDIO_FORMAT_S16, 1024, 0.0f, -50.0f, -6.0f, 5.0f, 1.0f, 0.0f
+};
+static float source_speed = 1.0f;  // Audio seconds per wall-clock second, scales real-time factor and lag
+
+// Capture streams by node, so warm-started streams aren't duplicated and removed nodes can be dropped
+#define MAX_CAPTURE_STREAMS 8
+static struct stream_data *capture_streams[MAX_CAPTURE_STREAMS];
+
+// Warm start: last target node and negotiated format, connected before registry discovery finishes
+#define NODE_CACHE_PATH "/usr/local/packages/gunshot_detector/localdata/audio_node.cache"
+#define WARM_START_TIMEOUT_MS 3000
+
+struct node_cache {
+    bool valid;
+    char node[64];
+    struct spa_audio_info_raw format;
+};
+
+static struct node_cache node_cache;
+static struct spa_source *warm_start_timer = NULL;
+
 /**
  * Check for parameter files in various locations
  */
@@ -177,16 +720,18 @@ static void load_config(void) {
         return;
     }
     
-    char line[256];
+    char line[1280];  // Long enough for webhook_urls
     syslog(LOG_INFO, "[CONFIG] Reading Axis parameter file...");
     
+    // Alert sinks copy their settings under the same lock
+    pthread_mutex_lock(&alert_config_lock);
     while (fgets(line, sizeof(line), config_file)) {
         // Remove newline
         line[strcspn(line, "\n")] = 0;
         syslog(LOG_INFO, "[CONFIG] Line: %s", line);
         
         // Parse threshold parameter (format: threshold="35")
-        if (strstr(line, "threshold=")) {
+        if (strncmp(line, "threshold=", 10) == 0) {
             int threshold_int = 0;
             syslog(LOG_INFO, "[CONFIG] Found threshold line, attempting to parse...");
             syslog(LOG_INFO, "[CONFIG] Trying to parse line: '%s' with format: 'threshold=\"%%d\"'", line);
@@ -198,6 +743,7 @@ static void load_config(void) {
                 if (threshold >= 0.30f && threshold <= 0.70f) {
                     float old_threshold = confidence_threshold;
                     confidence_threshold = threshold;
+                    threshold_generation++;
                     syslog(LOG_INFO, "[CONFIG] ✅ Updated threshold: %.0f%% -> %.0f%%", 
                            old_threshold * 100.0f, confidence_threshold * 100.0f);
                 } else {
@@ -209,6 +755,92 @@ static void load_config(void) {
             }
         }
         
+        // Parse cascade_threshold parameter (format: cascade_threshold="10", 0 disables the screen)
+        if (strstr(line, "cascade_threshold=")) {
+            int cascade_int = 0;
+            if (sscanf(line, "cascade_threshold=\"%d\"", &cascade_int) == 1 && cascade_int >= 0 && cascade_int <= 50) {
+                cascade_threshold = cascade_int / 100.0f;
+                syslog(LOG_INFO, "[CONFIG] Cascade screen threshold: %d%%%s", cascade_int,
+                       cascade_int == 0 ? " (screen disabled)" : "");
+            } else {
+                syslog(LOG_WARNING, "[CONFIG] ❌ Invalid cascade_threshold, keeping %.0f%%", cascade_threshold * 100.0f);
+            }
+        }
+        
+        // Parse decision engine parameters (format: vote_k="2", vote_n="3", release_margin="5")
+        if (strstr(line, "vote_k=")) {
+            int k = 0;
+            if (sscanf(line, "vote_k=\"%d\"", &k) == 1 && k >= 1 && k <= MAX_VOTE_WINDOWS) {
+                vote_k = k;
+            }
+        }
+        if (strstr(line, "vote_n=")) {
+            int n = 0;
+            if (sscanf(line, "vote_n=\"%d\"", &n) == 1 && n >= 1 && n <= MAX_VOTE_WINDOWS) {
+                vote_n = n;
+            }
+        }
+        if (strstr(line, "release_margin=")) {
+            int margin = 0;
+            if (sscanf(line, "release_margin=\"%d\"", &margin) == 1 && margin >= 0 && margin <= 30) {
+                release_margin = margin;
+            }
+        }
+        if (strstr(line, "window_stride_ms=")) {
+            int stride_ms = 0;
+            if (sscanf(line, "window_stride_ms=\"%d\"", &stride_ms) == 1 && stride_ms >= 0) {
+                window_stride_ms = stride_ms;
+                syslog(LOG_INFO, "[CONFIG] Window stride: %d ms%s", stride_ms, stride_ms ? "" : " (no overlap)");
+            }
+        }
+        
+        if (strstr(line, "onset_trigger=")) {
+            char onset_str[16];
+            if (sscanf(line, "onset_trigger=\"%15[^\"]\"", onset_str) == 1) {
+                onset_trigger = (strcmp(onset_str, "yes") == 0);
+                syslog(LOG_INFO, "[CONFIG] Onset-triggered windows: %s", onset_trigger ? "yes" : "no");
+            }
+        }
+        
+        if (strstr(line, "confirm_margin=")) {
+            int margin = 0;
+            if (sscanf(line, "confirm_margin=\"%d\"", &margin) == 1 && margin >= 0 && margin <= 20) {
+                confirm_margin = margin;
+                syslog(LOG_INFO, "[CONFIG] Confirmation band: threshold +/- %d%%%s", margin, margin ? "" : " (off)");
+            }
+        }
+        
+        // Parse real-time parameters (format: realtime_mode="yes", realtime_priority="10", realtime_cpu="-1")
+        if (strstr(line, "realtime_mode=")) {
+            char mode_str[16];
+            if (sscanf(line, "realtime_mode=\"%15[^\"]\"", mode_str) == 1) {
+                realtime_mode = (strcmp(mode_str, "yes") == 0);
+                syslog(LOG_INFO, "[CONFIG] Real-time mode: %s%s", realtime_mode ? "yes" : "no",
+                       realtime_mode != realtime_active && realtime_active ? " (takes effect after restart)" : "");
+            }
+        }
+        if (strstr(line, "realtime_priority=")) {
+            int priority = 0;
+            if (sscanf(line, "realtime_priority=\"%d\"", &priority) == 1 && priority >= 1 && priority <= 99) {
+                realtime_priority = priority;
+            }
+        }
+        if (strstr(line, "realtime_cpu=")) {
+            int cpu = 0;
+            if (sscanf(line, "realtime_cpu=\"%d\"", &cpu) == 1 && cpu >= -1 && cpu < CPU_SETSIZE) {
+                realtime_cpu = cpu;
+            }
+        }
+
+        // Parse load_shedding parameter (format: load_shedding="yes")
+        if (strstr(line, "load_shedding=")) {
+            char shed_str[16];
+            if (sscanf(line, "load_shedding=\"%15[^\"]\"", shed_str) == 1) {
+                load_shedding = (strcmp(shed_str, "yes") == 0);
+                syslog(LOG_INFO, "[CONFIG] Load shedding: %s", load_shedding ? "yes" : "no");
+            }
+        }
+
         // Parse email_enabled parameter (format: email_enabled="yes")
         if (strstr(line, "email_enabled=")) {
             char enabled_str[16];
@@ -218,6 +850,22 @@ static void load_config(void) {
             }
         }
         
+        // Parse attachment parameters (format: email_attach_clip="yes", email_attach_spectrogram="yes")
+        if (strstr(line, "email_attach_clip=")) {
+            char attach_str[16];
+            if (sscanf(line, "email_attach_clip=\"%15[^\"]\"", attach_str) == 1) {
+                email_attach_clip = (strcmp(attach_str, "yes") == 0);
+                syslog(LOG_INFO, "[CONFIG] Email clip attachment: %s", email_attach_clip ? "yes" : "no");
+            }
+        }
+        if (strstr(line, "email_attach_spectrogram=")) {
+            char attach_str[16];
+            if (sscanf(line, "email_attach_spectrogram=\"%15[^\"]\"", attach_str) == 1) {
+                email_attach_spectrogram = (strcmp(attach_str, "yes") == 0);
+                syslog(LOG_INFO, "[CONFIG] Email spectrogram attachment: %s", email_attach_spectrogram ? "yes" : "no");
+            }
+        }
+        
         // Parse smtp_server parameter
         if (strstr(line, "smtp_server=")) {
             if (sscanf(line, "smtp_server=\"%255[^\"]\"", smtp_server) == 1) {
@@ -246,6 +894,92 @@ static void load_config(void) {
             }
         }
         
+        // Parse metrics_endpoint parameter (applied at startup)
+        if (strstr(line, "metrics_endpoint=")) {
+            if (sscanf(line, "metrics_endpoint=\"%255[^\"]\"", metrics_endpoint) == 1) {
+                syslog(LOG_INFO, "[CONFIG] Metrics endpoint: %s", metrics_endpoint);
+            } else {
+                metrics_endpoint[0] = '\0';
+            }
+        }
+        
+        // Parse model_path parameter (empty means the bundled model)
+        if (strstr(line, "model_path=")) {
+            char path[256];
+            if (sscanf(line, "model_path=\"%255[^\"]\"", path) == 1) {
+                snprintf(model_path, sizeof(model_path), "%s", path);
+            } else {
+                snprintf(model_path, sizeof(model_path), "%s", DEFAULT_MODEL_PATH);
+            }
+            syslog(LOG_INFO, "[CONFIG] Model path: %s", model_path);
+        }
+        
+        // Parse extra heads (format: extra_models="glass_break /path/glass.tflite threshold=60 alerts=email, ...")
+        if (strstr(line, "extra_models=")) {
+            if (sscanf(line, "extra_models=\"%1023[^\"]\"", extra_models) == 1) {
+                syslog(LOG_INFO, "[CONFIG] Extra models: %s", extra_models);
+            } else {
+                extra_models[0] = '\0';
+            }
+        }
+        
+        // Parse webhook parameters (format: webhook_urls="http://vms/hook timeout_ms=500, https://...")
+        if (strstr(line, "webhook_urls=")) {
+            if (sscanf(line, "webhook_urls=\"%1023[^\"]\"", webhook_urls) == 1) {
+                syslog(LOG_INFO, "[CONFIG] Webhooks: %s", webhook_urls);
+            } else {
+                webhook_urls[0] = '\0';
+            }
+        }
+        if (strstr(line, "webhook_timeout_ms=")) {
+            int timeout_ms = 0;
+            if (sscanf(line, "webhook_timeout_ms=\"%d\"", &timeout_ms) == 1 && timeout_ms >= 100 && timeout_ms <= 60000) {
+                webhook_timeout_ms = timeout_ms;
+            }
+        }
+        if (strstr(line, "webhook_retries=")) {
+            int retries = 0;
+            if (sscanf(line, "webhook_retries=\"%d\"", &retries) == 1 && retries >= 0 && retries <= 10) {
+                webhook_retries = retries;
+            }
+        }
+        
+        // Parse MQTT parameters (format: mqtt_broker="10.0.0.5:1883", mqtt_qos="1")
+        if (strstr(line, "mqtt_broker=")) {
+            if (sscanf(line, "mqtt_broker=\"%255[^\"]\"", mqtt_broker) == 1) {
+                syslog(LOG_INFO, "[CONFIG] MQTT broker: %s", mqtt_broker);
+            } else {
+                mqtt_broker[0] = '\0';
+            }
+        }
+        if (strstr(line, "mqtt_topic=")) {
+            if (sscanf(line, "mqtt_topic=\"%127[^\"]\"", mqtt_topic) != 1) {
+                snprintf(mqtt_topic, sizeof(mqtt_topic), "axis/gunshot");
+            }
+        }
+        if (strstr(line, "mqtt_qos=")) {
+            int qos = 0;
+            if (sscanf(line, "mqtt_qos=\"%d\"", &qos) == 1 && qos >= 0 && qos <= 1) {
+                mqtt_qos = qos;
+            }
+        }
+        if (strstr(line, "mqtt_username=")) {
+            if (sscanf(line, "mqtt_username=\"%127[^\"]\"", mqtt_username) != 1) {
+                mqtt_username[0] = '\0';
+            }
+        }
+        if (strstr(line, "mqtt_password=")) {
+            if (sscanf(line, "mqtt_password=\"%127[^\"]\"", mqtt_password) != 1) {
+                mqtt_password[0] = '\0';
+            }
+        }
+        if (strstr(line, "mqtt_heartbeat_s=")) {
+            int heartbeat_s = 0;
+            if (sscanf(line, "mqtt_heartbeat_s=\"%d\"", &heartbeat_s) == 1 && heartbeat_s >= 0 && heartbeat_s <= 3600) {
+                mqtt_heartbeat_s = heartbeat_s;
+            }
+        }
+        
         // Parse recipient_email parameter
         if (strstr(line, "recipient_email=")) {
             if (sscanf(line, "recipient_email=\"%255[^\"]\"", recipient_email) == 1) {
@@ -253,8 +987,16 @@ static void load_config(void) {
             }
         }
     }
+    pthread_mutex_unlock(&alert_config_lock);
     
     fclose(config_file);
+    
+    if (vote_k > vote_n) {
+        syslog(LOG_WARNING, "[CONFIG] ❌ vote_k %d > vote_n %d, using %d-of-%d", vote_k, vote_n, vote_n, vote_n);
+        vote_k = vote_n;
+    }
+    syslog(LOG_INFO, "[CONFIG] Decision: %d of %d windows, release %d%% below threshold",
+           vote_k, vote_n, release_margin);
 }
 
 /**
@@ -281,6 +1023,7 @@ static void on_parameter_changed(GDBusConnection *connection,
         if (threshold_int >= 30 && threshold_int <= 70) {
             float old_threshold = confidence_threshold;
             confidence_threshold = threshold_int / 100.0f;
+            threshold_generation++;
             syslog(LOG_INFO, "[DBUS] ✅ Real-time threshold update: %.0f%% -> %.0f%%", 
                    old_threshold * 100.0f, confidence_threshold * 100.0f);
         }
@@ -330,107 +1073,790 @@ static void setup_config_monitoring(void) {
 }
 
 /**
- * Email payload structure for libcurl
+ * Monotonic clock in microseconds
  */
-struct email_upload_status {
-    char *data;
-    size_t length;
-    size_t position;
-};
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
 
 /**
- * Callback for libcurl to read email data
+ * Deterministic pseudo-random sequence for test signals
  */
-static size_t email_payload_source(void *ptr, size_t size, size_t nmemb, void *userp) {
-    struct email_upload_status *upload_ctx = (struct email_upload_status *)userp;
-    const char *data = upload_ctx->data;
-    size_t room = size * nmemb;
-    
-    if (upload_ctx->position >= upload_ctx->length) {
-        return 0;  // No more data
+static uint32_t xorshift32(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/**
+ * Uniform noise in [-1, 1)
+ */
+static float uniform_noise(uint32_t *state) {
+    return (xorshift32(state) >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+/**
+ * Log a startup milestone relative to main() until the first window has been analysed
+ */
+static void startup_mark(const char *milestone) {
+    if (!startup_complete) {
+        syslog(LOG_INFO, "[STARTUP] +%llu ms %s",
+               (unsigned long long)((monotonic_us() - startup_begin_us) / 1000), milestone);
     }
-    
-    size_t remaining = upload_ctx->length - upload_ctx->position;
-    size_t len = (remaining < room) ? remaining : room;
-    
-    memcpy(ptr, data + upload_ctx->position, len);
-    upload_ctx->position += len;
-    
-    return len;
 }
 
 /**
- * Send email notification for gunshot detection
+ * Wall clock in milliseconds (for the stats block timestamp)
  */
-static bool send_email_notification(float confidence, float rms) {
-    if (!email_enabled || strlen(smtp_username) == 0 || strlen(recipient_email) == 0) {
-        return false;
+static uint64_t unix_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/**
+ * Wall-clock time of a stream position
+ */
+static uint64_t stream_time_ms(uint64_t position) {
+    return stream_anchor_ms + position * 1000u / TARGET_SAMPLE_RATE;
+}
+
+/**
+ * Create the shared-memory stats block read by gunshot_stats_reader
+ */
+static void init_stats_shm(void) {
+    int fd = shm_open(GUNSHOT_STATS_SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        syslog(LOG_WARNING, "[STATS] shm_open %s failed: %s - stats stay process-local",
+               GUNSHOT_STATS_SHM_NAME, strerror(errno));
+    } else if (ftruncate(fd, sizeof(struct gunshot_stats)) != 0) {
+        syslog(LOG_WARNING, "[STATS] Failed to size stats block: %s", strerror(errno));
+    } else {
+        void *addr = mmap(NULL, sizeof(struct gunshot_stats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            syslog(LOG_WARNING, "[STATS] Failed to mmap stats block: %s", strerror(errno));
+        } else {
+            stats = addr;
+            stats_shm_mapped = true;
+        }
     }
-    
-    // Rate limiting - only send one email every 2 minutes
-    time_t current_time = time(NULL);
-    if (current_time - last_email_time < EMAIL_RATE_LIMIT_SECONDS) {
-        syslog(LOG_DEBUG, "[EMAIL] Rate limited - last email sent %ld seconds ago", 
-               current_time - last_email_time);
-        return false;
+    if (fd >= 0) {
+        close(fd);
     }
-    
-    CURL *curl;
-    CURLcode res = CURLE_OK;
-    struct curl_slist *recipients = NULL;
-    struct email_upload_status upload_ctx;
-    
-    // Build email content
-    char email_body[2048];
-    char timestamp[64];
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-    
-    snprintf(email_body, sizeof(email_body),
-        "To: %s\r\n"
-        "From: %s\r\n"
-        "Subject: 🔫 Gunshot Detected - Security Alert\r\n"
-        "\r\n"
-        "GUNSHOT DETECTION ALERT\r\n"
-        "========================\r\n"
-        "\r\n"
-        "Time: %s\r\n"
-        "Confidence: %.1f%%\r\n"
-        "Audio RMS: %.3f\r\n"
-        "Camera: Axis Gunshot Detector\r\n"
-        "\r\n"
-        "This is an automated security notification.\r\n"
-        "Please investigate immediately.\r\n"
-        "\r\n"
-        "-- Axis Gunshot Detection System\r\n",
-        recipient_email, smtp_username, timestamp, confidence, rms);
-    
-    upload_ctx.data = email_body;
-    upload_ctx.length = strlen(email_body);
-    upload_ctx.position = 0;
-    
-    curl = curl_easy_init();
-    if (!curl) {
-        syslog(LOG_ERR, "[EMAIL] Failed to initialize curl");
-        return false;
+
+    // A previous instance may have died mid-update, so force the sequence odd while resetting
+    atomic_store_explicit(&stats->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    stats->magic = GUNSHOT_STATS_MAGIC;
+    stats->version = GUNSHOT_STATS_VERSION;
+    stats->pid = (uint32_t)getpid();
+    stats->started_unix = (uint64_t)time(NULL);
+    stats->updated_unix_ms = unix_ms();
+    stats->inference_count = 0;
+    stats->detection_count = 0;
+    stats->windows_gated = 0;
+    stats->windows_screened_out = 0;
+    stats->buffers_dropped = 0;
+    stats->events_count = 0;
+    stats->event_active = 0;
+    stats->window_minor_faults = 0;
+    stats->window_major_faults = 0;
+    stats->window_involuntary_switches = 0;
+    stats->last_confidence = 0.0f;
+    stats->smoothed_confidence = 0.0f;
+    stats->threshold = confidence_threshold * 100.0f;
+    stats->real_time_factor = 0.0f;
+    stats->ring_lag_ms = 0.0f;
+    stats->load_level = GUNSHOT_LOAD_FULL;
+    stats->load_sheds = 0;
+    stats->load_restores = 0;
+    memset(stats->windows_by_load_level, 0, sizeof(stats->windows_by_load_level));
+    stats->capture_rate = capture_rate;
+    memset(stats->stages, 0, sizeof(stats->stages));
+    atomic_store_explicit(&stats->seq, 2, memory_order_release);
+
+    if (stats_shm_mapped) {
+        syslog(LOG_INFO, "[STATS] Shared-memory stats block at /dev/shm%s (%zu bytes)",
+               GUNSHOT_STATS_SHM_NAME, sizeof(struct gunshot_stats));
     }
-    
-    // Build SMTP URL - use smtp:// for port 587 (STARTTLS) or smtps:// for port 465 (SSL)
-    char smtp_url[512];
-    if (smtp_port == 465) {
-        snprintf(smtp_url, sizeof(smtp_url), "smtps://%s:%d", smtp_server, smtp_port);
-    } else {
-        snprintf(smtp_url, sizeof(smtp_url), "smtp://%s:%d", smtp_server, smtp_port);
+}
+
+/**
+ * Remove the shared-memory stats block on shutdown
+ */
+static void cleanup_stats_shm(void) {
+    if (!stats_shm_mapped) {
+        return;
     }
-    
-    syslog(LOG_INFO, "[EMAIL] Connecting to %s", smtp_url);
+    munmap(stats, sizeof(struct gunshot_stats));
+    shm_unlink(GUNSHOT_STATS_SHM_NAME);
+    stats = &local_stats;
+    stats_shm_mapped = false;
+}
+
+/**
+ * Fold one latency sample into a stage summary (call inside a write section)
+ */
+static void stats_record_latency(enum gunshot_stage stage, uint64_t elapsed_us) {
+    struct gunshot_latency_summary *summary = &stats->stages[stage];
+    float us = (float)elapsed_us;
+
+    if (summary->count == 0) {
+        summary->mean_us = us;
+        summary->min_us = us;
+        summary->max_us = us;
+    } else {
+        summary->mean_us += (us - summary->mean_us) / 16.0f;
+        if (us < summary->min_us) summary->min_us = us;
+        if (us > summary->max_us) summary->max_us = us;
+    }
+    summary->last_us = us;
+    summary->count++;
+}
+
+/**
+ * Count a capture buffer that could not be analysed
+ */
+static void stats_buffer_dropped(void) {
+    gunshot_stats_write_begin(stats);
+    stats->buffers_dropped++;
+    stats->updated_unix_ms = unix_ms();
+    gunshot_stats_write_end(stats);
+}
+
+/**
+ * Record one latency sample in a histogram (safe from any thread)
+ */
+static void histogram_observe(struct latency_histogram *h, uint64_t elapsed_us) {
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS && elapsed_us > latency_bucket_bounds_us[bucket]) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&h->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_us, elapsed_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+}
+
+// Metrics endpoint connections (serviced from the PipeWire main loop)
+#define METRICS_MAX_CLIENTS 4
+#define METRICS_REQUEST_SIZE 1024
+#define METRICS_BODY_SIZE 16384
+
+struct metrics_client {
+    bool in_use;
+    bool writing;
+    struct spa_source *source;
+    char request[METRICS_REQUEST_SIZE];
+    size_t request_len;
+    char header[256];
+    size_t header_len;
+    char body[METRICS_BODY_SIZE];  // Reused across scrapes, never allocated
+    size_t body_len;
+    size_t sent;
+};
+
+struct metrics_writer {
+    char *buf;
+    size_t cap;
+    size_t len;
+};
+
+static struct metrics_client metrics_clients[METRICS_MAX_CLIENTS];
+static struct spa_source *metrics_listen_source = NULL;
+static bool metrics_unix_socket = false;
+
+/**
+ * Append formatted text to the metrics buffer (truncates when full)
+ */
+__attribute__((format(printf, 2, 3)))
+static void metrics_append(struct metrics_writer *w, const char *fmt, ...) {
+    if (w->len >= w->cap) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(w->buf + w->len, w->cap - w->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        w->len += (size_t)n < w->cap - w->len ? (size_t)n : w->cap - w->len - 1;
+    }
+}
+
+static void metrics_counter(struct metrics_writer *w, const char *name, const char *help, uint64_t value) {
+    metrics_append(w, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                   name, help, name, name, (unsigned long long)value);
+}
+
+static void metrics_gauge(struct metrics_writer *w, const char *name, const char *help, double value) {
+    metrics_append(w, "# HELP %s %s\n# TYPE %s gauge\n%s %g\n", name, help, name, name, value);
+}
+
+static void metrics_histogram(struct metrics_writer *w, const char *name, const char *help,
+                              struct latency_histogram *h) {
+    metrics_append(w, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    uint64_t cumulative = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        cumulative += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        metrics_append(w, "%s_bucket{le=\"%g\"} %llu\n", name,
+                       latency_bucket_bounds_us[i] / 1e6, (unsigned long long)cumulative);
+    }
+    cumulative += atomic_load_explicit(&h->buckets[LATENCY_BUCKETS], memory_order_relaxed);
+    metrics_append(w, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)cumulative);
+    metrics_append(w, "%s_sum %g\n%s_count %llu\n",
+                   name, atomic_load_explicit(&h->sum_us, memory_order_relaxed) / 1e6,
+                   name, (unsigned long long)cumulative);
+}
+
+/**
+ * Render all metrics in Prometheus text format into the client's buffer
+ */
+static size_t render_metrics(char *buf, size_t cap) {
+    struct metrics_writer w = { buf, cap, 0 };
+    struct gunshot_stats snap;
+    if (!gunshot_stats_read(stats, &snap)) {
+        memset(&snap, 0, sizeof(snap));
+    }
+
+    uint64_t windows = snap.inference_count + snap.windows_screened_out + snap.windows_gated;
+
+    metrics_counter(&w, "gunshot_inferences_total", "Model inferences run", snap.inference_count);
+    metrics_counter(&w, "gunshot_detections_total", "Windows above the detection threshold", snap.detection_count);
+    metrics_append(&w, "# HELP gunshot_windows_total Analysis windows by gate result\n"
+                       "# TYPE gunshot_windows_total counter\n"
+                       "gunshot_windows_total{result=\"passed\"} %llu\n"
+                       "gunshot_windows_total{result=\"screened\"} %llu\n"
+                       "gunshot_windows_total{result=\"gated\"} %llu\n",
+                   (unsigned long long)snap.inference_count, (unsigned long long)snap.windows_screened_out,
+                   (unsigned long long)snap.windows_gated);
+    metrics_gauge(&w, "gunshot_gate_pass_ratio", "Fraction of windows that passed the silence gate",
+                  windows ? (double)(windows - snap.windows_gated) / windows : 0.0);
+    metrics_gauge(&w, "gunshot_cascade_pass_ratio", "Fraction of screened windows sent to the full model",
+                  snap.inference_count + snap.windows_screened_out
+                      ? (double)snap.inference_count / (snap.inference_count + snap.windows_screened_out) : 0.0);
+    metrics_counter(&w, "gunshot_buffers_dropped_total", "Capture buffers not analysed", snap.buffers_dropped);
+    metrics_gauge(&w, "gunshot_ring_fill_ratio", "Audio buffer fill level",
+                  (double)(samples_accumulated - window_start) / AUDIO_BUFFER_SIZE);
+    metrics_gauge(&w, "gunshot_alert_queue_depth", "Alerts waiting to be delivered",
+                  atomic_load_explicit(&alerts_pending, memory_order_relaxed));
+    metrics_counter(&w, "gunshot_events_total", "Gunshot detection events after voting and merging", snap.events_count);
+    metrics_append(&w, "# HELP gunshot_sink_events_total Detection events handled per alert sink\n"
+                       "# TYPE gunshot_sink_events_total counter\n");
+    for (size_t i = 0; i < event_sink_count; i++) {
+        const struct event_sink *sink = event_sinks[i];
+        metrics_append(&w, "gunshot_sink_events_total{sink=\"%s\",result=\"delivered\"} %llu\n"
+                           "gunshot_sink_events_total{sink=\"%s\",result=\"skipped\"} %llu\n"
+                           "gunshot_sink_events_total{sink=\"%s\",result=\"coalesced\"} %llu\n"
+                           "gunshot_sink_events_total{sink=\"%s\",result=\"failed\"} %llu\n"
+                           "gunshot_sink_events_total{sink=\"%s\",result=\"dropped\"} %llu\n",
+                       sink->name, (unsigned long long)atomic_load_explicit(&sink->delivered, memory_order_relaxed),
+                       sink->name, (unsigned long long)atomic_load_explicit(&sink->skipped, memory_order_relaxed),
+                       sink->name, (unsigned long long)atomic_load_explicit(&sink->coalesced, memory_order_relaxed),
+                       sink->name, (unsigned long long)atomic_load_explicit(&sink->failed, memory_order_relaxed),
+                       sink->name, (unsigned long long)atomic_load_explicit(&sink->dropped, memory_order_relaxed));
+    }
+    metrics_append(&w, "# HELP gunshot_sink_spooled_total Events spooled for retry after a failed delivery\n"
+                       "# TYPE gunshot_sink_spooled_total counter\n");
+    for (size_t i = 0; i < event_sink_count; i++) {
+        metrics_append(&w, "gunshot_sink_spooled_total{sink=\"%s\"} %llu\n", event_sinks[i]->name,
+                       (unsigned long long)atomic_load_explicit(&event_sinks[i]->spool_added, memory_order_relaxed));
+    }
+    metrics_append(&w, "# HELP gunshot_sink_spool_pending Spooled events waiting for a retry\n"
+                       "# TYPE gunshot_sink_spool_pending gauge\n");
+    for (size_t i = 0; i < event_sink_count; i++) {
+        metrics_append(&w, "gunshot_sink_spool_pending{sink=\"%s\"} %zu\n", event_sinks[i]->name,
+                       atomic_load_explicit(&event_sinks[i]->spool_pending, memory_order_relaxed));
+    }
+    metrics_gauge(&w, "gunshot_event_active", "1 while a detection event is open", snap.event_active);
+    metrics_gauge(&w, "gunshot_last_confidence_ratio", "Confidence of the last inference", snap.last_confidence / 100.0);
+    metrics_gauge(&w, "gunshot_smoothed_confidence_ratio", "Decision engine smoothed confidence",
+                  snap.smoothed_confidence / 100.0);
+    metrics_gauge(&w, "gunshot_threshold_ratio", "Current detection threshold", snap.threshold / 100.0);
+    metrics_gauge(&w, "gunshot_real_time_factor", "Processing time over audio time", snap.real_time_factor);
+    metrics_gauge(&w, "gunshot_ring_lag_seconds", "How far the newest analysed window trails captured audio",
+                  snap.ring_lag_ms / 1000.0);
+    metrics_gauge(&w, "gunshot_load_level", "Load-shedding level, 0 = full quality", snap.load_level);
+    metrics_append(&w, "# HELP gunshot_load_transitions_total Load-shedding steps\n"
+                       "# TYPE gunshot_load_transitions_total counter\n"
+                       "gunshot_load_transitions_total{direction=\"shed\"} %llu\n"
+                       "gunshot_load_transitions_total{direction=\"restore\"} %llu\n",
+                   (unsigned long long)snap.load_sheds, (unsigned long long)snap.load_restores);
+    metrics_append(&w, "# HELP gunshot_windows_by_load_level_total Analysed windows by load-shedding level\n"
+                       "# TYPE gunshot_windows_by_load_level_total counter\n");
+    for (int i = 0; i < GUNSHOT_LOAD_LEVELS; i++) {
+        metrics_append(&w, "gunshot_windows_by_load_level_total{level=\"%s\"} %llu\n",
+                       gunshot_load_level_names[i], (unsigned long long)snap.windows_by_load_level[i]);
+    }
+    metrics_append(&w, "# HELP gunshot_window_page_faults_total Page faults taken while analysing windows\n"
+                       "# TYPE gunshot_window_page_faults_total counter\n"
+                       "gunshot_window_page_faults_total{type=\"minor\"} %llu\n"
+                       "gunshot_window_page_faults_total{type=\"major\"} %llu\n",
+                   (unsigned long long)snap.window_minor_faults, (unsigned long long)snap.window_major_faults);
+    metrics_counter(&w, "gunshot_window_involuntary_switches_total",
+                    "Involuntary context switches while analysing windows", snap.window_involuntary_switches);
+    metrics_counter(&w, "gunshot_model_reloads_total", "Models swapped in without restart",
+                    atomic_load_explicit(&model_reloads, memory_order_relaxed));
+    metrics_counter(&w, "gunshot_model_reload_failures_total", "Model reloads rejected during load or sanity check",
+                    atomic_load_explicit(&model_reload_failures, memory_order_relaxed));
+    metrics_gauge(&w, "gunshot_model_generation", "Generation of the active model",
+                  active_backend ? active_backend->generation : 0);
+    if (active_heads && active_heads->count) {
+        const struct head_set *set = active_heads;
+        metrics_append(&w, "# HELP gunshot_head_inferences_total Inferences run by each extra head\n"
+                           "# TYPE gunshot_head_inferences_total counter\n");
+        for (size_t i = 0; i < set->count; i++) {
+            metrics_append(&w, "gunshot_head_inferences_total{head=\"%s\"} %llu\n", set->heads[i].label,
+                           (unsigned long long)set->heads[i].inferences);
+        }
+        metrics_append(&w, "# HELP gunshot_head_events_total Events opened by each extra head\n"
+                           "# TYPE gunshot_head_events_total counter\n");
+        for (size_t i = 0; i < set->count; i++) {
+            metrics_append(&w, "gunshot_head_events_total{head=\"%s\"} %llu\n", set->heads[i].label,
+                           (unsigned long long)set->heads[i].events);
+        }
+        metrics_append(&w, "# HELP gunshot_head_confidence Last confidence of each extra head\n"
+                           "# TYPE gunshot_head_confidence gauge\n");
+        for (size_t i = 0; i < set->count; i++) {
+            metrics_append(&w, "gunshot_head_confidence{head=\"%s\"} %g\n", set->heads[i].label,
+                           set->heads[i].last_confidence);
+        }
+    }
+    metrics_gauge(&w, "gunshot_startup_first_window_seconds", "Time from process start to the first analysed window",
+                  startup_first_window_ms / 1000.0);
+    metrics_histogram(&w, "gunshot_inference_latency_seconds", "Model inference latency",
+                      &inference_latency_hist);
+    metrics_histogram(&w, "gunshot_alert_send_latency_seconds", "Alert delivery latency",
+                      &alert_send_latency_hist);
+    metrics_counter(&w, "gunshot_confirm_bursts_total", "Ambiguous windows re-run on shifted windows", confirm_bursts);
+    metrics_counter(&w, "gunshot_confirm_inferences_total", "Extra inferences spent on confirmation bursts",
+                    confirm_inferences);
+    metrics_counter(&w, "gunshot_confirm_overturned_total", "Bursts that reversed the single window's vote",
+                    confirm_overturned);
+    metrics_counter(&w, "gunshot_mel_frames_computed_total", "Mel frames computed", mel_frames_computed);
+    metrics_counter(&w, "gunshot_mel_frames_reused_total", "Mel frames taken from the frame ring", mel_frames_reused);
+    metrics_histogram(&w, "gunshot_detection_latency_seconds", "Onset of the impulse to the event decision",
+                      &detection_latency_hist);
+    metrics_append(&w, "# HELP gunshot_stage_latency_mean_seconds Mean latency per pipeline stage\n"
+                       "# TYPE gunshot_stage_latency_mean_seconds gauge\n");
+    for (int i = 0; i < GUNSHOT_STAGE_COUNT; i++) {
+        metrics_append(&w, "gunshot_stage_latency_mean_seconds{stage=\"%s\"} %g\n",
+                       gunshot_stage_names[i], snap.stages[i].mean_us / 1e6);
+    }
+
+    return w.len;
+}
+
+/**
+ * Close a metrics client connection and free its slot
+ */
+static void metrics_client_close(struct metrics_client *client) {
+    if (client->source) {
+        pw_loop_destroy_source(pw_main_loop_get_loop(loop), client->source);  // Also closes the fd
+        client->source = NULL;
+    }
+    client->in_use = false;
+}
+
+/**
+ * Build the HTTP response for a complete request
+ */
+static void metrics_client_respond(struct metrics_client *client) {
+    const char *status = "404 Not Found";
+    client->body_len = 0;
+
+    if (strncmp(client->request, "GET /metrics", 12) == 0 || strncmp(client->request, "GET / ", 6) == 0) {
+        status = "200 OK";
+        client->body_len = render_metrics(client->body, sizeof(client->body));
+    }
+
+    int n = snprintf(client->header, sizeof(client->header),
+                     "HTTP/1.1 %s\r\n"
+                     "Content-Type: text/plain; version=0.0.4\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n"
+                     "\r\n", status, client->body_len);
+    client->header_len = (n > 0 && (size_t)n < sizeof(client->header)) ? (size_t)n : 0;
+    client->sent = 0;
+    client->writing = true;
+}
+
+/**
+ * Write as much of the pending response as the socket accepts
+ */
+static bool metrics_client_flush(struct metrics_client *client, int fd) {
+    size_t total = client->header_len + client->body_len;
+    while (client->sent < total) {
+        struct iovec iov[2];
+        int iovcnt = 0;
+        if (client->sent < client->header_len) {
+            iov[iovcnt].iov_base = client->header + client->sent;
+            iov[iovcnt].iov_len = client->header_len - client->sent;
+            iovcnt++;
+            iov[iovcnt].iov_base = client->body;
+            iov[iovcnt].iov_len = client->body_len;
+            iovcnt++;
+        } else {
+            size_t body_sent = client->sent - client->header_len;
+            iov[iovcnt].iov_base = client->body + body_sent;
+            iov[iovcnt].iov_len = client->body_len - body_sent;
+            iovcnt++;
+        }
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            return errno == EAGAIN;  // Keep waiting for SPA_IO_OUT
+        }
+        client->sent += (size_t)n;
+    }
+    return false;  // Done
+}
+
+/**
+ * Metrics client socket ready
+ */
+static void on_metrics_client_io(void *data, int fd, uint32_t mask) {
+    struct metrics_client *client = data;
+
+    if (mask & (SPA_IO_ERR | SPA_IO_HUP)) {
+        metrics_client_close(client);
+        return;
+    }
+
+    if (!client->writing && (mask & SPA_IO_IN)) {
+        ssize_t n = read(fd, client->request + client->request_len,
+                         sizeof(client->request) - 1 - client->request_len);
+        if (n <= 0) {
+            if (n < 0 && errno == EAGAIN) {
+                return;
+            }
+            metrics_client_close(client);
+            return;
+        }
+        client->request_len += (size_t)n;
+        client->request[client->request_len] = '\0';
+
+        bool complete = strstr(client->request, "\r\n\r\n") || strstr(client->request, "\n\n");
+        if (!complete && client->request_len < sizeof(client->request) - 1) {
+            return;
+        }
+        metrics_client_respond(client);
+    }
+
+    if (client->writing) {
+        if (metrics_client_flush(client, fd)) {
+            pw_loop_update_io(pw_main_loop_get_loop(loop), client->source, SPA_IO_OUT);
+        } else {
+            metrics_client_close(client);
+        }
+    }
+}
+
+/**
+ * Accept a new scrape connection
+ */
+static void on_metrics_accept(void *data, int fd, uint32_t mask) {
+    int client_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        return;
+    }
+
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        struct metrics_client *client = &metrics_clients[i];
+        if (!client->in_use) {
+            client->in_use = true;
+            client->writing = false;
+            client->request_len = 0;
+            client->source = pw_loop_add_io(pw_main_loop_get_loop(loop), client_fd, SPA_IO_IN,
+                                            true, on_metrics_client_io, client);
+            if (!client->source) {
+                close(client_fd);
+                client->in_use = false;
+            }
+            return;
+        }
+    }
+
+    syslog(LOG_DEBUG, "[METRICS] Too many scrape connections, rejecting");
+    close(client_fd);
+}
+
+/**
+ * Open the optional metrics listener on localhost or a Unix socket
+ */
+static void setup_metrics_endpoint(void) {
+    if (metrics_endpoint[0] == '\0') {
+        return;
+    }
+
+    int fd;
+    if (metrics_endpoint[0] == '/') {
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        if (strlen(metrics_endpoint) >= sizeof(addr.sun_path)) {
+            syslog(LOG_ERR, "[METRICS] Socket path too long: %s", metrics_endpoint);
+            return;
+        }
+        strcpy(addr.sun_path, metrics_endpoint);
+        unlink(metrics_endpoint);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            syslog(LOG_ERR, "[METRICS] Failed to bind %s: %s", metrics_endpoint, strerror(errno));
+            if (fd >= 0) close(fd);
+            return;
+        }
+        metrics_unix_socket = true;
+    } else {
+        int port = atoi(metrics_endpoint);
+        if (port <= 0 || port > 65535) {
+            syslog(LOG_ERR, "[METRICS] Invalid metrics endpoint: %s", metrics_endpoint);
+            return;
+        }
+        struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int one = 1;
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd >= 0) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+        if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            syslog(LOG_ERR, "[METRICS] Failed to bind 127.0.0.1:%d: %s", port, strerror(errno));
+            if (fd >= 0) close(fd);
+            return;
+        }
+    }
+
+    if (listen(fd, METRICS_MAX_CLIENTS) != 0) {
+        syslog(LOG_ERR, "[METRICS] listen failed: %s", strerror(errno));
+        close(fd);
+        return;
+    }
+
+    metrics_listen_source = pw_loop_add_io(pw_main_loop_get_loop(loop), fd, SPA_IO_IN, true,
+                                           on_metrics_accept, NULL);
+    syslog(LOG_INFO, "[METRICS] Prometheus metrics served on %s%s/metrics",
+           metrics_unix_socket ? "unix:" : "http://127.0.0.1:", metrics_endpoint);
+}
+
+/**
+ * Close the metrics listener and any open scrapes
+ */
+static void cleanup_metrics_endpoint(void) {
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if (metrics_clients[i].in_use) {
+            metrics_client_close(&metrics_clients[i]);
+        }
+    }
+    if (metrics_listen_source) {
+        pw_loop_destroy_source(pw_main_loop_get_loop(loop), metrics_listen_source);
+        metrics_listen_source = NULL;
+    }
+    if (metrics_unix_socket) {
+        unlink(metrics_endpoint);
+    }
+}
+
+/**
+ * Email payload structure for libcurl
+ */
+struct email_upload_status {
+    char *data;
+    size_t length;
+    size_t position;
+};
+
+/**
+ * Callback for libcurl to read email data
+ */
+static size_t email_payload_source(void *ptr, size_t size, size_t nmemb, void *userp) {
+    struct email_upload_status *upload_ctx = (struct email_upload_status *)userp;
+    const char *data = upload_ctx->data;
+    size_t room = size * nmemb;
+    
+    if (upload_ctx->position >= upload_ctx->length) {
+        return 0;  // No more data
+    }
+    
+    size_t remaining = upload_ctx->length - upload_ctx->position;
+    size_t len = (remaining < room) ? remaining : room;
+    
+    memcpy(ptr, data + upload_ctx->position, len);
+    upload_ctx->position += len;
+    
+    return len;
+}
+
+/**
+ * Attachment streamed by libcurl straight from a read-only file mapping
+ */
+struct email_attachment {
+    const char *path;
+    const char *type;
+};
+
+struct email_mapped_file {
+    const uint8_t *data;
+    size_t size;
+    size_t position;
+};
+
+static size_t email_mapped_read(char *buffer, size_t size, size_t nitems, void *arg) {
+    struct email_mapped_file *file = arg;
+    size_t len = file->size - file->position;
+    if (len > size * nitems) {
+        len = size * nitems;
+    }
+    memcpy(buffer, file->data + file->position, len);
+    file->position += len;
+    return len;
+}
+
+static int email_mapped_seek(void *arg, curl_off_t offset, int origin) {
+    struct email_mapped_file *file = arg;
+    if (origin != SEEK_SET || offset < 0 || (size_t)offset > file->size) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    file->position = (size_t)offset;
+    return CURL_SEEKFUNC_OK;
+}
+
+static void email_mapped_free(void *arg) {
+    struct email_mapped_file *file = arg;
+    munmap((void *)(uintptr_t)file->data, file->size);
+    free(file);
+}
+
+/**
+ * Add a file as a base64 part; libcurl encodes it chunk by chunk as the upload reads it
+ */
+static bool email_attach_file(curl_mime *mime, const struct email_attachment *a) {
+    int fd = open(a->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        syslog(LOG_WARNING, "[EMAIL] Attachment %s: %s", a->path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > EMAIL_ATTACHMENT_MAX_BYTES) {
+        syslog(LOG_WARNING, "[EMAIL] Attachment %s skipped: size %lld outside 1..%d bytes",
+               a->path, (long long)st.st_size, EMAIL_ATTACHMENT_MAX_BYTES);
+        close(fd);
+        return false;
+    }
+    
+    struct email_mapped_file *file = calloc(1, sizeof(*file));
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (!file || data == MAP_FAILED) {
+        syslog(LOG_WARNING, "[EMAIL] Attachment %s: %s", a->path, file ? strerror(errno) : "out of memory");
+        if (data != MAP_FAILED) {
+            munmap(data, (size_t)st.st_size);
+        }
+        free(file);
+        return false;
+    }
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    
+    const char *name = strrchr(a->path, '/');
+    curl_mimepart *part = curl_mime_addpart(mime);
+    if (!part || curl_mime_data_cb(part, (curl_off_t)file->size, email_mapped_read, email_mapped_seek,
+                                   email_mapped_free, file) != CURLE_OK) {
+        email_mapped_free(file);
+        return false;
+    }
+    curl_mime_type(part, a->type);
+    curl_mime_filename(part, name ? name + 1 : a->path);
+    curl_mime_encoder(part, "base64");
+    return true;
+}
+
+/**
+ * Email settings as of one send, copied so a config reload cannot change them mid-session
+ */
+struct email_settings {
+    bool enabled;
+    char server[256];
+    int port;
+    char username[256];
+    char password[256];
+    char recipient[256];
+    bool attach_clip;
+    bool attach_spectrogram;
+};
+
+static void email_settings_snapshot(struct email_settings *cfg) {
+    pthread_mutex_lock(&alert_config_lock);
+    cfg->enabled = email_enabled;
+    memcpy(cfg->server, smtp_server, sizeof(cfg->server));
+    cfg->port = smtp_port;
+    memcpy(cfg->username, smtp_username, sizeof(cfg->username));
+    memcpy(cfg->password, smtp_password, sizeof(cfg->password));
+    memcpy(cfg->recipient, recipient_email, sizeof(cfg->recipient));
+    cfg->attach_clip = email_attach_clip;
+    cfg->attach_spectrogram = email_attach_spectrogram;
+    pthread_mutex_unlock(&alert_config_lock);
+}
+
+/**
+ * Send one email with the given subject and plain-text body, as MIME with the attachments if any
+ */
+static bool send_email_notification(const struct email_settings *cfg, const char *subject, const char *text,
+                                    const struct email_attachment *attachments, size_t n_attachments) {
+    if (!cfg->enabled || strlen(cfg->username) == 0 || strlen(cfg->recipient) == 0) {
+        return false;
+    }
+    
+    CURL *curl;
+    CURLcode res = CURLE_OK;
+    struct curl_slist *recipients = NULL;
+    struct curl_slist *headers = NULL;
+    curl_mime *mime = NULL;
+    struct email_upload_status upload_ctx;
+    
+    // Build email content
+    char message[4096];
+    snprintf(message, sizeof(message),
+        "%s"
+        "\r\n"
+        "This is an automated security notification.\r\n"
+        "Please investigate immediately.\r\n"
+        "\r\n"
+        "-- Axis Gunshot Detection System\r\n",
+        text);
+    char email_body[sizeof(message) + 1024];
+    snprintf(email_body, sizeof(email_body),
+        "To: %s\r\n"
+        "From: %s\r\n"
+        "Subject: %s\r\n"
+        "\r\n"
+        "%s",
+        cfg->recipient, cfg->username, subject, message);
+    
+    upload_ctx.data = email_body;
+    upload_ctx.length = strlen(email_body);
+    upload_ctx.position = 0;
+    
+    curl = curl_easy_init();
+    if (!curl) {
+        syslog(LOG_ERR, "[EMAIL] Failed to initialize curl");
+        return false;
+    }
+    
+    // Build SMTP URL - use smtp:// for port 587 (STARTTLS) or smtps:// for port 465 (SSL)
+    char smtp_url[512];
+    if (cfg->port == 465) {
+        snprintf(smtp_url, sizeof(smtp_url), "smtps://%s:%d", cfg->server, cfg->port);
+    } else {
+        snprintf(smtp_url, sizeof(smtp_url), "smtp://%s:%d", cfg->server, cfg->port);
+    }
+    
+    syslog(LOG_INFO, "[EMAIL] Connecting to %s", smtp_url);
     
     // Configure SMTP settings
     curl_easy_setopt(curl, CURLOPT_URL, smtp_url);
     
     // SSL/TLS configuration based on port
-    if (smtp_port == 465) {
+    if (cfg->port == 465) {
         // Port 465: Use SSL from the start
         curl_easy_setopt(curl, CURLOPT_USE_SSL, CURLUSESSL_ALL);
     } else {
@@ -441,621 +1867,5627 @@ static bool send_email_notification(float confidence, float rms) {
     // Additional SSL settings for Gmail compatibility
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
-    curl_easy_setopt(curl, CURLOPT_USERNAME, smtp_username);
-    curl_easy_setopt(curl, CURLOPT_PASSWORD, smtp_password);
-    curl_easy_setopt(curl, CURLOPT_MAIL_FROM, smtp_username);
+    curl_easy_setopt(curl, CURLOPT_USERNAME, cfg->username);
+    curl_easy_setopt(curl, CURLOPT_PASSWORD, cfg->password);
+    curl_easy_setopt(curl, CURLOPT_MAIL_FROM, cfg->username);
     
-    recipients = curl_slist_append(recipients, recipient_email);
+    recipients = curl_slist_append(recipients, cfg->recipient);
     curl_easy_setopt(curl, CURLOPT_MAIL_RCPT, recipients);
     
-    curl_easy_setopt(curl, CURLOPT_READFUNCTION, email_payload_source);
-    curl_easy_setopt(curl, CURLOPT_READDATA, &upload_ctx);
-    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+    if (n_attachments > 0) {
+        mime = curl_mime_init(curl);
+        curl_mimepart *part = curl_mime_addpart(mime);
+        curl_mime_data(part, message, CURL_ZERO_TERMINATED);
+        curl_mime_type(part, "text/plain; charset=utf-8");
+        for (size_t i = 0; i < n_attachments; i++) {
+            email_attach_file(mime, &attachments[i]);
+        }
+        
+        char header[384];
+        snprintf(header, sizeof(header), "To: %s", cfg->recipient);
+        headers = curl_slist_append(headers, header);
+        snprintf(header, sizeof(header), "From: %s", cfg->username);
+        headers = curl_slist_append(headers, header);
+        snprintf(header, sizeof(header), "Subject: %s", subject);
+        headers = curl_slist_append(headers, header);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, email_payload_source);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &upload_ctx);
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+    }
     
     // Set timeout and enable verbose logging for debugging
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
     curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
     
-    syslog(LOG_INFO, "[EMAIL] Attempting to send email to %s via %s", recipient_email, smtp_url);
+    syslog(LOG_INFO, "[EMAIL] Attempting to send email to %s via %s", cfg->recipient, smtp_url);
     syslog(LOG_INFO, "[EMAIL] Username: %s, SSL Mode: %s", 
-           smtp_username, (smtp_port == 465) ? "SSL" : "STARTTLS");
+           cfg->username, (cfg->port == 465) ? "SSL" : "STARTTLS");
     
     // Send the email
+    atomic_fetch_add_explicit(&alerts_pending, 1, memory_order_relaxed);
+    uint64_t t_send = monotonic_us();
     res = curl_easy_perform(curl);
+    histogram_observe(&alert_send_latency_hist, monotonic_us() - t_send);
+    atomic_fetch_sub_explicit(&alerts_pending, 1, memory_order_relaxed);
     
     bool success = (res == CURLE_OK);
     if (success) {
-        last_email_time = current_time;
-        syslog(LOG_INFO, "[EMAIL] ✅ Gunshot alert sent to %s (%.1f%% confidence)", 
-               recipient_email, confidence);
+        syslog(LOG_INFO, "[EMAIL] ✅ \"%s\" sent to %s", subject, cfg->recipient);
     } else {
         long response_code = 0;
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
         syslog(LOG_ERR, "[EMAIL] ❌ Failed to send email: %s (Response code: %ld)", 
                curl_easy_strerror(res), response_code);
         syslog(LOG_ERR, "[EMAIL] Debug: URL=%s, Port=%d, Username=%s", 
-               smtp_url, smtp_port, smtp_username);
+               smtp_url, cfg->port, cfg->username);
     }
     
-    // Cleanup
+    // Cleanup (the MIME tree outlives the handle that used it)
     curl_slist_free_all(recipients);
+    curl_slist_free_all(headers);
     curl_easy_cleanup(curl);
+    curl_mime_free(mime);
     
     return success;
 }
 
+/**
+ * Publish an event to every sink; never blocks (single producer: the analysis thread)
+ */
+static void event_bus_publish(const struct detection_event *e) {
+    uint64_t position = atomic_load_explicit(&event_bus_head, memory_order_relaxed);
+    struct event_bus_slot *slot = &event_bus[position & (EVENT_BUS_SLOTS - 1)];
+    
+    atomic_store_explicit(&slot->sequence, 2 * position + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->event = *e;
+    atomic_store_explicit(&slot->sequence, 2 * position + 2, memory_order_release);
+    atomic_store_explicit(&event_bus_head, position + 1, memory_order_release);
+    
+    for (size_t i = 0; i < event_sink_count; i++) {
+        if (event_sinks[i]->started) {
+            sem_post(&event_sinks[i]->wake);
+        }
+    }
+}
+
+/**
+ * Copy the sink's next event off the bus; a sink that fell more than a ring behind skips ahead
+ */
+static bool event_bus_next(struct event_sink *sink, struct detection_event *out) {
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&event_bus_head, memory_order_acquire);
+        if (sink->cursor == head) {
+            return false;
+        }
+        if (head - sink->cursor > EVENT_BUS_SLOTS) {
+            atomic_fetch_add_explicit(&sink->dropped, head - sink->cursor - EVENT_BUS_SLOTS, memory_order_relaxed);
+            sink->cursor = head - EVENT_BUS_SLOTS;
+        }
+        
+        const struct event_bus_slot *slot = &event_bus[sink->cursor & (EVENT_BUS_SLOTS - 1)];
+        const uint64_t published = 2 * sink->cursor + 2;
+        uint64_t before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        *out = slot->event;
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+        sink->cursor++;
+        if (before == published && after == published) {
+            return true;
+        }
+        // Overwritten while we were copying it
+        atomic_fetch_add_explicit(&sink->dropped, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * FNV-1a over a spool record up to its checksum
+ */
+static uint32_t spool_checksum(const struct spool_record *r) {
+    const uint8_t *p = (const uint8_t *)r;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(struct spool_record, checksum); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Append one record and flush it to disk before the caller moves on
+ */
+static bool spool_write(struct event_sink *sink, enum spool_record_kind kind, uint64_t sequence,
+                        const struct spool_entry *entry) {
+    struct spool_record r;
+    memset(&r, 0, sizeof(r));  // Padding is checksummed too
+    r.magic = SPOOL_MAGIC;
+    r.kind = kind;
+    r.sequence = sequence;
+    if (entry) {
+        r.event = entry->event;
+        r.targets = entry->targets;
+    }
+    r.checksum = spool_checksum(&r);
+    if (write(sink->spool_fd, &r, sizeof(r)) != (ssize_t)sizeof(r) || fdatasync(sink->spool_fd) != 0) {
+        syslog(LOG_ERR, "[SPOOL] %s: cannot write spool: %s", sink->name, strerror(errno));
+        return false;
+    }
+    sink->spool_records++;
+    return true;
+}
+
+static void spool_path(const struct event_sink *sink, char *path, size_t cap) {
+    snprintf(path, cap, "%s/alert_spool_%s.bin", SPOOL_DIR, sink->name);
+}
+
+/**
+ * Rewrite the file with only the pending records (temp file + rename, so a crash keeps the old one)
+ */
+static void spool_compact(struct event_sink *sink) {
+    char path[256], tmp_path[272];
+    spool_path(sink, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        syslog(LOG_WARNING, "[SPOOL] %s: cannot compact spool: %s", sink->name, strerror(errno));
+        return;
+    }
+    int old_fd = sink->spool_fd;
+    sink->spool_fd = fd;
+    sink->spool_records = 0;
+    bool ok = true;
+    for (size_t i = 0; i < sink->spool_count && ok; i++) {
+        const struct spool_entry *entry = &sink->spool[(sink->spool_head + i) % SPOOL_MAX_PENDING];
+        ok = spool_write(sink, SPOOL_PENDING, entry->sequence, entry);
+    }
+    close(fd);
+    
+    sink->spool_fd = ok && rename(tmp_path, path) == 0 ? open(path, O_WRONLY | O_APPEND | O_CLOEXEC) : -1;
+    if (sink->spool_fd < 0) {
+        syslog(LOG_WARNING, "[SPOOL] %s: compaction failed, keeping the old spool", sink->name);
+        unlink(tmp_path);
+        sink->spool_fd = old_fd;
+        return;
+    }
+    close(old_fd);
+}
+
+/**
+ * Drop the i-th pending entry (counted from the oldest), keeping the others in order
+ */
+static void spool_remove(struct event_sink *sink, size_t i) {
+    for (size_t j = i; j > 0; j--) {
+        sink->spool[(sink->spool_head + j) % SPOOL_MAX_PENDING] =
+            sink->spool[(sink->spool_head + j - 1) % SPOOL_MAX_PENDING];
+    }
+    sink->spool_head = (sink->spool_head + 1) % SPOOL_MAX_PENDING;
+    sink->spool_count--;
+    atomic_store_explicit(&sink->spool_pending, sink->spool_count, memory_order_relaxed);
+}
+
+/**
+ * Queue an event for retry; a full spool gives up on its oldest entry
+ */
+static struct spool_entry *spool_add(struct event_sink *sink, uint64_t sequence, const struct detection_event *e,
+                                     uint32_t targets) {
+    if (sink->spool_count == SPOOL_MAX_PENDING) {
+        const struct spool_entry *oldest = &sink->spool[sink->spool_head];
+        syslog(LOG_ERR, "[SPOOL] %s: spool full, giving up on event %u", sink->name, oldest->event.id);
+        spool_write(sink, SPOOL_DONE, oldest->sequence, NULL);
+        spool_remove(sink, 0);
+        atomic_fetch_add_explicit(&sink->dropped, 1, memory_order_relaxed);
+    }
+    struct spool_entry *entry = &sink->spool[(sink->spool_head + sink->spool_count) % SPOOL_MAX_PENDING];
+    entry->sequence = sequence;
+    entry->event = *e;
+    entry->targets = targets;
+    entry->held = false;
+    sink->spool_count++;
+    if (sequence > sink->spool_sequence) {
+        sink->spool_sequence = sequence;
+    }
+    atomic_store_explicit(&sink->spool_pending, sink->spool_count, memory_order_relaxed);
+    return entry;
+}
+
+/**
+ * Pending entry with the given sequence, NULL if there is none
+ */
+static struct spool_entry *spool_find(struct event_sink *sink, uint64_t sequence, size_t *index) {
+    for (size_t i = 0; i < sink->spool_count; i++) {
+        struct spool_entry *entry = &sink->spool[(sink->spool_head + i) % SPOOL_MAX_PENDING];
+        if (entry->sequence == sequence) {
+            *index = i;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Open the sink's spool and pick up what an earlier run left undelivered
+ */
+static void spool_open(struct event_sink *sink) {
+    char path[256];
+    spool_path(sink, path, sizeof(path));
+    sink->spool_fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (sink->spool_fd < 0) {
+        syslog(LOG_WARNING, "[SPOOL] %s: cannot open %s, failed alerts will not be retried: %s",
+               sink->name, path, strerror(errno));
+        return;
+    }
+    
+    struct spool_record r;
+    off_t valid = 0;
+    while (read(sink->spool_fd, &r, sizeof(r)) == (ssize_t)sizeof(r) &&
+           r.magic == SPOOL_MAGIC && r.checksum == spool_checksum(&r)) {
+        valid += (off_t)sizeof(r);
+        sink->spool_records++;
+        size_t i;
+        struct spool_entry *entry = spool_find(sink, r.sequence, &i);
+        if (r.kind == SPOOL_PENDING) {
+            if (entry) {
+                entry->targets = r.targets;  // A retry reached some of the destinations
+            } else {
+                spool_add(sink, r.sequence, &r.event, r.targets);
+            }
+            continue;
+        }
+        if (entry) {
+            spool_remove(sink, i);  // Retired
+        }
+        if (r.sequence > sink->spool_sequence) {
+            sink->spool_sequence = r.sequence;
+        }
+    }
+    atomic_store_explicit(&sink->spool_pending, sink->spool_count, memory_order_relaxed);
+    
+    // A torn record at the end is a write cut short by power loss
+    if (ftruncate(sink->spool_fd, valid) != 0) {
+        syslog(LOG_WARNING, "[SPOOL] %s: cannot trim %s: %s", sink->name, path, strerror(errno));
+    }
+    if (sink->spool_count == 0) {
+        if (ftruncate(sink->spool_fd, 0) == 0) {
+            sink->spool_records = 0;
+        }
+    } else {
+        syslog(LOG_WARNING, "[SPOOL] %s: %zu undelivered alerts from before the restart, retrying",
+               sink->name, sink->spool_count);
+        if (sink->spool_records > sink->spool_count) {
+            spool_compact(sink);
+        }
+    }
+}
+
+/**
+ * Start the file over once nothing is pending; otherwise keep retired records from piling up
+ */
+static void spool_trim(struct event_sink *sink) {
+    if (sink->spool_count == 0 && ftruncate(sink->spool_fd, 0) == 0) {
+        sink->spool_records = 0;
+    } else if (sink->spool_records >= SPOOL_COMPACT_RECORDS) {
+        spool_compact(sink);
+    }
+}
+
+/**
+ * Retry spooled events, oldest first, once their backoff is over; returns ms until the next retry, -1 if none.
+ * Events the sink coalesces stay in the spool, held, until it has sent them on (spool_release_held)
+ */
+static int spool_retry(struct event_sink *sink) {
+    for (;;) {
+        size_t i = 0;
+        while (i < sink->spool_count && sink->spool[(sink->spool_head + i) % SPOOL_MAX_PENDING].held) {
+            i++;
+        }
+        if (i == sink->spool_count) {
+            return -1;
+        }
+        uint64_t now = monotonic_us();
+        if (now < sink->spool_retry_at_us) {
+            return (int)((sink->spool_retry_at_us - now) / 1000 + 1);
+        }
+        
+        struct spool_entry *entry = &sink->spool[(sink->spool_head + i) % SPOOL_MAX_PENDING];
+        const uint32_t targets = entry->targets;
+        enum sink_result result = sink->deliver(&entry->event, &entry->targets);
+        if (result == SINK_FAILED) {
+            if (entry->targets != targets) {
+                spool_write(sink, SPOOL_PENDING, entry->sequence, entry);  // Only the rest is retried after a restart
+            }
+            sink->spool_backoff_ms = sink->spool_backoff_ms ? sink->spool_backoff_ms * 2 : SPOOL_RETRY_MIN_MS;
+            if (sink->spool_backoff_ms > SPOOL_RETRY_MAX_MS) {
+                sink->spool_backoff_ms = SPOOL_RETRY_MAX_MS;
+            }
+            sink->spool_retry_at_us = now + (uint64_t)sink->spool_backoff_ms * 1000u;
+            syslog(LOG_WARNING, "[SPOOL] %s: event %u still undeliverable, %zu pending, next retry in %u s",
+                   sink->name, entry->event.id, sink->spool_count, sink->spool_backoff_ms / 1000);
+            continue;
+        }
+        
+        syslog(result == SINK_REJECTED ? LOG_ERR : LOG_INFO, "[SPOOL] %s: event %u %s after %.0f s", sink->name,
+               entry->event.id, result == SINK_DELIVERED ? "delivered" : result == SINK_COALESCED ? "queued for the digest"
+                                : result == SINK_REJECTED ? "rejected" : "no longer needed",
+               (unix_ms() - entry->event.time_ms) / 1000.0);
+        atomic_fetch_add_explicit(result == SINK_DELIVERED ? &sink->delivered
+                                  : result == SINK_COALESCED ? &sink->coalesced
+                                  : result == SINK_REJECTED ? &sink->failed : &sink->skipped, 1,
+                                  memory_order_relaxed);
+        sink->spool_backoff_ms = 0;
+        if (result == SINK_COALESCED) {
+            entry->held = true;  // Only in the sink's memory so far; a crash retries it from the file
+            continue;
+        }
+        spool_write(sink, SPOOL_DONE, entry->sequence, NULL);
+        spool_remove(sink, i);
+        spool_trim(sink);
+    }
+}
+
+/**
+ * Retire the held entries once the sink has sent what it coalesced them into
+ */
+static void spool_release_held(struct event_sink *sink) {
+    size_t released = 0;
+    for (size_t i = 0; i < sink->spool_count;) {
+        const struct spool_entry *entry = &sink->spool[(sink->spool_head + i) % SPOOL_MAX_PENDING];
+        if (!entry->held) {
+            i++;
+            continue;
+        }
+        spool_write(sink, SPOOL_DONE, entry->sequence, NULL);
+        spool_remove(sink, i);
+        released++;
+    }
+    if (released > 0) {
+        syslog(LOG_INFO, "[SPOOL] %s: %zu spooled events went out with the digest", sink->name, released);
+        spool_trim(sink);
+    }
+}
+
+/**
+ * Deliver one event from the bus, spooling it for the destinations that failed
+ */
+static enum sink_result event_sink_handle(struct event_sink *sink, const struct detection_event *e) {
+    uint32_t targets = SINK_TARGETS_ALL;
+    enum sink_result result = (e->routes & sink->route) ? sink->deliver(e, &targets) : SINK_SKIPPED;
+    if (result == SINK_FAILED && sink->spool_fd >= 0) {
+        const struct spool_entry *entry = spool_add(sink, ++sink->spool_sequence, e, targets);
+        spool_write(sink, SPOOL_PENDING, entry->sequence, entry);
+        atomic_fetch_add_explicit(&sink->spool_added, 1, memory_order_relaxed);
+        if (sink->spool_retry_at_us == 0) {
+            sink->spool_retry_at_us = monotonic_us() + SPOOL_RETRY_MIN_MS * 1000u;
+        }
+        return result;
+    }
+    if (result == SINK_DELIVERED) {
+        sink->spool_retry_at_us = 0;  // The destination is back, retry the spool now
+    }
+    _Atomic uint64_t *counter = result == SINK_DELIVERED ? &sink->delivered
+                              : result == SINK_SKIPPED ? &sink->skipped
+                              : result == SINK_COALESCED ? &sink->coalesced : &sink->failed;
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+    return result;
+}
+
+/**
+ * Sink thread: deliver everything published so far, then sleep until the next event
+ */
+static void *event_sink_main(void *arg) {
+    struct event_sink *sink = arg;
+    struct detection_event e;
+    
+    for (;;) {
+        while (event_bus_next(sink, &e)) {
+            event_sink_handle(sink, &e);
+        }
+        int wait_ms = sink->spool_fd >= 0 ? spool_retry(sink) : -1;
+        if (!atomic_load_explicit(&event_bus_running, memory_order_acquire)) {
+            break;
+        }
+        if (sink->poll) {
+            int poll_ms = sink->poll();
+            if (poll_ms >= 0 && (wait_ms < 0 || poll_ms < wait_ms)) {
+                wait_ms = poll_ms;
+            }
+        }
+        if (sink->spool_fd >= 0 && sink->holding && !sink->holding()) {
+            spool_release_held(sink);
+        }
+        if (wait_ms < 0) {
+            sem_wait(&sink->wake);
+            continue;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += wait_ms / 1000;
+        deadline.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        sem_timedwait(&sink->wake, &deadline);
+    }
+    if (sink->cleanup) {
+        sink->cleanup();
+    }
+    if (sink->spool_fd >= 0 && sink->holding && !sink->holding()) {
+        spool_release_held(sink);
+    }
+    return NULL;
+}
+
+/**
+ * Event log lines, formerly written on the detection path
+ */
+static enum sink_result journal_sink_deliver(const struct detection_event *e, uint32_t *targets) {
+    if (e->kind == DETECTION_EVENT_OPENED) {
+        if (strcmp(e->label, PRIMARY_LABEL) == 0) {
+            syslog(LOG_WARNING, "🔫 [GUNSHOT DETECTED - CAMERA AUDIO] Confidence: %.1f%%, RMS: %.3f",
+                   e->confidence * 100.0f, e->rms);
+        } else {
+            syslog(LOG_WARNING, "🔔 [SOUND EVENT DETECTED - CAMERA AUDIO] Class: %s, Confidence: %.1f%%, RMS: %.3f",
+                   e->label, e->confidence * 100.0f, e->rms);
+        }
+        syslog(LOG_INFO, "[EVENT] Event %u (%s) opened (%d of last %d windows above %.0f%%)",
+               e->id, e->label, e->vote_k, e->vote_n, e->threshold * 100.0f);
+        if (e->load_level != GUNSHOT_LOAD_FULL) {
+            syslog(LOG_WARNING, "[LOAD] Event %u detected at reduced quality (%s)",
+                   e->id, gunshot_load_level_names[e->load_level]);
+        }
+    } else {
+        syslog(LOG_INFO, "[EVENT] Event %u (%s) closed: %.1f s, %u windows, peak %.1f%% (RMS %.3f) %.1f s after start",
+               e->id, e->label, (e->end_ms - e->start_ms) / 1000.0f, e->windows,
+               e->peak * 100.0f, e->peak_rms, (e->peak_ms - e->start_ms) / 1000.0f);
+    }
+    return SINK_DELIVERED;
+}
+
+/**
+ * Local wall-clock time of a Unix millisecond timestamp, with or without the date
+ */
+static void format_local_time(uint64_t time_ms, bool with_date, char *buf, size_t cap) {
+    time_t t = (time_t)(time_ms / 1000);
+    struct tm tm_info;
+    localtime_r(&t, &tm_info);
+    strftime(buf, cap, with_date ? "%Y-%m-%d %H:%M:%S" : "%H:%M:%S", &tm_info);
+}
+
+/**
+ * Stage the window that opened an event for its clip (analysis thread: one copy, no I/O)
+ */
+static void clip_stage(const struct detection_event *e, const sample_t *audio, size_t num_samples) {
+    struct clip_slot *slot = &clip_slots[clip_slot_next++ % CLIP_SLOTS];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    slot->event_id = e->id;
+    slot->time_ms = e->time_ms;
+    slot->samples = num_samples < WINDOW_SAMPLES ? (uint32_t)num_samples : WINDOW_SAMPLES;
+    memcpy(slot->audio, audio, slot->samples * sizeof(sample_t));
+    slot->has_mel = window_mel_valid;
+    if (window_mel_valid) {
+        memcpy(slot->mel, window_mel_features, sizeof(slot->mel));
+    }
+    
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+static void clip_path(const struct detection_event *e, const char *ext, char *path, size_t cap) {
+    snprintf(path, cap, CLIP_DIR "/clip-%013llu-%u.%s", (unsigned long long)e->time_ms, e->id, ext);
+}
+
+static bool write_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * 16-bit mono WAV at the analysis rate, converted in small blocks
+ */
+static bool clip_write_wav(int fd, const struct clip_slot *slot) {
+    const uint32_t data_bytes = slot->samples * 2;
+    uint8_t header[44];
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, 36 + data_bytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le32(header + 16, 16);
+    put_le16(header + 20, 1);  // PCM
+    put_le16(header + 22, 1);
+    put_le32(header + 24, TARGET_SAMPLE_RATE);
+    put_le32(header + 28, TARGET_SAMPLE_RATE * 2);
+    put_le16(header + 32, 2);
+    put_le16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, data_bytes);
+    if (!write_all(fd, header, sizeof(header))) {
+        return false;
+    }
+    
+    uint8_t block[4096];
+    for (uint32_t i = 0; i < slot->samples; ) {
+        uint32_t n = 0;
+        for (; n < sizeof(block) / 2 && i < slot->samples; n++, i++) {
+#ifdef GUNSHOT_FIXED_POINT
+            int16_t v = slot->audio[i];
+#else
+            float x = slot->audio[i] * 32767.0f;
+            int16_t v = (int16_t)(x > 32767.0f ? 32767.0f : x < -32768.0f ? -32768.0f : x);
+#endif
+            put_le16(block + 2 * n, (uint16_t)v);
+        }
+        if (!write_all(fd, block, 2 * n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t png_crc(uint32_t crc, const uint8_t *p, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static bool png_chunk(int fd, const char *type, const uint8_t *data, uint32_t len) {
+    uint8_t head[8], tail[4];
+    put_be32(head, len);
+    memcpy(head + 4, type, 4);
+    put_be32(tail, png_crc(png_crc(0, head + 4, 4), data, len));
+    return write_all(fd, head, 8) && write_all(fd, data, len) && write_all(fd, tail, 4);
+}
+
+#define SPECTROGRAM_WIDTH (N_FRAMES * SPECTROGRAM_X_SCALE)
+#define SPECTROGRAM_HEIGHT (N_MELS * SPECTROGRAM_Y_SCALE)
+#define SPECTROGRAM_RAW_BYTES (SPECTROGRAM_HEIGHT * (1 + SPECTROGRAM_WIDTH))
+_Static_assert(SPECTROGRAM_RAW_BYTES <= 65535, "spectrogram must fit one stored deflate block");
+
+/**
+ * Greyscale PNG of the event window's mel features (what the model saw), low bands at the bottom.
+ * Rows go out one at a time inside a single stored deflate block, so no zlib and no image buffer
+ */
+static bool clip_write_spectrogram(int fd, const struct clip_slot *slot) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t ihdr[13] = { 0 };
+    put_be32(ihdr, SPECTROGRAM_WIDTH);
+    put_be32(ihdr + 4, SPECTROGRAM_HEIGHT);
+    ihdr[8] = 8;  // Bit depth, colour type 0 (greyscale)
+    if (!write_all(fd, signature, sizeof(signature)) || !png_chunk(fd, "IHDR", ihdr, sizeof(ihdr))) {
+        return false;
+    }
+    
+    // IDAT: zlib header, one final stored block, the rows, Adler-32
+    const uint32_t idat_len = 2 + 5 + SPECTROGRAM_RAW_BYTES + 4;
+    uint8_t head[15] = { 0 };
+    put_be32(head, idat_len);
+    memcpy(head + 4, "IDAT", 4);
+    head[8] = 0x78;
+    head[9] = 0x01;
+    head[10] = 0x01;
+    put_le16(head + 11, SPECTROGRAM_RAW_BYTES);
+    put_le16(head + 13, (uint16_t)~SPECTROGRAM_RAW_BYTES);
+    if (!write_all(fd, head, sizeof(head))) {
+        return false;
+    }
+    uint32_t crc = png_crc(0, head + 4, sizeof(head) - 4);
+    uint32_t adler_a = 1, adler_b = 0;
+    
+    uint8_t row[1 + SPECTROGRAM_WIDTH];
+    row[0] = 0;  // No filter
+    for (int y = 0; y < SPECTROGRAM_HEIGHT; y++) {
+        const int m = N_MELS - 1 - y / SPECTROGRAM_Y_SCALE;
+        for (int x = 0; x < SPECTROGRAM_WIDTH; x++) {
+            float v = slot->mel[(x / SPECTROGRAM_X_SCALE) * N_MELS + m] * 255.0f;
+            row[1 + x] = (uint8_t)(v < 0.0f ? 0.0f : v > 255.0f ? 255.0f : v);
+        }
+        for (size_t i = 0; i < sizeof(row); i++) {
+            adler_a = (adler_a + row[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        crc = png_crc(crc, row, sizeof(row));
+        if (!write_all(fd, row, sizeof(row))) {
+            return false;
+        }
+    }
+    
+    uint8_t tail[8];
+    put_be32(tail, (adler_b << 16) | adler_a);
+    put_be32(tail + 4, png_crc(crc, tail, 4));
+    return write_all(fd, tail, sizeof(tail)) && png_chunk(fd, "IEND", NULL, 0);
+}
+
+/**
+ * Delete all but the newest CLIP_KEEP clips (names sort by event time)
+ */
+static void clip_prune(void) {
+    struct dirent **names = NULL;
+    int n = scandir(CLIP_DIR, &names, NULL, alphasort);
+    if (n < 0) {
+        return;
+    }
+    unsigned clips = 0;
+    for (size_t i = (size_t)n; i-- > 0; ) {
+        const char *name = names[i]->d_name;
+        size_t len = strlen(name);
+        if (strncmp(name, "clip-", 5) == 0 && len > 4 && strcmp(name + len - 4, ".wav") == 0 &&
+            ++clips > CLIP_KEEP) {
+            char path[320];
+            snprintf(path, sizeof(path), CLIP_DIR "/%s", name);
+            unlink(path);
+            memcpy(path + strlen(path) - 4, ".png", 4);
+            unlink(path);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+/**
+ * Write one clip file from a staged slot via a temporary name; false if the slot changed meanwhile
+ */
+static bool clip_write_file(const struct clip_slot *slot, uint32_t seq, const char *path,
+                            bool (*writer)(int, const struct clip_slot *)) {
+    char tmp[320];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        syslog(LOG_WARNING, "[EMAIL] Cannot create %s: %s", tmp, strerror(errno));
+        return false;
+    }
+    bool ok = writer(fd, slot);
+    close(fd);
+    
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) {
+        syslog(LOG_WARNING, "[EMAIL] Clip of event #%u overwritten before it was saved", slot->event_id);
+        ok = false;
+    }
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Make sure the event's clip (and spectrogram) exist on disk; a spooled retry finds them from the first try
+ */
+static void clip_save(const struct detection_event *e, bool spectrogram, char *wav, char *png, size_t cap,
+                      bool *have_wav, bool *have_png) {
+    clip_path(e, "wav", wav, cap);
+    clip_path(e, "png", png, cap);
+    *have_wav = access(wav, R_OK) == 0;
+    *have_png = spectrogram && access(png, R_OK) == 0;
+    if (*have_wav && (*have_png || !spectrogram)) {
+        return;
+    }
+    
+    for (int i = 0; i < CLIP_SLOTS; i++) {
+        const struct clip_slot *slot = &clip_slots[i];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if ((seq & 1) || slot->event_id != e->id || slot->time_ms != e->time_ms) {
+            continue;
+        }
+        if (mkdir(CLIP_DIR, 0755) != 0 && errno != EEXIST) {
+            syslog(LOG_WARNING, "[EMAIL] Cannot create %s: %s", CLIP_DIR, strerror(errno));
+            return;
+        }
+        if (!*have_wav) {
+            *have_wav = clip_write_file(slot, seq, wav, clip_write_wav);
+        }
+        if (spectrogram && !*have_png && slot->has_mel) {
+            *have_png = clip_write_file(slot, seq, png, clip_write_spectrogram);
+        }
+        clip_prune();
+        return;
+    }
+    if (!*have_wav) {
+        syslog(LOG_WARNING, "[EMAIL] No clip for event #%u, sending without it", e->id);
+    }
+}
+
+/**
+ * Send the immediate alert for an event
+ */
+static bool email_send_alert(const struct email_settings *cfg, const struct detection_event *e) {
+    const bool gunshot = strcmp(e->label, PRIMARY_LABEL) == 0;
+    char timestamp[64];
+    char subject[96];
+    char text[512];
+    format_local_time(e->time_ms, true, timestamp, sizeof(timestamp));
+    if (gunshot) {
+        snprintf(subject, sizeof(subject), "🔫 Gunshot Detected - Security Alert");
+    } else {
+        snprintf(subject, sizeof(subject), "🔔 Sound Event Detected (%s) - Security Alert", e->label);
+    }
+    snprintf(text, sizeof(text),
+             "%s\r\n"
+             "========================\r\n"
+             "\r\n"
+             "Class: %s\r\n"
+             "Time: %s\r\n"
+             "Confidence: %.1f%%\r\n"
+             "Audio RMS: %.3f\r\n"
+             "Camera: Axis Gunshot Detector\r\n",
+             gunshot ? "GUNSHOT DETECTION ALERT" : "SOUND EVENT ALERT", e->label, timestamp,
+             e->confidence * 100.0f, e->rms);
+    
+    struct email_attachment attachments[2];
+    size_t n_attachments = 0;
+    char wav[256], png[256];
+    if (cfg->attach_clip) {
+        bool have_wav, have_png;
+        clip_save(e, cfg->attach_spectrogram, wav, png, sizeof(wav), &have_wav, &have_png);
+        if (have_wav) {
+            attachments[n_attachments++] = (struct email_attachment){ wav, "audio/wav" };
+        }
+        if (have_png) {
+            attachments[n_attachments++] = (struct email_attachment){ png, "image/png" };
+        }
+    }
+    return send_email_notification(cfg, subject, text, attachments, n_attachments);
+}
+
+/**
+ * Add an event to the pending digest (only the first EMAIL_DIGEST_MAX_LISTED are itemised)
+ */
+static void email_digest_add(const struct detection_event *e) {
+    uint64_t now = monotonic_us();
+    if (email_digest.count == 0) {
+        email_digest.started_us = now;
+        email_digest.first_ms = e->time_ms;
+        email_digest.peak = 0.0f;
+        email_digest.gunshots_only = true;
+    }
+    if (email_digest.count < EMAIL_DIGEST_MAX_LISTED) {
+        email_digest.ids[email_digest.count] = e->id;
+        email_digest.times_ms[email_digest.count] = e->time_ms;
+        email_digest.confidences[email_digest.count] = e->confidence;
+        snprintf(email_digest.labels[email_digest.count], HEAD_LABEL_MAX, "%s", e->label);
+    }
+    email_digest.gunshots_only = email_digest.gunshots_only && strcmp(e->label, PRIMARY_LABEL) == 0;
+    email_digest.count++;
+    email_digest.last_ms = e->time_ms;
+    email_digest.last_event_us = now;
+    if (e->confidence > email_digest.peak) {
+        email_digest.peak = e->confidence;
+    }
+}
+
+/**
+ * Send the digest: count, span, peak confidence and each event's time
+ */
+static bool email_send_digest(const struct email_settings *cfg) {
+    char first[32], last[32], subject[96], text[3072];
+    format_local_time(email_digest.first_ms, true, first, sizeof(first));
+    format_local_time(email_digest.last_ms, false, last, sizeof(last));
+    if (email_digest.gunshots_only) {
+        snprintf(subject, sizeof(subject), "🔫 %u more gunshot detections - Security Alert", email_digest.count);
+    } else {
+        snprintf(subject, sizeof(subject), "🔔 %u more detections - Security Alert", email_digest.count);
+    }
+    
+    int n = snprintf(text, sizeof(text),
+                     "GUNSHOT DETECTION DIGEST\r\n"
+                     "========================\r\n"
+                     "\r\n"
+                     "Detections since the last alert: %u\r\n"
+                     "Between: %s and %s\r\n"
+                     "Peak confidence: %.1f%%\r\n"
+                     "Camera: Axis Gunshot Detector\r\n"
+                     "\r\n"
+                     "Event  Time      Confidence  Class\r\n",
+                     email_digest.count, first, last, email_digest.peak * 100.0f);
+    uint32_t listed = email_digest.count < EMAIL_DIGEST_MAX_LISTED ? email_digest.count : EMAIL_DIGEST_MAX_LISTED;
+    for (uint32_t i = 0; i < listed && n > 0 && (size_t)n < sizeof(text); i++) {
+        char at[16];
+        format_local_time(email_digest.times_ms[i], false, at, sizeof(at));
+        n += snprintf(text + n, sizeof(text) - (size_t)n, "%-6u %s  %5.1f%%      %s\r\n",
+                      email_digest.ids[i], at, email_digest.confidences[i] * 100.0f, email_digest.labels[i]);
+    }
+    if (email_digest.count > listed && n > 0 && (size_t)n < sizeof(text)) {
+        snprintf(text + n, sizeof(text) - (size_t)n, "... and %u more\r\n", email_digest.count - listed);
+    }
+    return send_email_notification(cfg, subject, text, NULL, 0);
+}
+
+/**
+ * First event after a quiet period is emailed at once; later ones are coalesced into a digest
+ */
+static enum sink_result email_sink_deliver(const struct detection_event *e, uint32_t *targets) {
+    if (e->kind != DETECTION_EVENT_OPENED) {
+        return SINK_SKIPPED;
+    }
+    
+    struct email_settings cfg;
+    email_settings_snapshot(&cfg);
+    if (!cfg.enabled) {
+        return SINK_SKIPPED;
+    }
+    
+    uint64_t now = monotonic_us();
+    if (email_digest.count > 0 ||
+        (last_email_us && now - last_email_us < EMAIL_QUIET_SECONDS * 1000000ull)) {
+        email_digest_add(e);
+        syslog(LOG_INFO, "[EMAIL] Event %u added to the digest (%u pending)", e->id, email_digest.count);
+        return SINK_COALESCED;
+    }
+    if (!email_send_alert(&cfg, e)) {
+        return SINK_FAILED;
+    }
+    last_email_us = now;
+    return SINK_DELIVERED;
+}
+
+/**
+ * Flush the digest once events have been quiet for EMAIL_QUIET_SECONDS, or EMAIL_DIGEST_MAX_SECONDS after it began
+ */
+static int email_sink_poll(void) {
+    if (email_digest.count == 0) {
+        return -1;
+    }
+    uint64_t now = monotonic_us();
+    uint64_t due = email_digest.last_event_us + EMAIL_QUIET_SECONDS * 1000000ull;
+    if (email_digest.started_us + EMAIL_DIGEST_MAX_SECONDS * 1000000ull < due) {
+        due = email_digest.started_us + EMAIL_DIGEST_MAX_SECONDS * 1000000ull;
+    }
+    if (email_digest.retry_at_us > due) {
+        due = email_digest.retry_at_us;
+    }
+    if (now < due) {
+        return (int)((due - now) / 1000 + 1);
+    }
+    
+    struct email_settings cfg;
+    email_settings_snapshot(&cfg);
+    if (cfg.enabled && !email_send_digest(&cfg)) {
+        // Keep gathering; the digest goes out with the next attempt
+        email_digest.retry_backoff_ms = email_digest.retry_backoff_ms ? email_digest.retry_backoff_ms * 2
+                                                                      : SPOOL_RETRY_MIN_MS;
+        if (email_digest.retry_backoff_ms > SPOOL_RETRY_MAX_MS) {
+            email_digest.retry_backoff_ms = SPOOL_RETRY_MAX_MS;
+        }
+        email_digest.retry_at_us = now + (uint64_t)email_digest.retry_backoff_ms * 1000u;
+        return (int)email_digest.retry_backoff_ms;
+    }
+    if (cfg.enabled) {
+        last_email_us = now;
+    }
+    memset(&email_digest, 0, sizeof(email_digest));
+    return -1;
+}
+
+/**
+ * Send a pending digest before shutting down rather than losing it
+ */
+static void email_sink_cleanup(void) {
+    struct email_settings cfg;
+    email_settings_snapshot(&cfg);
+    if (email_digest.count > 0 && cfg.enabled && email_send_digest(&cfg)) {
+        memset(&email_digest, 0, sizeof(email_digest));
+    }
+}
+
+/**
+ * Events coalesced into the digest are held in the spool until it has gone out
+ */
+static bool email_sink_holding(void) {
+    return email_digest.count > 0;
+}
+
+/**
+ * Compact JSON for an event, shared by the network sinks
+ */
+static int format_event_json(const struct detection_event *e, char *buf, size_t cap) {
+    return snprintf(buf, cap,
+                    "{\"event\":\"%s\",\"id\":%u,\"class\":\"%s\",\"time_ms\":%llu,\"start_ms\":%llu,\"end_ms\":%llu,"
+                    "\"peak_ms\":%llu,"
+                    "\"confidence\":%.3f,\"rms\":%.4f,\"peak\":%.3f,\"windows\":%u,\"threshold\":%.2f,"
+                    "\"load_level\":\"%s\"}",
+                    e->kind == DETECTION_EVENT_OPENED ? "opened" : "closed", e->id, e->label,
+                    (unsigned long long)e->time_ms,
+                    (unsigned long long)e->start_ms, (unsigned long long)e->end_ms, (unsigned long long)e->peak_ms,
+                    e->confidence, e->rms, e->peak, e->windows, e->threshold, gunshot_load_level_names[e->load_level]);
+}
+
+/**
+ * Webhook endpoints: "URL[ timeout_ms=N][ retries=N]" entries, comma separated
+ */
+struct webhook_endpoint {
+    char url[512];
+    long timeout_ms;
+    int retries;
+    CURL *easy;              // Kept between events so its connection stays open
+    int attempt;
+    uint64_t started_us;
+    uint64_t retry_at_us;    // Backing off until then, 0 = not waiting
+    bool done;
+    bool ok;
+    bool retryable;          // Failed in a way a later retry could fix (no answer, 408, 429, 5xx)
+};
+
+static struct webhook_endpoint webhooks[MAX_WEBHOOKS];
+static size_t webhook_count = 0;
+static CURLM *webhook_multi = NULL;
+static struct curl_slist *webhook_headers = NULL;
+static char webhook_applied[sizeof(webhook_urls) + 32] = "";
+
+static void webhook_cleanup(void) {
+    for (size_t i = 0; i < webhook_count; i++) {
+        curl_easy_cleanup(webhooks[i].easy);
+    }
+    webhook_count = 0;
+    if (webhook_multi) {
+        curl_multi_cleanup(webhook_multi);
+        webhook_multi = NULL;
+    }
+    curl_slist_free_all(webhook_headers);
+    webhook_headers = NULL;
+}
+
+/**
+ * Rebuild the endpoint list when the configuration changed since the last event
+ */
+static void webhook_refresh_config(void) {
+    char list[sizeof(webhook_urls)];
+    char applied[sizeof(webhook_applied)];
+    long default_timeout_ms;
+    int default_retries;
+    
+    pthread_mutex_lock(&alert_config_lock);
+    memcpy(list, webhook_urls, sizeof(list));
+    default_timeout_ms = webhook_timeout_ms;
+    default_retries = webhook_retries;
+    pthread_mutex_unlock(&alert_config_lock);
+    
+    snprintf(applied, sizeof(applied), "%ld/%d/%s", default_timeout_ms, default_retries, list);
+    if (strcmp(applied, webhook_applied) == 0) {
+        return;
+    }
+    webhook_cleanup();
+    memcpy(webhook_applied, applied, sizeof(applied));
+    
+    char *save = NULL;
+    for (char *entry = strtok_r(list, ",", &save); entry; entry = strtok_r(NULL, ",", &save)) {
+        char url[512];
+        if (sscanf(entry, " %511s", url) != 1) {
+            continue;
+        }
+        if (webhook_count == MAX_WEBHOOKS) {
+            syslog(LOG_WARNING, "[WEBHOOK] More than %d endpoints, ignoring %s", MAX_WEBHOOKS, url);
+            continue;
+        }
+        struct webhook_endpoint *ep = &webhooks[webhook_count];
+        memset(ep, 0, sizeof(*ep));
+        snprintf(ep->url, sizeof(ep->url), "%s", url);
+        ep->timeout_ms = default_timeout_ms;
+        ep->retries = default_retries;
+        const char *option = strstr(entry, "timeout_ms=");
+        long timeout_ms = 0;
+        if (option && sscanf(option, "timeout_ms=%ld", &timeout_ms) == 1 && timeout_ms >= 100 && timeout_ms <= 60000) {
+            ep->timeout_ms = timeout_ms;
+        }
+        option = strstr(entry, "retries=");
+        int retries = 0;
+        if (option && sscanf(option, "retries=%d", &retries) == 1 && retries >= 0 && retries <= 10) {
+            ep->retries = retries;
+        }
+        
+        ep->easy = curl_easy_init();
+        if (!ep->easy) {
+            syslog(LOG_ERR, "[WEBHOOK] Failed to initialize curl for %s", ep->url);
+            continue;
+        }
+        webhook_count++;
+        syslog(LOG_INFO, "[WEBHOOK] Endpoint %s (timeout %ld ms, %d retries)", ep->url, ep->timeout_ms, ep->retries);
+    }
+    if (webhook_count == 0) {
+        return;
+    }
+    
+    webhook_multi = curl_multi_init();
+    webhook_headers = curl_slist_append(NULL, "Content-Type: application/json");
+    if (webhook_multi) {
+        // HTTP/2 endpoints get one multiplexed connection; HTTP/1.1 ones reuse theirs between events
+        curl_multi_setopt(webhook_multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(webhook_multi, CURLMOPT_MAX_HOST_CONNECTIONS, 2L);
+    }
+}
+
+/**
+ * Start (or restart) one endpoint's POST on the shared multi handle
+ */
+static void webhook_send(struct webhook_endpoint *ep, const char *payload) {
+    CURL *easy = ep->easy;
+    curl_easy_reset(easy);
+    curl_easy_setopt(easy, CURLOPT_URL, ep->url);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, payload);
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, webhook_headers);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, ep->timeout_ms);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, ep->timeout_ms);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, ep);
+    
+    ep->started_us = monotonic_us();
+    ep->retry_at_us = 0;
+    atomic_fetch_add_explicit(&alerts_pending, 1, memory_order_relaxed);
+    curl_multi_add_handle(webhook_multi, easy);
+}
+
+/**
+ * Handle a finished POST: done on success, permanent failure or exhausted retries, otherwise back off
+ */
+static bool webhook_finished(struct webhook_endpoint *ep, CURLcode res, uint32_t event_id) {
+    long status = 0;
+    uint64_t now = monotonic_us();
+    curl_easy_getinfo(ep->easy, CURLINFO_RESPONSE_CODE, &status);
+    curl_multi_remove_handle(webhook_multi, ep->easy);
+    histogram_observe(&alert_send_latency_hist, now - ep->started_us);
+    atomic_fetch_sub_explicit(&alerts_pending, 1, memory_order_relaxed);
+    
+    bool ok = res == CURLE_OK && status >= 200 && status < 300;
+    bool retryable = res != CURLE_OK || status == 408 || status == 429 || status >= 500;
+    if (!ok && retryable && ep->attempt < ep->retries) {
+        ep->attempt++;
+        ep->retry_at_us = now + ((uint64_t)WEBHOOK_RETRY_BACKOFF_MS * 1000u << (ep->attempt - 1));
+        syslog(LOG_WARNING, "[WEBHOOK] Event %u to %s: %s (HTTP %ld), retry %d of %d",
+               event_id, ep->url, curl_easy_strerror(res), status, ep->attempt, ep->retries);
+        return false;
+    }
+    
+    ep->done = true;
+    ep->ok = ok;
+    ep->retryable = retryable;
+    if (ok) {
+        syslog(LOG_INFO, "[WEBHOOK] ✅ Event %u delivered to %s in %.0f ms",
+               event_id, ep->url, (now - ep->started_us) / 1000.0);
+    } else {
+        syslog(LOG_ERR, "[WEBHOOK] ❌ Event %u to %s failed: %s (HTTP %ld, %d attempts)",
+               event_id, ep->url, curl_easy_strerror(res), status, ep->attempt + 1);
+    }
+    return true;
+}
+
+/**
+ * POST the event to every endpoint in *targets (bit i = i-th configured endpoint) concurrently; returns once
+ * each has succeeded or given up, leaving in *targets the endpoints worth retrying
+ */
+static enum sink_result webhook_sink_deliver(const struct detection_event *e, uint32_t *targets) {
+    webhook_refresh_config();
+    if (webhook_count == 0 || !webhook_multi || !(*targets & ((1u << webhook_count) - 1))) {
+        return SINK_SKIPPED;
+    }
+    
+    char payload[512];
+    format_event_json(e, payload, sizeof(payload));
+    
+    size_t pending = 0;
+    for (size_t i = 0; i < webhook_count; i++) {
+        webhooks[i].attempt = 0;
+        webhooks[i].done = !(*targets & (1u << i));  // Took the event on an earlier attempt
+        webhooks[i].ok = webhooks[i].done;
+        webhooks[i].retryable = false;
+        if (!webhooks[i].done) {
+            webhook_send(&webhooks[i], payload);
+            pending++;
+        }
+    }
+    
+    while (pending) {
+        int running = 0;
+        curl_multi_perform(webhook_multi, &running);
+        
+        CURLMsg *msg;
+        int left = 0;
+        while ((msg = curl_multi_info_read(webhook_multi, &left))) {
+            struct webhook_endpoint *ep = NULL;
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&ep);
+            if (ep && webhook_finished(ep, msg->data.result, e->id)) {
+                pending--;
+            }
+        }
+        
+        // Resend endpoints whose backoff is over, then sleep until a transfer needs us or a backoff ends
+        uint64_t now = monotonic_us();
+        int wait_ms = 1000;
+        for (size_t i = 0; i < webhook_count; i++) {
+            struct webhook_endpoint *ep = &webhooks[i];
+            if (ep->done || ep->retry_at_us == 0) {
+                continue;
+            }
+            if (now >= ep->retry_at_us) {
+                webhook_send(ep, payload);
+                wait_ms = 0;
+            } else if ((ep->retry_at_us - now) / 1000 + 1 < (uint64_t)wait_ms) {
+                wait_ms = (int)((ep->retry_at_us - now) / 1000 + 1);
+            }
+        }
+        if (pending && wait_ms > 0) {
+            curl_multi_poll(webhook_multi, NULL, 0, wait_ms, NULL);
+        }
+    }
+    
+    uint32_t retry = 0;
+    bool rejected = false;
+    for (size_t i = 0; i < webhook_count; i++) {
+        retry |= webhooks[i].retryable ? 1u << i : 0;
+        rejected |= !webhooks[i].ok && !webhooks[i].retryable;
+    }
+    *targets = retry;
+    return retry ? SINK_FAILED : rejected ? SINK_REJECTED : SINK_DELIVERED;
+}
+
+/**
+ * MQTT settings as of one connection, copied under the alert config lock
+ */
+struct mqtt_settings {
+    char broker[256];
+    char topic[128];
+    int qos;
+    char username[128];
+    char password[128];
+    int heartbeat_s;
+};
+
+// MQTT connection state, owned by the mqtt sink thread
+static int mqtt_fd = -1;
+static struct mqtt_settings mqtt_cfg;
+static uint16_t mqtt_packet_id = 0;
+static uint64_t mqtt_last_send_us = 0;
+static uint64_t mqtt_ping_sent_us = 0;       // PINGREQ awaiting its PINGRESP, 0 = none
+static uint64_t mqtt_last_heartbeat_us = 0;
+static uint64_t mqtt_next_connect_us = 0;
+static uint32_t mqtt_backoff_ms = MQTT_RECONNECT_MIN_MS;
+static uint8_t mqtt_rx[512];
+static size_t mqtt_rx_len = 0;
+
+static void mqtt_settings_snapshot(struct mqtt_settings *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    pthread_mutex_lock(&alert_config_lock);
+    snprintf(cfg->broker, sizeof(cfg->broker), "%s", mqtt_broker);
+    snprintf(cfg->topic, sizeof(cfg->topic), "%s", mqtt_topic);
+    cfg->qos = mqtt_qos;
+    snprintf(cfg->username, sizeof(cfg->username), "%s", mqtt_username);
+    snprintf(cfg->password, sizeof(cfg->password), "%s", mqtt_password);
+    cfg->heartbeat_s = mqtt_heartbeat_s;
+    pthread_mutex_unlock(&alert_config_lock);
+}
+
+/**
+ * Append an MQTT UTF-8 string (16-bit length prefix)
+ */
+static size_t mqtt_put_string(uint8_t *p, const char *s) {
+    size_t len = strlen(s);
+    p[0] = (uint8_t)(len >> 8);
+    p[1] = (uint8_t)len;
+    memcpy(p + 2, s, len);
+    return len + 2;
+}
+
+/**
+ * Close the connection and schedule the next attempt; graceful sends DISCONNECT so the will is not published
+ */
+static void mqtt_disconnect(bool graceful, const char *reason) {
+    if (mqtt_fd < 0) {
+        return;
+    }
+    if (graceful) {
+        static const uint8_t disconnect[2] = { 0xE0, 0x00 };
+        send(mqtt_fd, disconnect, sizeof(disconnect), MSG_NOSIGNAL | MSG_DONTWAIT);
+    } else {
+        syslog(LOG_WARNING, "[MQTT] Connection to %s lost: %s, reconnecting in %u s",
+               mqtt_cfg.broker, reason, mqtt_backoff_ms / 1000);
+    }
+    close(mqtt_fd);
+    mqtt_fd = -1;
+    mqtt_rx_len = 0;
+    mqtt_ping_sent_us = 0;
+    mqtt_next_connect_us = monotonic_us() + (uint64_t)mqtt_backoff_ms * 1000u;
+    mqtt_backoff_ms = mqtt_backoff_ms * 2 > MQTT_RECONNECT_MAX_MS ? MQTT_RECONNECT_MAX_MS : mqtt_backoff_ms * 2;
+}
+
+/**
+ * Send one packet: fixed header, remaining length and body, waiting at most MQTT_TIMEOUT_MS for socket space
+ */
+static bool mqtt_send_packet(uint8_t header, const uint8_t *body, size_t len) {
+    uint8_t packet[1 + 4 + MQTT_MAX_PACKET];
+    size_t n = 0;
+    if (mqtt_fd < 0 || len > MQTT_MAX_PACKET) {
+        return false;
+    }
+    packet[n++] = header;
+    size_t remaining = len;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        packet[n++] = digit | (remaining ? 0x80 : 0);
+    } while (remaining);
+    memcpy(packet + n, body, len);
+    n += len;
+    
+    size_t sent = 0;
+    uint64_t deadline = monotonic_us() + MQTT_TIMEOUT_MS * 1000u;
+    while (sent < n) {
+        ssize_t w = send(mqtt_fd, packet + sent, n - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (w > 0) {
+            sent += (size_t)w;
+            continue;
+        }
+        uint64_t now = monotonic_us();
+        if ((w < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) || now >= deadline) {
+            mqtt_disconnect(false, w < 0 && errno != EAGAIN ? strerror(errno) : "send timed out");
+            return false;
+        }
+        struct pollfd pfd = { .fd = mqtt_fd, .events = POLLOUT };
+        poll(&pfd, 1, (int)((deadline - now) / 1000 + 1));
+    }
+    mqtt_last_send_us = monotonic_us();
+    return true;
+}
+
+/**
+ * Read the next packet into body (type in the high nibble of *header); 0 on timeout, -1 on a dead connection
+ */
+static int mqtt_read_packet(int timeout_ms, uint8_t *header, uint8_t *body, size_t *len) {
+    uint64_t deadline = monotonic_us() + (uint64_t)timeout_ms * 1000u;
+    for (;;) {
+        // Complete packet already buffered?
+        size_t remaining = 0, pos = 1;
+        uint32_t multiplier = 1;
+        bool length_done = false;
+        while (pos < mqtt_rx_len && pos <= 4) {
+            remaining += (size_t)(mqtt_rx[pos] & 0x7F) * multiplier;
+            multiplier *= 128;
+            if (!(mqtt_rx[pos++] & 0x80)) {
+                length_done = true;
+                break;
+            }
+        }
+        if (length_done && remaining > sizeof(mqtt_rx) - pos) {
+            mqtt_disconnect(false, "oversized packet from broker");
+            return -1;
+        }
+        if (length_done && mqtt_rx_len >= pos + remaining) {
+            *header = mqtt_rx[0];
+            memcpy(body, mqtt_rx + pos, remaining);
+            *len = remaining;
+            mqtt_rx_len -= pos + remaining;
+            memmove(mqtt_rx, mqtt_rx + pos + remaining, mqtt_rx_len);
+            return 1;
+        }
+        
+        uint64_t now = monotonic_us();
+        struct pollfd pfd = { .fd = mqtt_fd, .events = POLLIN };
+        int wait_ms = now >= deadline ? 0 : (int)((deadline - now) / 1000 + 1);
+        if (poll(&pfd, 1, wait_ms) <= 0) {
+            return 0;
+        }
+        ssize_t r = recv(mqtt_fd, mqtt_rx + mqtt_rx_len, sizeof(mqtt_rx) - mqtt_rx_len, MSG_DONTWAIT);
+        if (r <= 0) {
+            if (r < 0 && (errno == EAGAIN || errno == EINTR)) {
+                continue;
+            }
+            mqtt_disconnect(false, r == 0 ? "closed by broker" : strerror(errno));
+            return -1;
+        }
+        mqtt_rx_len += (size_t)r;
+    }
+}
+
+/**
+ * Publish to <topic>/<subtopic>; QoS 1 waits for the broker's PUBACK. For QoS 1, *packet_id starts at 0 and
+ * receives the id once the packet is sent; passing it back resends with that id and DUP (never for QoS 0)
+ */
+static bool mqtt_publish(const char *subtopic, const char *payload, int qos, bool retain, uint16_t *packet_id) {
+    uint8_t body[MQTT_MAX_PACKET];
+    char topic[192];
+    snprintf(topic, sizeof(topic), "%s/%s", mqtt_cfg.topic, subtopic);
+    size_t payload_len = strlen(payload);
+    if (2 + strlen(topic) + 2 + payload_len > sizeof(body)) {
+        return false;
+    }
+    
+    size_t n = mqtt_put_string(body, topic);
+    uint16_t id = 0;
+    bool dup = false;
+    if (qos > 0) {
+        dup = packet_id && *packet_id;
+        id = dup ? *packet_id : (++mqtt_packet_id ? mqtt_packet_id : ++mqtt_packet_id);  // Ids are non-zero
+        body[n++] = (uint8_t)(id >> 8);
+        body[n++] = (uint8_t)id;
+    }
+    memcpy(body + n, payload, payload_len);
+    n += payload_len;
+    uint8_t header = 0x30 | (dup ? 0x08 : 0) | (qos > 0 ? 0x02 : 0) | (retain ? 0x01 : 0);
+    if (!mqtt_send_packet(header, body, n)) {
+        return false;
+    }
+    if (qos == 0) {
+        return true;
+    }
+    if (packet_id) {
+        *packet_id = id;  // On the wire, so a resend is a redelivery
+    }
+    
+    uint64_t deadline = monotonic_us() + MQTT_TIMEOUT_MS * 1000u;
+    for (;;) {
+        uint64_t now = monotonic_us();
+        uint8_t type;
+        uint8_t reply[sizeof(mqtt_rx)];
+        size_t len = 0;
+        int r = now < deadline ? mqtt_read_packet((int)((deadline - now) / 1000 + 1), &type, reply, &len) : 0;
+        if (r < 0) {
+            return false;
+        }
+        if (r == 0) {
+            mqtt_disconnect(false, "no PUBACK");
+            return false;
+        }
+        if ((type & 0xF0) == 0xD0) {
+            mqtt_ping_sent_us = 0;
+        } else if ((type & 0xF0) == 0x40 && len >= 2 && ((reply[0] << 8) | reply[1]) == id) {
+            return true;
+        }
+    }
+}
+
+/**
+ * Open the TCP connection, send CONNECT with an "offline" will, wait for CONNACK and announce "online"
+ */
+static bool mqtt_connect(void) {
+    char host[256], port[8];
+    int port_num = MQTT_PORT;
+    if (sscanf(mqtt_cfg.broker, "%255[^:]:%d", host, &port_num) < 1 || port_num <= 0 || port_num > 65535) {
+        syslog(LOG_ERR, "[MQTT] Invalid broker address: %s", mqtt_cfg.broker);
+        mqtt_next_connect_us = monotonic_us() + MQTT_RECONNECT_MAX_MS * 1000ull;
+        return false;
+    }
+    snprintf(port, sizeof(port), "%d", port_num);
+    
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM }, *addrs = NULL;
+    int fd = -1;
+    if (getaddrinfo(host, port, &hints, &addrs) == 0) {
+        for (struct addrinfo *a = addrs; a && fd < 0; a = a->ai_next) {
+            fd = socket(a->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                continue;
+            }
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+            int err = 0;
+            socklen_t err_len = sizeof(err);
+            if (connect(fd, a->ai_addr, a->ai_addrlen) != 0 &&
+                (errno != EINPROGRESS || poll(&pfd, 1, MQTT_TIMEOUT_MS) <= 0 ||
+                 getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0 || err != 0)) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(addrs);
+    }
+    if (fd < 0) {
+        mqtt_fd = -1;
+        syslog(LOG_WARNING, "[MQTT] Cannot reach broker %s, retrying in %u s", mqtt_cfg.broker, mqtt_backoff_ms / 1000);
+        mqtt_next_connect_us = monotonic_us() + (uint64_t)mqtt_backoff_ms * 1000u;
+        mqtt_backoff_ms = mqtt_backoff_ms * 2 > MQTT_RECONNECT_MAX_MS ? MQTT_RECONNECT_MAX_MS : mqtt_backoff_ms * 2;
+        return false;
+    }
+    mqtt_fd = fd;
+    mqtt_rx_len = 0;
+    
+    // Client id: up to 23 characters, unique per camera
+    char client_id[24], hostname[64] = "";
+    gethostname(hostname, sizeof(hostname) - 1);
+    snprintf(client_id, sizeof(client_id), "gunshot-%s", hostname);
+    char will_topic[192];
+    snprintf(will_topic, sizeof(will_topic), "%s/status", mqtt_cfg.topic);
+    
+    uint8_t body[MQTT_MAX_PACKET];
+    size_t n = mqtt_put_string(body, "MQTT");
+    body[n++] = 4;  // Protocol level 3.1.1
+    uint8_t flags = 0x02 | 0x04 | 0x20;  // Clean session, will, will retained (QoS 0)
+    if (mqtt_cfg.username[0]) flags |= 0x80;
+    if (mqtt_cfg.username[0] && mqtt_cfg.password[0]) flags |= 0x40;
+    body[n++] = flags;
+    body[n++] = MQTT_KEEPALIVE_S >> 8;
+    body[n++] = MQTT_KEEPALIVE_S & 0xFF;
+    n += mqtt_put_string(body + n, client_id);
+    n += mqtt_put_string(body + n, will_topic);
+    n += mqtt_put_string(body + n, "offline");
+    if (flags & 0x80) n += mqtt_put_string(body + n, mqtt_cfg.username);
+    if (flags & 0x40) n += mqtt_put_string(body + n, mqtt_cfg.password);
+    
+    uint8_t type;
+    uint8_t reply[sizeof(mqtt_rx)];
+    size_t len = 0;
+    if (!mqtt_send_packet(0x10, body, n)) {
+        return false;
+    }
+    int r = mqtt_read_packet(MQTT_TIMEOUT_MS, &type, reply, &len);
+    if (r <= 0 || (type & 0xF0) != 0x20 || len < 2 || reply[1] != 0) {
+        if (r > 0) {
+            syslog(LOG_ERR, "[MQTT] Broker %s refused the connection (return code %d)", mqtt_cfg.broker,
+                   len >= 2 ? reply[1] : -1);
+        }
+        if (mqtt_fd >= 0) {
+            mqtt_disconnect(false, r == 0 ? "no CONNACK" : "connection refused");
+        }
+        return false;
+    }
+    
+    syslog(LOG_INFO, "[MQTT] Connected to %s as %s, publishing to %s/#", mqtt_cfg.broker, client_id, mqtt_cfg.topic);
+    mqtt_backoff_ms = MQTT_RECONNECT_MIN_MS;
+    mqtt_last_heartbeat_us = 0;
+    return mqtt_publish("status", "online", 0, true, NULL);
+}
+
+/**
+ * Follow configuration changes; returns false while MQTT is disabled
+ */
+static bool mqtt_refresh_config(void) {
+    struct mqtt_settings cfg;
+    mqtt_settings_snapshot(&cfg);
+    if (memcmp(&cfg, &mqtt_cfg, sizeof(cfg)) != 0) {
+        if (mqtt_fd >= 0) {
+            mqtt_publish("status", "offline", 0, true, NULL);
+            mqtt_disconnect(true, NULL);
+        }
+        mqtt_cfg = cfg;
+        mqtt_backoff_ms = MQTT_RECONNECT_MIN_MS;
+        mqtt_next_connect_us = 0;
+    }
+    return mqtt_cfg.broker[0] != '\0';
+}
+
+/**
+ * Publish the event to <topic>/event; one reconnect and resend if the connection turns out to be dead
+ */
+static enum sink_result mqtt_sink_deliver(const struct detection_event *e, uint32_t *targets) {
+    if (!mqtt_refresh_config()) {
+        return SINK_SKIPPED;
+    }
+    char payload[512];
+    format_event_json(e, payload, sizeof(payload));
+    
+    // While the broker is down the event goes straight to the spool and mqtt_sink_poll() reconnects on its
+    // backoff; a connection lost under the event is reconnected once at once for the resend
+    const bool backing_off = mqtt_fd < 0 && monotonic_us() < mqtt_next_connect_us;
+    uint16_t packet_id = 0;  // Kept for the resend, which then carries DUP
+    for (int attempt = 0; !backing_off && attempt < 2; attempt++) {
+        if (mqtt_fd < 0 && !mqtt_connect()) {
+            break;
+        }
+        if (mqtt_publish("event", payload, mqtt_cfg.qos, false, &packet_id)) {
+            return SINK_DELIVERED;
+        }
+    }
+    syslog(LOG_ERR, "[MQTT] ❌ Event %u not published to %s", e->id, mqtt_cfg.broker);
+    return SINK_FAILED;
+}
+
+/**
+ * Keep-alive, heartbeats and reconnects between events
+ */
+static int mqtt_sink_poll(void) {
+    if (!mqtt_refresh_config()) {
+        return 1000;  // Check the configuration again
+    }
+    uint64_t now = monotonic_us();
+    if (mqtt_fd < 0) {
+        if (now < mqtt_next_connect_us || !mqtt_connect()) {
+            return 1000;
+        }
+        now = monotonic_us();
+    }
+    
+    // Broker traffic between events is PINGRESP (or PUBACKs that arrived after we gave up)
+    uint8_t type;
+    uint8_t reply[sizeof(mqtt_rx)];
+    size_t len = 0;
+    int r;
+    while ((r = mqtt_read_packet(0, &type, reply, &len)) > 0) {
+        if ((type & 0xF0) == 0xD0) {
+            mqtt_ping_sent_us = 0;
+        }
+    }
+    if (r < 0) {
+        return 1000;
+    }
+    if (mqtt_ping_sent_us && now - mqtt_ping_sent_us > MQTT_KEEPALIVE_S * 1000000ull / 2) {
+        mqtt_disconnect(false, "no PINGRESP");
+        return 1000;
+    }
+    
+    if (mqtt_cfg.heartbeat_s > 0 &&
+        (mqtt_last_heartbeat_us == 0 || now - mqtt_last_heartbeat_us >= (uint64_t)mqtt_cfg.heartbeat_s * 1000000u)) {
+        struct gunshot_stats snap;
+        char payload[256];
+        if (!gunshot_stats_read(stats, &snap)) {
+            memset(&snap, 0, sizeof(snap));
+        }
+        snprintf(payload, sizeof(payload),
+                 "{\"time_ms\":%llu,\"uptime_s\":%llu,\"inferences\":%llu,\"events\":%llu,\"event_active\":%u,"
+                 "\"load_level\":\"%s\",\"real_time_factor\":%.3f}",
+                 (unsigned long long)unix_ms(), (unsigned long long)(time(NULL) - (time_t)snap.started_unix),
+                 (unsigned long long)snap.inference_count, (unsigned long long)snap.events_count, snap.event_active,
+                 snap.load_level < GUNSHOT_LOAD_LEVELS ? gunshot_load_level_names[snap.load_level] : "unknown",
+                 snap.real_time_factor);
+        mqtt_last_heartbeat_us = now;
+        if (!mqtt_publish("heartbeat", payload, 0, false, NULL)) {
+            return 1000;
+        }
+    }
+    
+    // PINGREQ when nothing else went out for three quarters of the keep-alive
+    if (!mqtt_ping_sent_us && mqtt_last_send_us + MQTT_KEEPALIVE_S * 750000ull <= now) {
+        static const uint8_t none[1] = { 0 };
+        if (mqtt_send_packet(0xC0, none, 0)) {
+            mqtt_ping_sent_us = now;
+        }
+    }
+    return 1000;
+}
+
+static void mqtt_cleanup(void) {
+    if (mqtt_fd >= 0) {
+        mqtt_publish("status", "offline", 0, true, NULL);
+        mqtt_disconnect(true, NULL);
+    }
+}
+
+static struct event_sink journal_sink = {
+    .name = "journal", .route = EVENT_ROUTE_JOURNAL, .deliver = journal_sink_deliver,
+};
+static struct event_sink email_sink = {
+    .name = "email", .route = EVENT_ROUTE_EMAIL, .deliver = email_sink_deliver, .poll = email_sink_poll,
+    .cleanup = email_sink_cleanup, .holding = email_sink_holding, .spooled = true,
+};
+static struct event_sink webhook_sink = {
+    .name = "webhook", .route = EVENT_ROUTE_WEBHOOK, .deliver = webhook_sink_deliver, .cleanup = webhook_cleanup,
+    .spooled = true,
+};
+static struct event_sink mqtt_sink = {
+    .name = "mqtt", .route = EVENT_ROUTE_MQTT, .deliver = mqtt_sink_deliver, .poll = mqtt_sink_poll,
+    .cleanup = mqtt_cleanup, .spooled = true,
+};
+
+/**
+ * Register the sinks and start one thread each; sinks start at the current bus head
+ */
+static void event_bus_start(void) {
+    struct event_sink *sinks[] = { &journal_sink, &email_sink, &webhook_sink, &mqtt_sink };
+    
+    atomic_store_explicit(&event_bus_running, true, memory_order_release);
+    for (size_t i = 0; i < sizeof(sinks) / sizeof(sinks[0]) && event_sink_count < MAX_EVENT_SINKS; i++) {
+        struct event_sink *sink = sinks[i];
+        sink->cursor = atomic_load_explicit(&event_bus_head, memory_order_acquire);
+        sink->spool_fd = -1;
+        if (sink->spooled) {
+            spool_open(sink);
+        }
+        if (sem_init(&sink->wake, 0, 0) != 0) {
+            syslog(LOG_ERR, "[EVENT] Failed to set up the %s sink: %s", sink->name, strerror(errno));
+            continue;
+        }
+        if (pthread_create(&sink->thread, NULL, event_sink_main, sink) != 0) {
+            syslog(LOG_ERR, "[EVENT] Failed to start the %s sink thread", sink->name);
+            sem_destroy(&sink->wake);
+            continue;
+        }
+        sink->started = true;
+        event_sinks[event_sink_count++] = sink;
+    }
+    syslog(LOG_INFO, "[EVENT] Event bus ready: %zu sinks, %d-event ring", event_sink_count, EVENT_BUS_SLOTS);
+}
+
+/**
+ * Let each sink drain what was published, then join it
+ */
+static void event_bus_stop(void) {
+    atomic_store_explicit(&event_bus_running, false, memory_order_release);
+    for (size_t i = 0; i < event_sink_count; i++) {
+        struct event_sink *sink = event_sinks[i];
+        sem_post(&sink->wake);
+        pthread_join(sink->thread, NULL);
+        sem_destroy(&sink->wake);
+        sink->started = false;
+        if (sink->spool_fd >= 0) {
+            close(sink->spool_fd);
+            sink->spool_fd = -1;
+        }
+        if (sink->spool_count) {
+            syslog(LOG_WARNING, "[SPOOL] %s: %zu alerts still pending, kept for the next start",
+                   sink->name, sink->spool_count);
+        }
+        if (atomic_load_explicit(&sink->dropped, memory_order_relaxed) ||
+            atomic_load_explicit(&sink->failed, memory_order_relaxed)) {
+            syslog(LOG_WARNING, "[EVENT] %s sink: %llu delivered, %llu failed, %llu dropped", sink->name,
+                   (unsigned long long)atomic_load_explicit(&sink->delivered, memory_order_relaxed),
+                   (unsigned long long)atomic_load_explicit(&sink->failed, memory_order_relaxed),
+                   (unsigned long long)atomic_load_explicit(&sink->dropped, memory_order_relaxed));
+        }
+    }
+    event_sink_count = 0;
+}
+
+
+/**
+ * Create and map temporary file for tensor data
+ */
+static bool create_and_map_tmp_file(const char *pattern, size_t size, void **addr, int *fd) {
+    char tmp_file[256];
+    
+    snprintf(tmp_file, sizeof(tmp_file), "%s", pattern);
+    *fd = mkstemp(tmp_file);
+    if (*fd < 0) {
+        syslog(LOG_ERR, "Failed to create temporary file: %s", strerror(errno));
+        return false;
+    }
+    
+    if (ftruncate(*fd, size) != 0) {
+        syslog(LOG_ERR, "Failed to set file size: %s", strerror(errno));
+        close(*fd);
+        *fd = -1;
+        return false;
+    }
+    
+    *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if (*addr == MAP_FAILED) {
+        syslog(LOG_ERR, "Failed to mmap file: %s", strerror(errno));
+        close(*fd);
+        *fd = -1;
+        return false;
+    }
+    
+    unlink(tmp_file);
+    syslog(LOG_DEBUG, "Created temporary tensor file, size: %zu bytes", size);
+    return true;
+}
+
+#ifndef GUNSHOT_FIXED_POINT
+/**
+ * Allocate the FFTW workspace and plan
+ */
+static bool init_fft_workspace(void) {
+    fft_in = fftwf_alloc_complex(N_FFT);
+    fft_out = fftwf_alloc_complex(N_FFT);
+    
+    if (!fft_in || !fft_out) {
+        syslog(LOG_ERR, "[FFT] Failed to allocate FFT workspace");
+        return false;
+    }
+    
+    fft_plan = fftwf_plan_dft_1d(N_FFT, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+    if (!fft_plan) {
+        syslog(LOG_ERR, "[FFT] Failed to create FFT plan");
+        return false;
+    }
+    
+    syslog(LOG_INFO, "[FFT] FFT workspace initialized successfully");
+    return true;
+}
+#endif
+
+#ifdef GUNSHOT_FIXED_POINT
+/**
+ * In-place radix-2 FFT of N_FFT / 2 complex int32 points with Q15 twiddles
+ */
+static void fft_q15_complex(int32_t *re, int32_t *im) {
+    const int n = N_FFT / 2;
+    
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int32_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = N_FFT / len;  // exp(-2*pi*i*k/len) = table[k * N_FFT / len]
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; k++) {
+                int64_t c = fft_cos_q15[k * step];
+                int64_t s = fft_sin_q15[k * step];
+                int32_t br = re[i + k + half];
+                int32_t bi = im[i + k + half];
+                int32_t tr = (int32_t)((br * c + bi * s + (1 << 14)) >> 15);
+                int32_t ti = (int32_t)((bi * c - br * s + (1 << 14)) >> 15);
+                re[i + k + half] = re[i + k] - tr;
+                im[i + k + half] = im[i + k] - ti;
+                re[i + k] += tr;
+                im[i + k] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * One mel frame from N_FFT S16 samples with a Q15 window/FFT and int32 mel accumulation
+ */
+static void compute_mel_frame(const int16_t *frame, float *mel) {
+    const int n2 = N_FFT / 2;
+    uint64_t power_spectrum[N_FFT_BINS];  // 4 * |X|^2 with X in Q(15 + FFT_GUARD_BITS) units
+    
+    // Pack the windowed real frame as N_FFT / 2 complex points
+    for (int i = 0; i < n2; i++) {
+        fft_re[i] = (frame[2 * i] * hann_window_q15[2 * i] + (1 << (14 - FFT_GUARD_BITS))) >> (15 - FFT_GUARD_BITS);
+        fft_im[i] = (frame[2 * i + 1] * hann_window_q15[2 * i + 1] + (1 << (14 - FFT_GUARD_BITS))) >> (15 - FFT_GUARD_BITS);
+    }
+    
+    fft_q15_complex(fft_re, fft_im);
+    
+    // Split into the N_FFT-point real spectrum (values kept doubled to avoid halving)
+    for (int k = 0; k <= n2; k++) {
+        int a = k % n2;
+        int b = (n2 - k) % n2;
+        int64_t fe_r = (int64_t)fft_re[a] + fft_re[b];
+        int64_t fe_i = (int64_t)fft_im[a] - fft_im[b];
+        int64_t fo_r = (int64_t)fft_im[a] + fft_im[b];
+        int64_t fo_i = (int64_t)fft_re[b] - fft_re[a];
+        int64_t c = fft_cos_q15[k];
+        int64_t s = fft_sin_q15[k];
+        int64_t xr = fe_r + ((c * fo_r + s * fo_i + (1 << 14)) >> 15);
+        int64_t xi = fe_i + ((c * fo_i - s * fo_r + (1 << 14)) >> 15);
+        power_spectrum[k] = (uint64_t)(xr * xr) + (uint64_t)(xi * xi);
+    }
+    
+    for (int m = 0; m < N_MELS; m++) {
+        // Per-band block exponent keeps every product and the int32 sum in range
+        uint64_t span_bits = 0;
+        for (int k = mel_bin_start[m]; k < mel_bin_end[m]; k++) {
+            span_bits |= power_spectrum[k];
+        }
+        int shift = span_bits ? 64 - __builtin_clzll(span_bits) - 15 : 0;
+        if (shift < 0) {
+            shift = 0;
+        }
+        
+        uint32_t mel_acc = 0;
+        for (int k = mel_bin_start[m]; k < mel_bin_end[m]; k++) {
+            mel_acc += mel_weights_q15[m][k] * (uint32_t)(power_spectrum[k] >> shift);
+        }
+        
+        // 10*log10 via integer log2, removing Q15 weights, squared sample scale and doubled spectrum
+        float mel_db = -100.0f;
+        if (mel_acc != 0) {
+            int msb = 31 - __builtin_clz(mel_acc);
+            uint32_t mantissa = ((mel_acc << (31 - msb)) >> 23) & 0xFF;
+            mel_db = 3.0103f * (msb + shift - (47 + 2 * FFT_GUARD_BITS) + log2_mantissa[mantissa]);
+            if (mel_db < -100.0f) mel_db = -100.0f;
+        }
+        float mel_normalized = (mel_db - (-80.0f)) / (0.0f - (-80.0f));
+        
+        if (mel_normalized < 0.0f) mel_normalized = 0.0f;
+        if (mel_normalized > 1.0f) mel_normalized = 1.0f;
+        
+        mel[m] = mel_normalized;
+    }
+}
+
+/**
+ * Compute mel-spectrogram from S16 audio, frame by frame
+ */
+static void compute_mel_spectrogram(const int16_t *audio, size_t num_samples, float *output) {
+    memset(output, 0, EXPECTED_INPUT_SIZE * sizeof(float));
+    
+    int frame_count = 0;
+    for (size_t start = 0; start + N_FFT < num_samples && frame_count < N_FRAMES; start += HOP_LENGTH) {
+        compute_mel_frame(audio + start, output + frame_count * N_MELS);
+        frame_count++;
+    }
+    
+    syslog(LOG_INFO, "[MEL] Computed Q15 mel spectrogram: %d frames, %d mels", frame_count, N_MELS);
+}
+#else
+/**
+ * One mel frame from N_FFT samples (librosa-compatible version)
+ */
+static void compute_mel_frame(const float *frame, float *mel) {
+    float power_spectrum[N_FFT_BINS];
+    
+    for (int i = 0; i < N_FFT; i++) {
+        fft_in[i] = frame[i] * hann_window[i];
+    }
+    
+    fftwf_execute(fft_plan);
+    
+    for (int i = 0; i < N_FFT_BINS; i++) {
+        float real = crealf(fft_out[i]);
+        float imag = cimagf(fft_out[i]);
+        power_spectrum[i] = real * real + imag * imag;
+    }
+    
+    for (int m = 0; m < N_MELS; m++) {
+        float mel_energy = 0.0f;
+        for (int k = mel_bin_start[m]; k < mel_bin_end[m]; k++) {
+            mel_energy += mel_filter_bank[m][k] * power_spectrum[k];
+        }
+        
+        float mel_db = 10.0f * log10f(fmaxf(mel_energy, 1e-10f));
+        float mel_normalized = (mel_db - (-80.0f)) / (0.0f - (-80.0f));
+        
+        if (mel_normalized < 0.0f) mel_normalized = 0.0f;
+        if (mel_normalized > 1.0f) mel_normalized = 1.0f;
+        
+        mel[m] = mel_normalized;
+    }
+}
+
+/**
+ * Compute mel-spectrogram for audio, frame by frame
+ */
+static void compute_mel_spectrogram(const float *audio, size_t num_samples, float *output) {
+    memset(output, 0, EXPECTED_INPUT_SIZE * sizeof(float));
+    
+    int frame_count = 0;
+    for (size_t start = 0; start + N_FFT < num_samples && frame_count < N_FRAMES; start += HOP_LENGTH) {
+        compute_mel_frame(audio + start, output + frame_count * N_MELS);
+        frame_count++;
+    }
+    
+    syslog(LOG_INFO, "[MEL] Computed mel spectrogram: %d frames, %d mels", frame_count, N_MELS);
+}
+#endif
+
+// TFLite flatbuffer field indices (schema.fbs) used to read tensor quantization
+#define TFLITE_MODEL_OPERATOR_CODES 1
+#define TFLITE_MODEL_SUBGRAPHS 2
+#define TFLITE_OPCODE_DEPRECATED_BUILTIN 0
+#define TFLITE_OPCODE_BUILTIN 3
+#define TFLITE_SUBGRAPH_TENSORS 0
+#define TFLITE_SUBGRAPH_INPUTS 1
+#define TFLITE_SUBGRAPH_OUTPUTS 2
+#define TFLITE_SUBGRAPH_OPERATORS 3
+#define TFLITE_OPERATOR_OPCODE_INDEX 0
+#define TFLITE_OPERATOR_OUTPUTS 2
+#define TFLITE_TENSOR_QUANTIZATION 4
+#define TFLITE_QUANT_SCALE 2
+#define TFLITE_QUANT_ZERO_POINT 3
+#define TFLITE_BUILTIN_SOFTMAX 25
+
+struct flatbuffer {
+    const uint8_t *data;
+    size_t size;
+};
+
+struct tflite_quantization {
+    bool present;
+    float scale;
+    int64_t zero_point;
+};
+
+struct tflite_io_info {
+    struct tflite_quantization input;
+    struct tflite_quantization output;
+    struct tflite_quantization state_input[MODEL_MAX_STATES];   // Inputs and outputs 1.. of streaming models
+    struct tflite_quantization state_output[MODEL_MAX_STATES];
+    bool output_softmax;
+};
+
+static bool fb_read(const struct flatbuffer *fb, size_t pos, void *out, size_t len) {
+    if (pos > fb->size || len > fb->size - pos) {
+        return false;
+    }
+    memcpy(out, fb->data + pos, len);
+    return true;
+}
+
+/**
+ * Position of a table field, false when the field is absent
+ */
+static bool fb_field(const struct flatbuffer *fb, size_t table, int index, size_t *pos) {
+    int32_t vtable_offset;
+    uint16_t vtable_size, field_offset;
+    if (!fb_read(fb, table, &vtable_offset, sizeof(vtable_offset))) {
+        return false;
+    }
+    size_t vtable = table - (size_t)(int64_t)vtable_offset;
+    if (!fb_read(fb, vtable, &vtable_size, sizeof(vtable_size)) || 4u + 2u * index >= vtable_size ||
+        !fb_read(fb, vtable + 4 + 2 * index, &field_offset, sizeof(field_offset)) || field_offset == 0) {
+        return false;
+    }
+    *pos = table + field_offset;
+    return true;
+}
+
+/**
+ * Follow a uoffset (tables, vectors) stored at pos
+ */
+static bool fb_deref(const struct flatbuffer *fb, size_t pos, size_t *target) {
+    uint32_t offset;
+    if (!fb_read(fb, pos, &offset, sizeof(offset))) {
+        return false;
+    }
+    *target = pos + offset;
+    return *target < fb->size;
+}
+
+/**
+ * Vector field: element count and position of the first element
+ */
+static bool fb_vector(const struct flatbuffer *fb, size_t table, int index, uint32_t *count, size_t *elems) {
+    size_t pos, vector;
+    if (!fb_field(fb, table, index, &pos) || !fb_deref(fb, pos, &vector) ||
+        !fb_read(fb, vector, count, sizeof(*count))) {
+        return false;
+    }
+    *elems = vector + 4;
+    return true;
+}
+
+/**
+ * Table at index i of a vector of tables
+ */
+static bool fb_vector_table(const struct flatbuffer *fb, size_t elems, uint32_t count, uint32_t i, size_t *table) {
+    return i < count && fb_deref(fb, elems + 4 * (size_t)i, table);
+}
+
+static bool tflite_tensor_quantization(const struct flatbuffer *fb, size_t tensors, uint32_t n_tensors,
+                                       int32_t index, struct tflite_quantization *q) {
+    size_t tensor, quant, elems;
+    uint32_t count;
+    
+    q->present = false;
+    if (index < 0 || !fb_vector_table(fb, tensors, n_tensors, (uint32_t)index, &tensor)) {
+        return false;
+    }
+    size_t pos;
+    if (!fb_field(fb, tensor, TFLITE_TENSOR_QUANTIZATION, &pos) || !fb_deref(fb, pos, &quant)) {
+        return true;  // Float tensor
+    }
+    if (fb_vector(fb, quant, TFLITE_QUANT_SCALE, &count, &elems) && count > 0 &&
+        fb_read(fb, elems, &q->scale, sizeof(q->scale))) {
+        q->zero_point = 0;
+        if (fb_vector(fb, quant, TFLITE_QUANT_ZERO_POINT, &count, &elems) && count > 0) {
+            fb_read(fb, elems, &q->zero_point, sizeof(q->zero_point));
+        }
+        q->present = q->scale > 0.0f;
+    }
+    return true;
+}
+
+/**
+ * Read input/output quantization and whether the output comes from a softmax (larod doesn't expose these)
+ */
+static bool tflite_read_io_info(const char *path, struct tflite_io_info *info) {
+    memset(info, 0, sizeof(*info));
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 8) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    
+    struct flatbuffer fb = { map, (size_t)st.st_size };
+    size_t root, subgraph, tensors, elems, inputs, outputs, operators, opcodes;
+    uint32_t n_subgraphs, n_tensors, n_inputs, n_outputs, n_operators, n_opcodes;
+    int32_t input_index = -1, output_index = -1;
+    bool ok = fb_deref(&fb, 0, &root) &&
+              fb_vector(&fb, root, TFLITE_MODEL_SUBGRAPHS, &n_subgraphs, &elems) &&
+              fb_vector_table(&fb, elems, n_subgraphs, 0, &subgraph) &&
+              fb_vector(&fb, subgraph, TFLITE_SUBGRAPH_TENSORS, &n_tensors, &tensors) &&
+              fb_vector(&fb, subgraph, TFLITE_SUBGRAPH_INPUTS, &n_inputs, &inputs) && n_inputs > 0 &&
+              fb_read(&fb, inputs, &input_index, sizeof(input_index)) &&
+              fb_vector(&fb, subgraph, TFLITE_SUBGRAPH_OUTPUTS, &n_outputs, &outputs) && n_outputs > 0 &&
+              fb_read(&fb, outputs, &output_index, sizeof(output_index)) &&
+              tflite_tensor_quantization(&fb, tensors, n_tensors, input_index, &info->input) &&
+              tflite_tensor_quantization(&fb, tensors, n_tensors, output_index, &info->output);
+    
+    // State pairs of streaming models, in the same order larod creates the tensors
+    for (uint32_t i = 1; ok && i < n_inputs && i < n_outputs && i <= MODEL_MAX_STATES; i++) {
+        int32_t state_in = -1, state_out = -1;
+        ok = fb_read(&fb, inputs + 4 * (size_t)i, &state_in, sizeof(state_in)) &&
+             fb_read(&fb, outputs + 4 * (size_t)i, &state_out, sizeof(state_out)) &&
+             tflite_tensor_quantization(&fb, tensors, n_tensors, state_in, &info->state_input[i - 1]) &&
+             tflite_tensor_quantization(&fb, tensors, n_tensors, state_out, &info->state_output[i - 1]);
+    }
+    
+    // Find the operator producing the output tensor and check for SOFTMAX
+    if (ok && fb_vector(&fb, subgraph, TFLITE_SUBGRAPH_OPERATORS, &n_operators, &operators) &&
+        fb_vector(&fb, root, TFLITE_MODEL_OPERATOR_CODES, &n_opcodes, &opcodes)) {
+        for (uint32_t i = 0; i < n_operators; i++) {
+            size_t op, op_outputs, pos, opcode;
+            int32_t out = -1;
+            uint32_t opcode_index = 0, n_op_outputs = 0;
+            if (!fb_vector_table(&fb, operators, n_operators, i, &op) ||
+                !fb_vector(&fb, op, TFLITE_OPERATOR_OUTPUTS, &n_op_outputs, &op_outputs) || n_op_outputs == 0 ||
+                !fb_read(&fb, op_outputs, &out, sizeof(out)) || out != output_index) {
+                continue;
+            }
+            if (fb_field(&fb, op, TFLITE_OPERATOR_OPCODE_INDEX, &pos)) {
+                fb_read(&fb, pos, &opcode_index, sizeof(opcode_index));
+            }
+            if (fb_vector_table(&fb, opcodes, n_opcodes, opcode_index, &opcode)) {
+                int8_t deprecated_code = 0;
+                int32_t builtin_code = 0;
+                if (fb_field(&fb, opcode, TFLITE_OPCODE_DEPRECATED_BUILTIN, &pos)) {
+                    fb_read(&fb, pos, &deprecated_code, sizeof(deprecated_code));
+                }
+                if (fb_field(&fb, opcode, TFLITE_OPCODE_BUILTIN, &pos)) {
+                    fb_read(&fb, pos, &builtin_code, sizeof(builtin_code));
+                }
+                info->output_softmax = (builtin_code > deprecated_code ? builtin_code : deprecated_code) ==
+                                       TFLITE_BUILTIN_SOFTMAX;
+            }
+            break;
+        }
+    }
+    
+    munmap(map, (size_t)st.st_size);
+    return ok;
+}
+
+static const char *tensor_type_name(larodTensorDataType type) {
+    switch (type) {
+    case LAROD_TENSOR_DATA_TYPE_INT8: return "int8";
+    case LAROD_TENSOR_DATA_TYPE_UINT8: return "uint8";
+    case LAROD_TENSOR_DATA_TYPE_FLOAT32: return "float32";
+    default: return "unsupported";
+    }
+}
+
+static size_t tensor_type_size(larodTensorDataType type) {
+    return type == LAROD_TENSOR_DATA_TYPE_FLOAT32 ? sizeof(float) : 1;
+}
+
+/**
+ * Fold the detection threshold into the model's output domain so the per-window decision is one compare
+ */
+static void model_backend_set_threshold(struct model_backend *b) {
+    const float t = b->ownThreshold > 0.0f ? b->ownThreshold : confidence_threshold;
+    
+    if (b->outputSoftmax) {
+        // p2 > t  <=>  q2 > zp + t / scale
+        const float q = floorf(b->outputZeroPoint + t / b->outputScale);
+        b->voteThreshold = t;
+        b->voteThresholdQ = (int32_t)q;
+    } else {
+        // softmax(l)[1] > t  <=>  l2 - l1 > logit(t); the zero point cancels in q2 - q1
+        const float logit = logf(t / (1.0f - t));
+        const float q = floorf(logit / b->outputScale);
+        b->voteThreshold = logit;
+        b->voteThresholdQ = (int32_t)q;
+    }
+    b->thresholdGeneration = threshold_generation;
+}
+
+/**
+ * Write mel features (frame-major, 0..1 over -80..0 dB) into the input tensor in the model's layout and type:
+ * a whole window, or the new frames of a streaming step
+ */
+static void model_write_input(const struct model_backend *b, const float *mel_features) {
+    // Feature x maps to -80 dB .. 0 dB, the range the model was trained on
+    const float db_scale = 80.0f;
+    const float q_mul = db_scale / b->inputScale;
+    const float q_add = b->inputZeroPoint - db_scale / b->inputScale;
+    const int q_min = b->inputType == LAROD_TENSOR_DATA_TYPE_UINT8 ? 0 : -128;
+    const int q_max = b->inputType == LAROD_TENSOR_DATA_TYPE_UINT8 ? 255 : 127;
+    
+    for (int f = 0; f < b->inputFrames; f++) {
+        for (int m = 0; m < N_MELS; m++) {
+            const float x = mel_features[f * N_MELS + m];
+            const int i = b->inputMelMajor ? m * b->inputFrames + f : f * N_MELS + m;
+            
+            if (b->inputType == LAROD_TENSOR_DATA_TYPE_FLOAT32) {
+                ((float *)b->inputTensorAddr)[i] = db_scale * (x - 1.0f);
+                continue;
+            }
+            long q = lrintf(x * q_mul + q_add);
+            if (q < q_min) q = q_min;
+            if (q > q_max) q = q_max;
+            if (b->inputType == LAROD_TENSOR_DATA_TYPE_UINT8) {
+                ((uint8_t *)b->inputTensorAddr)[i] = (uint8_t)q;
+            } else {
+                ((int8_t *)b->inputTensorAddr)[i] = (int8_t)q;
+            }
+        }
+    }
+}
+
+/**
+ * Zero a streaming model's state (the quantized zero for int8/uint8 state), as at the start of a stream
+ */
+static void model_backend_reset_state(struct model_backend *b) {
+    for (size_t i = 0; i < b->numStates; i++) {
+        const struct model_state_tensor *state = &b->states[i];
+        memset(state->inputAddr, tensor_type_size(state->type) == 1 ? (int)(uint8_t)state->zeroPoint : 0,
+               state->size);
+    }
+}
+
+/**
+ * Feed the state a streaming step produced into the next step
+ */
+static void model_backend_carry_state(struct model_backend *b) {
+    for (size_t i = 0; i < b->numStates; i++) {
+        memcpy(b->states[i].inputAddr, b->states[i].outputAddr, b->states[i].size);
+    }
+}
+
+/**
+ * Per-window decision from the output tensor: one integer compare for quantized models.
+ * The gunshot probability is also returned for smoothing and telemetry.
+ */
+static bool model_read_decision(struct model_backend *b, float *probability) {
+    if (b->thresholdGeneration != threshold_generation) {
+        model_backend_set_threshold(b);
+    }
+    
+    if (b->outputType == LAROD_TENSOR_DATA_TYPE_FLOAT32) {
+        const float *out = b->outputTensorAddr;
+        if (b->outputSoftmax) {
+            *probability = out[1];
+            return out[1] > b->voteThreshold;
+        }
+        float diff = out[1] - out[0];
+        *probability = 1.0f / (1.0f + expf(-diff));
+        return diff > b->voteThreshold;
+    }
+    
+    int32_t q1, q2;
+    if (b->outputType == LAROD_TENSOR_DATA_TYPE_UINT8) {
+        q1 = ((const uint8_t *)b->outputTensorAddr)[0];
+        q2 = ((const uint8_t *)b->outputTensorAddr)[1];
+    } else {
+        q1 = ((const int8_t *)b->outputTensorAddr)[0];
+        q2 = ((const int8_t *)b->outputTensorAddr)[1];
+    }
+    if (b->outputSoftmax) {
+        *probability = b->outputScale * (q2 - b->outputZeroPoint);
+        return q2 > b->voteThresholdQ;
+    }
+    *probability = 1.0f / (1.0f + expf(-b->outputScale * (q2 - q1)));
+    return q2 - q1 > b->voteThresholdQ;
+}
+
+/**
+ * State tensors of a streaming model: input i + 1 is fed from output i + 1 of the previous step, so each
+ * pair must match in size, type and quantization
+ */
+static bool model_backend_bind_states(struct model_backend *b, const struct tflite_io_info *info) {
+    larodError *error = NULL;
+    
+    if (b->numOutputs != b->numInputs || b->numInputs - 1 > MODEL_MAX_STATES) {
+        syslog(LOG_ERR, "[MODEL] Streaming model needs one state output per state input (up to %d), has %zu in, %zu out",
+               MODEL_MAX_STATES, b->numInputs, b->numOutputs);
+        return false;
+    }
+    b->numStates = b->numInputs - 1;
+    size_t total = 0;
+    for (size_t i = 0; i < b->numStates; i++) {
+        struct model_state_tensor *state = &b->states[i];
+        size_t in_size = 0, out_size = 0;
+        larodTensorDataType out_type = larodGetTensorDataType(b->outputTensors[i + 1], &error);
+        state->type = larodGetTensorDataType(b->inputTensors[i + 1], &error);
+        if (!larodGetTensorByteSize(b->inputTensors[i + 1], &in_size, &error) ||
+            !larodGetTensorByteSize(b->outputTensors[i + 1], &out_size, &error)) {
+            syslog(LOG_ERR, "[MODEL] Cannot read state tensor %zu size: %s", i, error ? error->msg : "Unknown error");
+            larodClearError(&error);
+            return false;
+        }
+        const struct tflite_quantization *qin = &info->state_input[i], *qout = &info->state_output[i];
+        if (in_size == 0 || in_size != out_size || state->type != out_type ||
+            qin->present != qout->present || (qin->present && (fabsf(qin->scale - qout->scale) > 1e-6f * qin->scale ||
+                                                               qin->zero_point != qout->zero_point))) {
+            syslog(LOG_ERR, "[MODEL] State tensor %zu: input %zu bytes %s, output %zu bytes %s do not match",
+                   i, in_size, tensor_type_name(state->type), out_size, tensor_type_name(out_type));
+            return false;
+        }
+        state->size = in_size;
+        state->zeroPoint = (int32_t)qin->zero_point;
+        total += in_size;
+    }
+    syslog(LOG_INFO, "[MODEL] Streaming model: %d new frame(s) per step, %zu state tensor(s), %zu bytes of state",
+           b->inputFrames, b->numStates, total);
+    return true;
+}
+
+/**
+ * Shapes, types, layout and quantization of the model's input and output
+ */
+static bool model_backend_bind_io(struct model_backend *b) {
+    larodError *error = NULL;
+    const larodTensorDims *in_dims = larodGetTensorDims(b->inputTensors[0], &error);
+    const larodTensorDims *out_dims = in_dims ? larodGetTensorDims(b->outputTensors[0], &error) : NULL;
+    if (!in_dims || !out_dims) {
+        syslog(LOG_ERR, "[MODEL] Cannot read tensor dims: %s", error ? error->msg : "Unknown error");
+        larodClearError(&error);
+        return false;
+    }
+    b->inputType = larodGetTensorDataType(b->inputTensors[0], &error);
+    b->outputType = larodGetTensorDataType(b->outputTensors[0], &error);
+    larodClearError(&error);
+    
+    // Input must hold one N_MELS x N_FRAMES window, or for a streaming model (extra state inputs) up to
+    // STREAM_MAX_FRAMES new frames; the order of the two axes gives the layout
+    size_t in_elems = 1, out_elems = 1;
+    int mel_axis = -1, frame_axis = -1;
+    char in_shape[64] = "", out_shape[64] = "";
+    for (size_t i = 0; i < in_dims->len; i++) {
+        in_elems *= in_dims->dims[i];
+        if (in_dims->dims[i] == N_MELS && mel_axis < 0) mel_axis = (int)i;
+        snprintf(in_shape + strlen(in_shape), sizeof(in_shape) - strlen(in_shape), "%s%zu",
+                 i ? "x" : "", in_dims->dims[i]);
+    }
+    const size_t frames = in_elems / N_MELS;
+    for (size_t i = 0; i < in_dims->len; i++) {
+        if ((int)i != mel_axis && in_dims->dims[i] == frames && frame_axis < 0) frame_axis = (int)i;
+    }
+    for (size_t i = 0; i < out_dims->len; i++) {
+        out_elems *= out_dims->dims[i];
+        snprintf(out_shape + strlen(out_shape), sizeof(out_shape) - strlen(out_shape), "%s%zu",
+                 i ? "x" : "", out_dims->dims[i]);
+    }
+    b->streaming = b->numInputs > 1;
+    if (in_elems % N_MELS != 0 || mel_axis < 0 || frame_axis < 0 || out_elems != 2 ||
+        (b->streaming ? frames > STREAM_MAX_FRAMES : frames != N_FRAMES)) {
+        syslog(LOG_ERR, "[MODEL] Incompatible model: input %s, output %s (need %dx%d mel window, or up to %d "
+               "frames with state tensors, 2 classes)", in_shape, out_shape, N_MELS, N_FRAMES, STREAM_MAX_FRAMES);
+        return false;
+    }
+    if (tensor_type_size(b->inputType) == 1 && b->inputType != LAROD_TENSOR_DATA_TYPE_INT8 &&
+        b->inputType != LAROD_TENSOR_DATA_TYPE_UINT8) {
+        syslog(LOG_ERR, "[MODEL] Unsupported input type %d", b->inputType);
+        return false;
+    }
+    if (tensor_type_size(b->outputType) == 1 && b->outputType != LAROD_TENSOR_DATA_TYPE_INT8 &&
+        b->outputType != LAROD_TENSOR_DATA_TYPE_UINT8) {
+        syslog(LOG_ERR, "[MODEL] Unsupported output type %d", b->outputType);
+        return false;
+    }
+    b->inputMelMajor = mel_axis < frame_axis;
+    b->inputFrames = (int)frames;
+    b->inputTensorSize = frames * N_MELS * tensor_type_size(b->inputType);
+    b->outputTensorSize = 2 * tensor_type_size(b->outputType);
+    
+    // Quantization parameters live only in the .tflite file
+    struct tflite_io_info info;
+    if (!tflite_read_io_info(b->path, &info)) {
+        syslog(LOG_ERR, "[MODEL] Cannot read tensor quantization from %s", b->path);
+        return false;
+    }
+    bool input_quantized = b->inputType != LAROD_TENSOR_DATA_TYPE_FLOAT32;
+    bool output_quantized = b->outputType != LAROD_TENSOR_DATA_TYPE_FLOAT32;
+    if ((input_quantized && !info.input.present) || (output_quantized && !info.output.present)) {
+        syslog(LOG_ERR, "[MODEL] Quantized tensor without quantization parameters in %s", b->path);
+        return false;
+    }
+    b->inputScale = info.input.present ? info.input.scale : 1.0f;
+    b->inputZeroPoint = (int32_t)info.input.zero_point;
+    b->outputScale = info.output.present ? info.output.scale : 1.0f;
+    b->outputZeroPoint = (int32_t)info.output.zero_point;
+    b->outputSoftmax = info.output_softmax;
+    model_backend_set_threshold(b);
+    if (b->streaming && !model_backend_bind_states(b, &info)) {
+        return false;
+    }
+    
+    syslog(LOG_INFO, "[MODEL] Input %s %s (%s), scale %.6f zero point %d",
+           tensor_type_name(b->inputType), in_shape,
+           b->streaming ? "streaming" : b->inputMelMajor ? "mel-major" : "frame-major",
+           b->inputScale, b->inputZeroPoint);
+    syslog(LOG_INFO, "[MODEL] Output %s %s (%s), scale %.6f zero point %d, threshold %.0f%% -> %s %d",
+           tensor_type_name(b->outputType), out_shape, b->outputSoftmax ? "probabilities" : "logits",
+           b->outputScale, b->outputZeroPoint, confidence_threshold * 100.0f,
+           b->outputSoftmax ? "q2 >" : "q2 - q1 >", b->voteThresholdQ);
+    return true;
+}
+
+/**
+ * Default screen: fires on windows whose bands rise well above their own average (impulses)
+ */
+static void init_screen_weights(void) {
+    for (int m = 0; m < N_MELS; m++) {
+        screen_weights[m] = 0.0f;                       // Mean level
+        screen_weights[N_MELS + m] = 40.0f / N_MELS;    // Peak above mean, 0.5 per dB averaged over bands
+    }
+    screen_bias = -6.0f;
+    
+    // Optional trained weights: bias followed by SCREEN_N_WEIGHTS values, whitespace separated
+    FILE *f = fopen(SCREEN_WEIGHTS_PATH, "r");
+    if (!f) {
+        syslog(LOG_INFO, "[CASCADE] Using default screen weights");
+        return;
+    }
+    float values[SCREEN_N_WEIGHTS + 1];
+    int n = 0;
+    while (n < SCREEN_N_WEIGHTS + 1 && fscanf(f, "%f", &values[n]) == 1) {
+        n++;
+    }
+    fclose(f);
+    if (n != SCREEN_N_WEIGHTS + 1) {
+        syslog(LOG_WARNING, "[CASCADE] %s has %d values, expected %d - using defaults",
+               SCREEN_WEIGHTS_PATH, n, SCREEN_N_WEIGHTS + 1);
+        return;
+    }
+    screen_bias = values[0];
+    memcpy(screen_weights, values + 1, sizeof(screen_weights));
+    syslog(LOG_INFO, "[CASCADE] Loaded screen weights from %s", SCREEN_WEIGHTS_PATH);
+}
+
+/**
+ * First cascade stage: logistic score of a linear model over per-band mel statistics
+ */
+static float screen_score(const float *mel_features) {
+    float band_sum[N_MELS] = { 0 };
+    float band_peak[N_MELS] = { 0 };
+    
+    for (int f = 0; f < N_FRAMES; f++) {
+        const float *frame = mel_features + f * N_MELS;
+        for (int m = 0; m < N_MELS; m++) {
+            band_sum[m] += frame[m];
+            band_peak[m] = fmaxf(band_peak[m], frame[m]);
+        }
+    }
+    
+    float logit = screen_bias;
+    for (int m = 0; m < N_MELS; m++) {
+        float mean = band_sum[m] * (1.0f / N_FRAMES);
+        logit += screen_weights[m] * mean + screen_weights[N_MELS + m] * (band_peak[m] - mean);
+    }
+    return 1.0f / (1.0f + expf(-logit));
+}
+
+/**
+ * RMS of a window in full-scale units
+ */
+static float window_rms(const sample_t *audio_samples, size_t num_samples) {
+#ifdef GUNSHOT_FIXED_POINT
+    int64_t sum_squares = 0;
+    for (size_t i = 0; i < num_samples; i++) {
+        sum_squares += audio_samples[i] * audio_samples[i];
+    }
+    return sqrtf((float)sum_squares / num_samples) / 32768.0f;
+#else
+    float rms = 0.0f;
+    for (size_t i = 0; i < num_samples; i++) {
+        rms += audio_samples[i] * audio_samples[i];
+    }
+    return sqrtf(rms / num_samples);
+#endif
+}
+
+/**
+ * Peak absolute sample of a window in full-scale units
+ */
+static float window_peak(const sample_t *audio_samples, size_t num_samples) {
+#ifdef GUNSHOT_FIXED_POINT
+    int32_t peak = 0;
+    for (size_t i = 0; i < num_samples; i++) {
+        int32_t v = audio_samples[i] < 0 ? -audio_samples[i] : audio_samples[i];
+        if (v > peak) peak = v;
+    }
+    return peak / 32768.0f;
+#else
+    float peak = 0.0f;
+    for (size_t i = 0; i < num_samples; i++) {
+        peak = fmaxf(peak, fabsf(audio_samples[i]));
+    }
+    return peak;
+#endif
+}
+
+/**
+ * Mel features of consecutive frames starting at a stream position, reusing frames already in the ring.
+ * Returns how many came from the ring
+ */
+static int ring_mel_frames(const sample_t *audio, uint64_t position, int frames, float *output) {
+    int reused = 0;
+    for (int f = 0; f < frames; f++) {
+        const uint64_t frame_position = position + (uint64_t)f * HOP_LENGTH;
+        struct mel_frame *slot = &mel_ring[(frame_position / HOP_LENGTH) & (MEL_RING_FRAMES - 1)];
+        if (slot->tag == frame_position + 1) {
+            reused++;
+        } else {
+            compute_mel_frame(audio + f * HOP_LENGTH, slot->mel);
+            slot->tag = frame_position + 1;
+        }
+        memcpy(output + f * N_MELS, slot->mel, sizeof(slot->mel));
+    }
+    mel_frames_computed += frames - reused;
+    mel_frames_reused += reused;
+    return reused;
+}
+
+/**
+ * Mel features of the window starting at a stream position
+ */
+static void window_mel(const sample_t *window, uint64_t position, float *output) {
+    int reused = ring_mel_frames(window, position, N_FRAMES, output);
+    syslog(LOG_DEBUG, "[MEL] Window mel: %d of %d frames from the ring", reused, N_FRAMES);
+}
+
+/**
+ * Analyse one window: silence gate, mel, cascade screen, full model, cut short at the current
+ * load-shedding level. Returns the gunshot probability
+ */
+static float analyse_window(const sample_t *audio_samples, size_t num_samples, uint64_t position,
+                            float *rms_out, bool *vote_out) {
+    // Calculate RMS to check if audio is too quiet
+    float rms = window_rms(audio_samples, num_samples);
+    *rms_out = rms;
+    *vote_out = false;
+    window_mel_valid = false;
+    
+    // Skip inference on very quiet audio to prevent false positives
+    if (rms < MIN_RMS_THRESHOLD) {
+        syslog(LOG_DEBUG, "[SILENCE] Skipping inference on quiet audio (RMS: %.6f < %.6f)", rms, MIN_RMS_THRESHOLD);
+        gunshot_stats_write_begin(stats);
+        stats->windows_gated++;
+        stats->updated_unix_ms = unix_ms();
+        gunshot_stats_write_end(stats);
+        return 0.0f;
+    }
+    
+    // Energy-only level: no mel, a sharp peak over the window's RMS stands in for the model
+    if (load_level == GUNSHOT_LOAD_ENERGY_ONLY) {
+        float crest = window_peak(audio_samples, num_samples) / rms;
+        *vote_out = crest >= ENERGY_ONLY_CREST;
+        if (*vote_out) {
+            detection_count++;
+            gunshot_stats_write_begin(stats);
+            stats->detection_count = detection_count;
+            stats->updated_unix_ms = unix_ms();
+            gunshot_stats_write_end(stats);
+        }
+        syslog(LOG_DEBUG, "[LOAD] Energy-only window: crest %.1f (impulse at %.1f, RMS: %.3f)",
+               crest, ENERGY_ONLY_CREST, rms);
+        return *vote_out ? 1.0f : 0.0f;
+    }
+    
+    // Compute mel spectrogram (kept after the window for the event's clip)
+    uint64_t t_start = monotonic_us();
+    float *mel_features = window_mel_features;
+    window_mel(audio_samples, position, mel_features);
+    window_mel_valid = true;
+    uint64_t t_mel = monotonic_us();
+    
+    // First cascade stage: only promising windows pay for the full model
+    float screen = screen_score(mel_features);
+    uint64_t t_screen = monotonic_us();
+    if (screen < cascade_threshold) {
+        syslog(LOG_DEBUG, "[CASCADE] Screened out window (score %.1f%% < %.0f%%)",
+               screen * 100.0f, cascade_threshold * 100.0f);
+        gunshot_stats_write_begin(stats);
+        stats->windows_screened_out++;
+        stats_record_latency(GUNSHOT_STAGE_MEL, t_mel - t_start);
+        stats_record_latency(GUNSHOT_STAGE_SCREEN, t_screen - t_mel);
+        stats->updated_unix_ms = unix_ms();
+        gunshot_stats_write_end(stats);
+        return 0.0f;
+    }
+    
+    // Cascade-only level: the screen score stands in for the model
+    if (load_level == GUNSHOT_LOAD_CASCADE_ONLY) {
+        *vote_out = screen > confidence_threshold;
+        if (*vote_out) {
+            detection_count++;
+        }
+        gunshot_stats_write_begin(stats);
+        stats->detection_count = detection_count;
+        stats->last_confidence = screen * 100.0f;
+        stats_record_latency(GUNSHOT_STAGE_MEL, t_mel - t_start);
+        stats_record_latency(GUNSHOT_STAGE_SCREEN, t_screen - t_mel);
+        stats->updated_unix_ms = unix_ms();
+        gunshot_stats_write_end(stats);
+        syslog(LOG_INFO, "%s [CAMERA] Gunshot (screen only): %.1f%% (thresh: %.0f%%, RMS: %.3f)",
+               *vote_out ? "🔫" : "❌", screen * 100.0f, confidence_threshold * 100.0f, rms);
+        return screen;
+    }
+    
+    // Quantize straight into tensor memory, in the model's layout
+    struct model_backend *backend = active_backend;
+    model_write_input(backend, mel_features);
+    uint64_t t_quantize = monotonic_us();
+    
+    // Run inference
+    larodError *error = NULL;
+    bool job_ok = larodRunJob(backend->conn, backend->infReq, &error);
+    uint64_t t_inference = monotonic_us();
+    histogram_observe(&inference_latency_hist, t_inference - t_quantize);
+    
+    if (!job_ok) {
+        syslog(LOG_ERR, "Failed to run inference: %s", error ? error->msg : "Unknown error");
+        larodClearError(&error);
+        return 0.0f;
+    }
+    
+    // Read results
+    float probability = 0.0f;
+    bool vote = model_read_decision(backend, &probability);
+    float gunshot_confidence = probability * 100.0f;
+    *vote_out = vote;
+    
+    inference_count++;
+    if (vote) {
+        detection_count++;
+    }
+    
+    gunshot_stats_write_begin(stats);
+    stats->inference_count = inference_count;
+    stats->detection_count = detection_count;
+    stats->last_confidence = gunshot_confidence;
+    stats->threshold = confidence_threshold * 100.0f;
+    stats_record_latency(GUNSHOT_STAGE_MEL, t_mel - t_start);
+    stats_record_latency(GUNSHOT_STAGE_SCREEN, t_screen - t_mel);
+    stats_record_latency(GUNSHOT_STAGE_QUANTIZE, t_quantize - t_screen);
+    stats_record_latency(GUNSHOT_STAGE_INFERENCE, t_inference - t_quantize);
+    stats->updated_unix_ms = unix_ms();
+    gunshot_stats_write_end(stats);
+    
+    syslog(LOG_INFO, "%s [CAMERA] Gunshot: %.1f%% (thresh: %.0f%%, RMS: %.3f)", 
+           vote ? "🔫" : "❌",
+           gunshot_confidence, confidence_threshold * 100.0f, rms);
+    
+    larodClearError(&error);
+    return probability;
+}
+
+/**
+ * Feed one window's probability into the decision engine (O(1) state, no per-window history).
+ * The window is the audio the score covers: a full window, or a streaming model's step
+ */
+static enum decision_result decision_update(struct decision_state *d, float threshold, float probability, bool vote,
+                                            float rms, uint64_t window_start_ms, uint64_t window_end_ms,
+                                            uint32_t stride) {
+    const uint32_t mask = vote_n >= MAX_VOTE_WINDOWS ? UINT32_MAX : (1u << vote_n) - 1;
+    const float release = threshold - release_margin / 100.0f;
+    
+    // A positive window after n quiet ones opens a new run; the event starts where the run did
+    if (vote && (d->votes & mask) == 0 && !d->active) {
+        d->run_start_ms = window_start_ms;
+    }
+    d->votes = (d->votes << 1) | vote;
+    
+    // Smoothing time constant of one window, whatever the stride
+    d->smoothed += ((float)stride / WINDOW_SAMPLES) * (probability - d->smoothed);
+    
+    if (!d->active) {
+        if (__builtin_popcount(d->votes & mask) < vote_k) {
+            return DECISION_NONE;
+        }
+        d->active = true;
+        d->start_ms = d->run_start_ms;
+        d->end_ms = window_end_ms;
+        d->peak = probability;
+        d->peak_ms = window_end_ms;
+        d->peak_rms = rms;
+        d->windows = 1;
+        return DECISION_EVENT_START;
+    }
+    
+    d->windows++;
+    if (probability > d->peak) {
+        d->peak = probability;
+        d->peak_ms = window_end_ms;
+        d->peak_rms = rms;
+    }
+    if (probability >= release) {
+        d->end_ms = window_end_ms;
+    }
+    
+    // Hysteresis: stay in the event until both the raw and smoothed confidence fall below release
+    if (!vote && d->smoothed < release) {
+        d->active = false;
+        d->votes = 0;
+        return DECISION_EVENT_END;
+    }
+    return DECISION_NONE;
+}
+
+/**
+ * Whether a window's score is too close to the threshold to trust on its own
+ */
+static bool confirm_wanted(float probability) {
+    return confirm_margin > 0 && load_level == GUNSHOT_LOAD_FULL &&
+           fabsf(probability - confidence_threshold) < confirm_margin / 100.0f;
+}
+
+/**
+ * One extra full-model pass for a confirmation burst; returns false if inference failed
+ */
+static bool confirm_infer(const sample_t *window, uint64_t position, float *probability, bool *vote) {
+    float mel_features[EXPECTED_INPUT_SIZE];
+    window_mel(window, position, mel_features);
+    
+    struct model_backend *backend = active_backend;
+    model_write_input(backend, mel_features);
+    larodError *error = NULL;
+    uint64_t t_quantize = monotonic_us();
+    if (!larodRunJob(backend->conn, backend->infReq, &error)) {
+        syslog(LOG_ERR, "[CONFIRM] Inference failed: %s", error ? error->msg : "Unknown error");
+        larodClearError(&error);
+        return false;
+    }
+    histogram_observe(&inference_latency_hist, monotonic_us() - t_quantize);
+    confirm_inferences++;
+    *vote = model_read_decision(backend, probability);
+    return true;
+}
+
+/**
+ * Re-run an ambiguous window shifted by up to CONFIRM_SHIFT_HOPS hops either way (shifts whose audio
+ * has already left the buffer are skipped). Returns the burst's mean probability; the vote is its majority
+ */
+static float confirm_burst(const sample_t *buffer, uint64_t buffer_start, const struct confirm_state *c,
+                           bool *vote_out) {
+    const uint64_t base = c->window_end - WINDOW_SAMPLES;
+    float sum = c->probability;
+    int windows = 1;
+    int votes = c->vote;
+    
+    for (int k = -CONFIRM_SHIFT_HOPS; k <= CONFIRM_SHIFT_HOPS; k += CONFIRM_STEP_HOPS) {
+        const uint64_t offset = (uint64_t)abs(k) * HOP_LENGTH;
+        if (k == 0 || (k < 0 && base < buffer_start + offset) || (k > 0 && c->window_end + offset > samples_total)) {
+            continue;
+        }
+        const uint64_t start = k < 0 ? base - offset : base + offset;
+        float probability = 0.0f;
+        bool vote = false;
+        if (confirm_infer(buffer + (start - buffer_start), start, &probability, &vote)) {
+            sum += probability;
+            votes += vote;
+            windows++;
+        }
+    }
+    
+    *vote_out = 2 * votes > windows;
+    confirm_bursts++;
+    if (*vote_out != c->vote) {
+        confirm_overturned++;
+    }
+    syslog(LOG_INFO, "[CONFIRM] Window at %.1f%% re-run on %d shifted windows: %d of %d positive, mean %.1f%% -> %s%s",
+           c->probability * 100.0f, windows - 1, votes, windows, sum / windows * 100.0f,
+           *vote_out ? "positive" : "negative", *vote_out != c->vote ? " (overturned)" : "");
+    return sum / windows;
+}
+
+/**
+ * Feed the score of the span samples ending at window_end into a decision engine and publish what it decides;
+ * event ids are shared by all heads
+ */
+static enum decision_result decide_and_publish(struct decision_state *d, const char *label, uint32_t routes,
+                                               float threshold, const sample_t *audio_samples, size_t num_samples,
+                                               uint64_t window_end, uint32_t span, float probability, bool vote,
+                                               float rms, uint32_t stride) {
+    const uint64_t window_start = window_end > span ? window_end - span : 0;
+    enum decision_result result = decision_update(d, threshold, probability, vote, rms, stream_time_ms(window_start),
+                                                  stream_time_ms(window_end), stride);
+    
+    // Reactions (log, email, ...) run on the sink threads; the bus never makes this thread wait
+    if (result != DECISION_NONE) {
+        if (result == DECISION_EVENT_START) {
+            event_count++;
+        }
+        struct detection_event e = {
+            .kind = result == DECISION_EVENT_START ? DETECTION_EVENT_OPENED : DETECTION_EVENT_CLOSED,
+            .id = event_count,
+            .routes = routes,
+            .time_ms = unix_ms(),
+            .start_ms = d->start_ms,
+            .end_ms = d->end_ms,
+            .peak_ms = d->peak_ms,
+            .confidence = probability,
+            .rms = rms,
+            .peak = d->peak,
+            .peak_rms = d->peak_rms,
+            .windows = d->windows,
+            .threshold = threshold,
+            .vote_k = vote_k,
+            .vote_n = vote_n,
+            .load_level = load_level,
+        };
+        snprintf(e.label, sizeof(e.label), "%s", label);
+        if (result == DECISION_EVENT_START && email_attach_clip && audio_samples && (routes & EVENT_ROUTE_EMAIL)) {
+            clip_stage(&e, audio_samples, num_samples);
+        }
+        event_bus_publish(&e);
+    }
+    return result;
+}
+
+/**
+ * Feed one analysed window (or streaming step of span samples) into the gunshot decision engine and publish
+ * what it decides
+ */
+static bool process_gunshot_detection(const sample_t *audio_samples, size_t num_samples, uint64_t window_end,
+                                      uint32_t span, float probability, bool vote, float rms, uint32_t stride) {
+    enum decision_result result = decide_and_publish(&decision, PRIMARY_LABEL, EVENT_ROUTE_ALL, confidence_threshold,
+                                                     audio_samples, num_samples, window_end, span, probability, vote,
+                                                     rms, stride);
+    if (result == DECISION_EVENT_START) {
+        gunshot_event_count++;
+    }
+    
+    gunshot_stats_write_begin(stats);
+    stats->events_count = gunshot_event_count;
+    stats->event_active = decision.active;
+    stats->smoothed_confidence = decision.smoothed * 100.0f;
+    gunshot_stats_write_end(stats);
+    
+    return result == DECISION_EVENT_START;
+}
+
+/**
+ * Release everything a model backend owns (safe on partially loaded backends)
+ */
+static void model_backend_destroy(struct model_backend *b) {
+    larodError *error = NULL;
+    
+    if (!b) {
+        return;
+    }
+    larodDestroyJobRequest(&b->infReq);
+    if (b->inputTensors) {
+        larodDestroyTensors(b->conn, &b->inputTensors, b->numInputs, &error);
+        larodClearError(&error);
+    }
+    if (b->outputTensors) {
+        larodDestroyTensors(b->conn, &b->outputTensors, b->numOutputs, &error);
+        larodClearError(&error);
+    }
+    larodDestroyModel(&b->model);
+    if (b->conn) {
+        larodDisconnect(&b->conn, &error);
+        larodClearError(&error);
+    }
+    if (b->inputTensorAddr) munmap(b->inputTensorAddr, b->inputTensorSize);
+    if (b->outputTensorAddr) munmap(b->outputTensorAddr, b->outputTensorSize);
+    if (b->inputTensorFd >= 0) close(b->inputTensorFd);
+    if (b->outputTensorFd >= 0) close(b->outputTensorFd);
+    for (size_t i = 0; i < b->numStates; i++) {
+        struct model_state_tensor *state = &b->states[i];
+        if (state->inputAddr) munmap(state->inputAddr, state->size);
+        if (state->outputAddr) munmap(state->outputAddr, state->size);
+        if (state->inputFd >= 0) close(state->inputFd);
+        if (state->outputFd >= 0) close(state->outputFd);
+    }
+    free(b);
+}
+
+/**
+ * Load a model with its own LAROD connection, tensors and job request (from v1.1.78 working model)
+ */
+static struct model_backend *model_backend_load(const char *path) {
+    larodError *error = NULL;
+    
+    syslog(LOG_INFO, "[MODEL] Loading LAROD model: %s", path);
+    
+    struct model_backend *b = calloc(1, sizeof(*b));
+    if (!b) {
+        return NULL;
+    }
+    b->inputTensorFd = -1;
+    b->outputTensorFd = -1;
+    for (int i = 0; i < MODEL_MAX_STATES; i++) {
+        b->states[i].inputFd = -1;
+        b->states[i].outputFd = -1;
+    }
+    snprintf(b->path, sizeof(b->path), "%s", path);
+    
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        b->mtime = st.st_mtime;
+    }
+    
+    if (!larodConnect(&b->conn, &error)) {
+        syslog(LOG_ERR, "Failed to connect to LAROD: %s", error->msg);
+        goto fail;
+    }
+    
+    b->dev = larodGetDevice(b->conn, "cpu-tflite", 0, &error);
+    if (!b->dev) {
+        syslog(LOG_ERR, "CPU-tflite device not available: %s", error->msg);
+        goto fail;
+    }
+    
+    int modelFd = open(path, O_RDONLY);
+    if (modelFd < 0) {
+        syslog(LOG_ERR, "Failed to open model file: %s", path);
+        goto fail;
+    }
+    
+    b->model = larodLoadModel(b->conn, modelFd, b->dev, LAROD_ACCESS_PRIVATE, 
+                              "GunShotModel", NULL, &error);
+    close(modelFd);
+    
+    if (!b->model) {
+        syslog(LOG_ERR, "Failed to load model: %s", error->msg);
+        goto fail;
+    }
+    
+    // Create model tensors
+    b->inputTensors = larodCreateModelInputs(b->model, &b->numInputs, &error);
+    if (!b->inputTensors || b->numInputs < 1) {
+        syslog(LOG_ERR, "Failed to create input tensors");
+        goto fail;
+    }
+    
+    b->outputTensors = larodCreateModelOutputs(b->model, &b->numOutputs, &error);
+    if (!b->outputTensors || b->numOutputs < 1) {
+        syslog(LOG_ERR, "Failed to create output tensors");
+        goto fail;
+    }
+    
+    // Shapes, layout and quantization decide how windows are written and outputs compared
+    if (!model_backend_bind_io(b)) {
+        goto fail;
+    }
+    
+    // Create temporary files for tensors
+    if (!create_and_map_tmp_file("/tmp/gunshot_input_XXXXXX", b->inputTensorSize, 
+                                 &b->inputTensorAddr, &b->inputTensorFd)) {
+        goto fail;
+    }
+    
+    if (!create_and_map_tmp_file("/tmp/gunshot_output_XXXXXX", b->outputTensorSize, 
+                                 &b->outputTensorAddr, &b->outputTensorFd)) {
+        goto fail;
+    }
+    
+    // Associate file descriptors with tensors
+    if (!larodSetTensorFd(b->inputTensors[0], b->inputTensorFd, &error)) {
+        syslog(LOG_ERR, "Failed to set input tensor fd: %s", error->msg);
+        goto fail;
+    }
+    
+    if (!larodSetTensorFd(b->outputTensors[0], b->outputTensorFd, &error)) {
+        syslog(LOG_ERR, "Failed to set output tensor fd: %s", error->msg);
+        goto fail;
+    }
+    
+    // Streaming models: each state input and output gets its own mapping
+    for (size_t i = 0; i < b->numStates; i++) {
+        struct model_state_tensor *state = &b->states[i];
+        if (!create_and_map_tmp_file("/tmp/gunshot_state_in_XXXXXX", state->size, &state->inputAddr,
+                                     &state->inputFd) ||
+            !create_and_map_tmp_file("/tmp/gunshot_state_out_XXXXXX", state->size, &state->outputAddr,
+                                     &state->outputFd)) {
+            goto fail;
+        }
+        if (!larodSetTensorFd(b->inputTensors[i + 1], state->inputFd, &error) ||
+            !larodSetTensorFd(b->outputTensors[i + 1], state->outputFd, &error)) {
+            syslog(LOG_ERR, "Failed to set state tensor fd: %s", error ? error->msg : "Unknown error");
+            goto fail;
+        }
+    }
+    model_backend_reset_state(b);
+    
+    // Create job request
+    b->infReq = larodCreateJobRequest(b->model, b->inputTensors, b->numInputs, 
+                                      b->outputTensors, b->numOutputs, NULL, &error);
+    if (!b->infReq) {
+        syslog(LOG_ERR, "Failed to create job request: %s", error->msg);
+        goto fail;
+    }
+    
+    return b;
+    
+fail:
+    larodClearError(&error);
+    model_backend_destroy(b);
+    return NULL;
+}
+
+/**
+ * Prepare the canned window used to warm up and sanity check a model (silence)
+ */
+static void init_canned_window(void) {
+    static const sample_t silence[WINDOW_SAMPLES];
+    
+    compute_mel_spectrogram(silence, WINDOW_SAMPLES, canned_window_features);
+}
+
+/**
+ * Warm up a freshly loaded model and check it behaves on the canned window
+ */
+static bool model_backend_verify(struct model_backend *b) {
+    larodError *error = NULL;
+    uint64_t latency_us = 0;
+    
+    // First run pays for lazy allocation inside the runtime; the second is representative
+    for (int run = 0; run < 2; run++) {
+        model_write_input(b, canned_window_features);
+        uint64_t t0 = monotonic_us();
+        if (!larodRunJob(b->conn, b->infReq, &error)) {
+            syslog(LOG_ERR, "[MODEL] Warm-up inference failed: %s", error ? error->msg : "Unknown error");
+            larodClearError(&error);
+            return false;
+        }
+        latency_us = monotonic_us() - t0;
+    }
+    
+    float confidence = 0.0f;
+    bool fires = model_read_decision(b, &confidence);
+    syslog(LOG_INFO, "[MODEL] Warm-up done: %llu us per inference, silence confidence %.1f%%",
+           (unsigned long long)latency_us, confidence * 100.0f);
+    
+    model_backend_reset_state(b);
+    
+    if (!isfinite(confidence) || fires) {
+        syslog(LOG_ERR, "[MODEL] Sanity check failed: model fires on silence (%.1f%%)", confidence * 100.0f);
+        return false;
+    }
+    // A window model has a window of audio per inference, a streaming one only its step
+    const uint64_t budget_samples = b->streaming ? (uint64_t)b->inputFrames * HOP_LENGTH : WINDOW_SAMPLES;
+    if (latency_us > 1000000ULL * budget_samples / TARGET_SAMPLE_RATE) {
+        syslog(LOG_ERR, "[MODEL] Sanity check failed: %llu us per inference cannot keep up with audio",
+               (unsigned long long)latency_us);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Background loader: load, warm up and verify, then stage for the audio thread
+ */
+static void *model_loader_main(void *arg) {
+    char *path = arg;
+    struct model_backend *b = model_backend_load(path);
+    
+    if (b && model_backend_verify(b)) {
+        b->generation = ++model_generation;
+        struct model_backend *stale = atomic_exchange(&staged_backend, b);
+        model_backend_destroy(stale);  // A newer model overtook one that never went live
+        syslog(LOG_INFO, "[MODEL] Generation %u staged, switching at next window boundary", b->generation);
+    } else {
+        model_backend_destroy(b);
+        atomic_fetch_add_explicit(&model_reload_failures, 1, memory_order_relaxed);
+        syslog(LOG_ERR, "[MODEL] Reload of %s rejected, keeping current model", path);
+    }
+    
+    free(path);
+    atomic_store(&model_loading, false);
+    return NULL;
+}
+
+/**
+ * Start a background model reload unless one is already in flight
+ */
+static void request_model_reload(const char *reason) {
+    if (atomic_exchange(&model_loading, true)) {
+        return;
+    }
+    
+    struct stat st;
+    snprintf(model_attempt_path, sizeof(model_attempt_path), "%s", model_path);
+    model_attempt_mtime = stat(model_path, &st) == 0 ? st.st_mtime : 0;
+    syslog(LOG_INFO, "[MODEL] Reload requested (%s): %s", reason, model_path);
+    
+    pthread_t thread;
+    pthread_attr_t attr;
+    char *path = strdup(model_path);
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (!path || pthread_create(&thread, &attr, model_loader_main, path) != 0) {
+        syslog(LOG_ERR, "[MODEL] Failed to start model loader thread");
+        free(path);
+        atomic_store(&model_loading, false);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ * Touch every page of a buffer and pin it in RAM; returns the bytes locked
+ */
+static size_t realtime_lock(const char *name, const void *addr, size_t len, bool writable) {
+    if (!addr || len == 0) {
+        return 0;
+    }
+    
+    // Writes break copy-on-write of zero pages too, so the first real store doesn't fault either
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    volatile uint8_t *p = (volatile uint8_t *)(uintptr_t)addr;
+    for (size_t off = 0; off < len; off += page) {
+        if (writable) {
+            p[off] = p[off];
+        } else {
+            (void)p[off];
+        }
+    }
+    
+    if (mlock(addr, len) != 0) {
+        syslog(LOG_WARNING, "[RT] mlock of %s (%zu bytes) failed: %s", name, len, strerror(errno));
+        return 0;
+    }
+    return len;
+}
+
+/**
+ * Pin a model's tensor buffers (no-op unless real-time mode is active)
+ */
+static void realtime_lock_backend(const struct model_backend *b) {
+    if (realtime_active && b) {
+        realtime_lock("input tensor", b->inputTensorAddr, b->inputTensorSize, true);
+        realtime_lock("output tensor", b->outputTensorAddr, b->outputTensorSize, true);
+        for (size_t i = 0; i < b->numStates; i++) {
+            realtime_lock("state input", b->states[i].inputAddr, b->states[i].size, true);
+            realtime_lock("state output", b->states[i].outputAddr, b->states[i].size, true);
+        }
+    }
+}
+
+/**
+ * Denormals flushed to zero, in and out: quiet audio must not drop into slow subnormal arithmetic
+ */
+static bool enable_flush_to_zero(void) {
+#if defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr |= 1ULL << 24;  // FZ
+    __asm__ volatile("msr fpcr, %0" : : "r"(fpcr));
+    return true;
+#elif defined(__x86_64__)
+    uint32_t mxcsr;
+    __asm__ volatile("stmxcsr %0" : "=m"(mxcsr));
+    mxcsr |= 0x8040;  // FTZ | DAZ
+    __asm__ volatile("ldmxcsr %0" : : "m"(mxcsr));
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Real-time mode for the calling (analysis) thread: pin and pre-fault the pipeline, then raise priority
+ */
+static void realtime_setup(void) {
+    size_t locked = 0;
+    
+    locked += realtime_lock("audio buffer", audio_buffer, sizeof(audio_buffer), true);
+    locked += realtime_lock("conversion chain", &capture_chain, sizeof(capture_chain), true);
+    locked += realtime_lock("chain scratch", chain_scratch, sizeof(chain_scratch), true);
+    locked += realtime_lock("chain output", chain_resampled, sizeof(chain_resampled), true);
+    locked += realtime_lock("window mel", window_mel_features, sizeof(window_mel_features), true);
+    locked += realtime_lock("mel ring", mel_ring, sizeof(mel_ring), true);
+    if (email_attach_clip) {
+        locked += realtime_lock("clip staging", clip_slots, sizeof(clip_slots), true);
+    }
+    locked += realtime_lock("mel spans", mel_bin_start, sizeof(mel_bin_start), false);
+    locked += realtime_lock("mel spans", mel_bin_end, sizeof(mel_bin_end), false);
+#ifdef GUNSHOT_FIXED_POINT
+    locked += realtime_lock("FFT workspace", fft_re, sizeof(fft_re), true);
+    locked += realtime_lock("FFT workspace", fft_im, sizeof(fft_im), true);
+    locked += realtime_lock("window", hann_window_q15, sizeof(hann_window_q15), false);
+    locked += realtime_lock("twiddles", fft_cos_q15, sizeof(fft_cos_q15), false);
+    locked += realtime_lock("twiddles", fft_sin_q15, sizeof(fft_sin_q15), false);
+    locked += realtime_lock("mel weights", mel_weights_q15, sizeof(mel_weights_q15), false);
+    locked += realtime_lock("log2 table", log2_mantissa, sizeof(log2_mantissa), false);
+#else
+    locked += realtime_lock("FFT input", fft_in, N_FFT * sizeof(fftwf_complex), true);
+    locked += realtime_lock("FFT output", fft_out, N_FFT * sizeof(fftwf_complex), true);
+    locked += realtime_lock("window", hann_window, sizeof(hann_window), false);
+    locked += realtime_lock("mel bank", mel_filter_bank, sizeof(mel_filter_bank), false);
+#endif
+    
+    // Stack for the mel features, spectra and quantization below this frame
+    uint8_t stack_reserve[64 * 1024];
+    locked += realtime_lock("analysis stack", stack_reserve, sizeof(stack_reserve), true);
+    
+    realtime_active = true;
+    realtime_lock_backend(active_backend);
+    
+    bool ftz = enable_flush_to_zero();
+    
+    if (realtime_cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(realtime_cpu, &cpus);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (err != 0) {
+            syslog(LOG_WARNING, "[RT] Cannot pin analysis thread to CPU %d: %s", realtime_cpu, strerror(err));
+        }
+    }
+    
+    struct sched_param param = { .sched_priority = realtime_priority };
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0) {
+        syslog(LOG_WARNING, "[RT] Cannot set SCHED_FIFO priority %d: %s", realtime_priority, strerror(err));
+    }
+    
+    syslog(LOG_INFO, "[RT] Real-time mode: %zu KiB locked, SCHED_FIFO %d%s, CPU %d, flush-to-zero %s",
+           locked / 1024, realtime_priority, err ? " (denied)" : "", realtime_cpu, ftz ? "on" : "unsupported");
+}
+
+/**
+ * Initial model: the configured path, else the bundled model, each warmed up and sanity checked
+ */
+static struct model_backend *model_backend_load_initial(const char *path) {
+    const char *candidates[] = { path, DEFAULT_MODEL_PATH };
+    
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+        if (i > 0) {
+            if (strcmp(candidates[i], path) == 0) {
+                break;
+            }
+            syslog(LOG_WARNING, "[MODEL] Falling back to bundled model");
+        }
+        struct model_backend *b = model_backend_load(candidates[i]);
+        if (b) {
+            startup_mark("model loaded");
+            if (model_backend_verify(b)) {
+                startup_mark("model warmed up");
+                b->generation = ++model_generation;
+                return b;
+            }
+        }
+        model_backend_destroy(b);
+    }
+    return NULL;
+}
+
+/**
+ * Startup loader thread: hands the initial model to the main loop through model_startup_event
+ */
+static void *model_startup_main(void *arg) {
+    struct model_backend *b = model_backend_load_initial(startup_model_path);
+    
+    if (b) {
+        atomic_store(&startup_backend, b);
+    } else {
+        atomic_store(&startup_model_failed, true);
+    }
+    pw_loop_signal_event(pw_main_loop_get_loop(loop), model_startup_event);
+    return NULL;
+}
+
+/**
+ * Main loop side of the startup load: go live, or stop if no usable model could be loaded
+ */
+static void on_model_startup_done(void *data, uint64_t count) {
+    struct model_backend *b = atomic_exchange(&startup_backend, NULL);
+    
+    if (!b) {
+        if (atomic_load(&startup_model_failed)) {
+            syslog(LOG_ERR, "Failed to initialize LAROD");
+            startup_failed = true;
+            running = false;
+            pw_main_loop_quit(loop);
+        }
+        return;
+    }
+    
+    // Record the configured path as attempted, so a broken model_path isn't retried until it changes
+    struct stat st;
+    snprintf(model_attempt_path, sizeof(model_attempt_path), "%s", startup_model_path);
+    model_attempt_mtime = stat(startup_model_path, &st) == 0 ? st.st_mtime : 0;
+    
+    active_backend = b;
+    realtime_lock_backend(b);
+    ml_ready = true;
+    startup_mark("model live");
+    syslog(LOG_INFO, "LAROD inference engine initialized successfully");
+    syslog(LOG_INFO, "Machine learning pipeline ready");
+}
+
+/**
+ * Reload triggers: SIGHUP, a new model_path, or the model file changing on disk (checked every 5 seconds)
+ */
+static void check_model_changes(void) {
+    static time_t last_model_check = 0;
+    
+    if (!active_backend || atomic_load(&model_loading) || atomic_load(&staged_backend)) {
+        return;
+    }
+    
+    if (model_reload_requested) {
+        model_reload_requested = 0;
+        request_model_reload("SIGHUP");
+        return;
+    }
+    
+    // Runs per capture buffer: keep the stat() off most of them, SIGHUP above reloads at once
+    time_t now = time(NULL);
+    if (now - last_model_check < 5) {
+        return;
+    }
+    last_model_check = now;
+    
+    // Only retry a path/mtime pair once, so a broken file doesn't reload in a loop
+    struct stat st;
+    time_t mtime = stat(model_path, &st) == 0 ? st.st_mtime : 0;
+    if (mtime == model_attempt_mtime && strcmp(model_path, model_attempt_path) == 0) {
+        return;
+    }
+    if (strcmp(model_path, active_backend->path) != 0) {
+        request_model_reload("model_path changed");
+    } else if (mtime != 0 && mtime != active_backend->mtime) {
+        request_model_reload("model file changed");
+    }
+}
+
+/**
+ * Switch to a staged model; called between windows, returns the backend to free afterwards
+ */
+static struct model_backend *activate_staged_model(void) {
+    struct model_backend *next = atomic_exchange(&staged_backend, NULL);
+    if (!next) {
+        return NULL;
+    }
+    
+    struct model_backend *old = active_backend;
+    active_backend = next;
+    realtime_lock_backend(next);
+    atomic_fetch_add_explicit(&model_reloads, 1, memory_order_relaxed);
+    syslog(LOG_INFO, "[MODEL] ✅ Switched to generation %u (%s)", next->generation, next->path);
+    return old;
+}
+
+/**
+ * Release a head set and the models it owns
+ */
+static void head_set_destroy(struct head_set *set) {
+    if (!set) {
+        return;
+    }
+    for (size_t i = 0; i < set->count; i++) {
+        model_backend_destroy(set->heads[i].backend);
+    }
+    free(set);
+}
+
+/**
+ * Head labels end up in metrics labels, JSON and mail subjects: a-z, 0-9, '_' and '-' only
+ */
+static bool head_label_valid(const char *label) {
+    size_t len = strlen(label);
+    if (len == 0 || len >= HEAD_LABEL_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = label[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Alert sinks an extra_models entry routes to ("alerts=email+mqtt", "alerts=none"); the journal always logs
+ */
+static uint32_t head_routes(const char *entry) {
+    const char *option = strstr(entry, "alerts=");
+    char list[64];
+    if (!option || sscanf(option, "alerts=%63s", list) != 1) {
+        return EVENT_ROUTE_ALL;
+    }
+    
+    uint32_t routes = EVENT_ROUTE_JOURNAL;
+    char *save = NULL;
+    for (char *name = strtok_r(list, "+", &save); name; name = strtok_r(NULL, "+", &save)) {
+        if (strcmp(name, "email") == 0) {
+            routes |= EVENT_ROUTE_EMAIL;
+        } else if (strcmp(name, "webhook") == 0) {
+            routes |= EVENT_ROUTE_WEBHOOK;
+        } else if (strcmp(name, "mqtt") == 0) {
+            routes |= EVENT_ROUTE_MQTT;
+        } else if (strcmp(name, "none") != 0) {
+            syslog(LOG_WARNING, "[HEADS] Unknown alert route '%s' ignored", name);
+        }
+    }
+    return routes;
+}
+
+/**
+ * Load and verify every head of an extra_models value; NULL if any of them is unusable
+ */
+static struct head_set *head_set_load(const char *spec) {
+    struct head_set *set = calloc(1, sizeof(*set));
+    if (!set) {
+        return NULL;
+    }
+    snprintf(set->spec, sizeof(set->spec), "%s", spec);
+    
+    char list[sizeof(extra_models)];
+    snprintf(list, sizeof(list), "%s", spec);
+    char *save = NULL;
+    for (char *entry = strtok_r(list, ",", &save); entry; entry = strtok_r(NULL, ",", &save)) {
+        char label[32];
+        char path[256];
+        int fields = sscanf(entry, " %31s %255s", label, path);
+        if (fields < 1) {
+            continue;
+        }
+        if (fields != 2 || !head_label_valid(label)) {
+            syslog(LOG_ERR, "[HEADS] Bad entry '%s': expected a label (a-z, 0-9, _, -; up to %d chars) "
+                   "and a model path", entry, HEAD_LABEL_MAX - 1);
+            goto fail;
+        }
+        if (set->count == MAX_EXTRA_HEADS) {
+            syslog(LOG_WARNING, "[HEADS] More than %d extra heads, ignoring %s", MAX_EXTRA_HEADS, label);
+            continue;
+        }
+        
+        struct classifier_head *head = &set->heads[set->count];
+        snprintf(head->label, sizeof(head->label), "%s", label);
+        head->routes = head_routes(entry);
+        const char *option = strstr(entry, "threshold=");
+        int threshold = 0;
+        if (option && (sscanf(option, "threshold=%d", &threshold) != 1 || threshold < 1 || threshold > 99)) {
+            syslog(LOG_WARNING, "[HEADS] %s: threshold must be 1-99, using the global threshold", label);
+            threshold = 0;
+        }
+        head->threshold = threshold / 100.0f;
+        
+        head->backend = model_backend_load(path);
+        if (!head->backend) {
+            goto fail;
+        }
+        set->count++;
+        if (head->backend->streaming) {
+            syslog(LOG_ERR, "[HEADS] %s: streaming models cannot share the window features", label);
+            goto fail;
+        }
+        head->backend->ownThreshold = head->threshold;
+        model_backend_set_threshold(head->backend);
+        if (!model_backend_verify(head->backend)) {
+            goto fail;
+        }
+        char threshold_text[16] = "global";
+        if (threshold) {
+            snprintf(threshold_text, sizeof(threshold_text), "%d%%", threshold);
+        }
+        syslog(LOG_INFO, "[HEADS] %s ready: %s (threshold %s, alerts:%s%s%s%s)", label, path, threshold_text,
+               head->routes & EVENT_ROUTE_EMAIL ? " email" : "", head->routes & EVENT_ROUTE_WEBHOOK ? " webhook" : "",
+               head->routes & EVENT_ROUTE_MQTT ? " mqtt" : "",
+               head->routes == EVENT_ROUTE_JOURNAL ? " journal only" : "");
+    }
+    return set;
+    
+fail:
+    head_set_destroy(set);
+    return NULL;
+}
+
+/**
+ * Background loader for the extra heads, staged for the audio thread like a reloaded model
+ */
+static void *heads_loader_main(void *arg) {
+    char *spec = arg;
+    struct head_set *set = head_set_load(spec);
+    
+    if (set) {
+        struct head_set *stale = atomic_exchange(&staged_heads, set);
+        head_set_destroy(stale);
+        syslog(LOG_INFO, "[HEADS] %zu extra head(s) staged, switching at next window boundary", set->count);
+    } else {
+        syslog(LOG_ERR, "[HEADS] extra_models rejected, keeping current heads");
+    }
+    
+    free(spec);
+    atomic_store(&heads_loading, false);
+    return NULL;
+}
+
+/**
+ * Start loading the configured extra heads unless a load is already in flight
+ */
+static void request_heads_reload(const char *reason) {
+    if (atomic_exchange(&heads_loading, true)) {
+        return;
+    }
+    
+    snprintf(heads_attempt_spec, sizeof(heads_attempt_spec), "%s", extra_models);
+    syslog(LOG_INFO, "[HEADS] Reload requested (%s): %s", reason, extra_models[0] ? extra_models : "none");
+    
+    pthread_t thread;
+    pthread_attr_t attr;
+    char *spec = strdup(extra_models);
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (!spec || pthread_create(&thread, &attr, heads_loader_main, spec) != 0) {
+        syslog(LOG_ERR, "[HEADS] Failed to start head loader thread");
+        free(spec);
+        atomic_store(&heads_loading, false);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ * Head reload triggers: SIGHUP or a new extra_models value (each value is tried once). Nothing loads while
+ * a streaming model serves, and the heads are tried again once a window model is back
+ */
+static void check_head_changes(void) {
+    if (atomic_load(&heads_loading) || atomic_load(&staged_heads)) {
+        return;
+    }
+    if (ml_ready && active_backend->streaming) {
+        heads_attempt_spec[0] = '\0';
+        return;
+    }
+    
+    if (heads_reload_requested) {
+        heads_reload_requested = 0;
+        if (extra_models[0]) {
+            request_heads_reload("SIGHUP");
+            return;
+        }
+    }
+    if (strcmp(extra_models, heads_attempt_spec) != 0) {
+        request_heads_reload("extra_models changed");
+    }
+}
+
+/**
+ * Switch to a staged head set between windows; heads keeping their label keep their open event.
+ * Returns the set to free afterwards
+ */
+static struct head_set *activate_staged_heads(void) {
+    struct head_set *next = atomic_exchange(&staged_heads, NULL);
+    if (!next) {
+        return NULL;
+    }
+    
+    struct head_set *old = active_heads;
+    for (size_t i = 0; i < next->count; i++) {
+        struct classifier_head *head = &next->heads[i];
+        for (size_t j = 0; old && j < old->count; j++) {
+            if (strcmp(old->heads[j].label, head->label) == 0) {
+                head->decision = old->heads[j].decision;
+                head->inferences = old->heads[j].inferences;
+                head->events = old->heads[j].events;
+            }
+        }
+        realtime_lock_backend(head->backend);
+    }
+    active_heads = next;
+    syslog(LOG_INFO, "[HEADS] ✅ Serving %zu extra head(s)", next->count);
+    return old;
+}
+
+/**
+ * Extra heads score window features, which a streaming model never computes: drop a staged or serving
+ * set instead of leaving it waiting for a window boundary
+ */
+static void drop_heads_for_streaming(void) {
+    struct head_set *staged = atomic_exchange(&staged_heads, NULL);
+    if (!staged && !active_heads) {
+        return;
+    }
+    syslog(LOG_ERR, "[HEADS] ❌ Extra heads need a window model, not serving %zu head(s) next to a streaming model",
+           (staged ? staged : active_heads)->count);
+    head_set_destroy(staged);
+    head_set_destroy(active_heads);
+    active_heads = NULL;
+}
+
+/**
+ * Score the analysed window with every extra head from the mel features already computed for it,
+ * then run each head's own decision engine
+ */
+static void run_classifier_heads(const sample_t *window, uint64_t window_end, float rms, uint32_t stride) {
+    if (!active_heads) {
+        return;
+    }
+    
+    // Gated, energy-only or cascade-only windows have no features for the heads: they see silence
+    const bool scored = window_mel_valid && load_level <= GUNSHOT_LOAD_WIDE_STRIDE;
+    for (size_t i = 0; i < active_heads->count; i++) {
+        struct classifier_head *head = &active_heads->heads[i];
+        float probability = 0.0f;
+        bool vote = false;
+        if (scored) {
+            larodError *error = NULL;
+            model_write_input(head->backend, window_mel_features);
+            if (larodRunJob(head->backend->conn, head->backend->infReq, &error)) {
+                vote = model_read_decision(head->backend, &probability);
+                head->inferences++;
+                head->last_confidence = probability;
+            } else {
+                syslog(LOG_ERR, "[HEADS] %s inference failed: %s", head->label, error ? error->msg : "Unknown error");
+                larodClearError(&error);
+            }
+        }
+        const float threshold = head->threshold > 0.0f ? head->threshold : confidence_threshold;
+        if (decide_and_publish(&head->decision, head->label, head->routes, threshold, window, WINDOW_SAMPLES,
+                               window_end, WINDOW_SAMPLES, probability, vote, rms, stride) == DECISION_EVENT_START) {
+            head->events++;
+        }
+    }
+}
+
+/**
+ * Generate format-convert + downmix kernels (mono, stereo, any channel count) for one sample type
+ */
+#define DEFINE_CONVERT_KERNELS(name, type, scale)                                          \
+static void convert_##name##_mono(const void *src, uint32_t frames, uint32_t channels,    \
+                                  float *dst) {                                            \
+    const type *in = src;                                                                  \
+    for (uint32_t i = 0; i < frames; i++) {                                                \
+        dst[i] = (float)in[i] * (scale);                                                   \
+    }                                                                                      \
+}                                                                                          \
+static void convert_##name##_stereo(const void *src, uint32_t frames, uint32_t channels,  \
+                                    float *dst) {                                          \
+    const type *in = src;                                                                  \
+    for (uint32_t i = 0; i < frames; i++) {                                                \
+        dst[i] = ((float)in[2 * i] + (float)in[2 * i + 1]) * (0.5f * (scale));             \
+    }                                                                                      \
+}                                                                                          \
+static void convert_##name##_multi(const void *src, uint32_t frames, uint32_t channels,   \
+                                   float *dst) {                                           \
+    const type *in = src;                                                                  \
+    for (uint32_t i = 0; i < frames; i++) {                                                \
+        float sum = 0.0f;                                                                  \
+        for (uint32_t c = 0; c < channels; c++) {                                          \
+            sum += (float)in[i * channels + c];                                            \
+        }                                                                                  \
+        dst[i] = sum * ((scale) / channels);                                               \
+    }                                                                                      \
+}
+
+DEFINE_CONVERT_KERNELS(f32, float, 1.0f)
+DEFINE_CONVERT_KERNELS(s16, int16_t, 1.0f / 32768.0f)
+DEFINE_CONVERT_KERNELS(s24_32, int32_t, 1.0f / 8388608.0f)
+DEFINE_CONVERT_KERNELS(s32, int32_t, 1.0f / 2147483648.0f)
+
+static const struct {
+    enum spa_audio_format format;
+    const char *name;
+    size_t sample_bytes;
+    convert_fn mono;
+    convert_fn stereo;
+    convert_fn multi;
+} convert_kernels[] = {
+    { SPA_AUDIO_FORMAT_F32, "F32", sizeof(float), convert_f32_mono, convert_f32_stereo, convert_f32_multi },
+    { SPA_AUDIO_FORMAT_S16, "S16", sizeof(int16_t), convert_s16_mono, convert_s16_stereo, convert_s16_multi },
+    { SPA_AUDIO_FORMAT_S24_32, "S24_32", sizeof(int32_t), convert_s24_32_mono, convert_s24_32_stereo, convert_s24_32_multi },
+    { SPA_AUDIO_FORMAT_S32, "S32", sizeof(int32_t), convert_s32_mono, convert_s32_stereo, convert_s32_multi },
+};
+
+/**
+ * Store converted float samples in the audio buffer's sample type
+ */
+static void store_samples(const float *src, uint32_t count, sample_t *dst) {
+#ifdef GUNSHOT_FIXED_POINT
+    for (uint32_t i = 0; i < count; i++) {
+        long v = lrintf(src[i] * 32768.0f);
+        if (v > 32767) v = 32767;
+        if (v < -32768) v = -32768;
+        dst[i] = (int16_t)v;
+    }
+#else
+    memcpy(dst, src, count * sizeof(float));
+#endif
+}
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * Build the polyphase windowed-sinc filter for rate -> TARGET_SAMPLE_RATE
+ */
+static bool init_resampler(struct conversion_chain *chain) {
+    uint32_t g = gcd_u32(TARGET_SAMPLE_RATE, chain->rate);
+    chain->up = TARGET_SAMPLE_RATE / g;
+    chain->down = chain->rate / g;
+    if (chain->up > RESAMPLER_MAX_PHASES) {
+        syslog(LOG_ERR, "[FORMAT] Rate %u Hz needs %u resampler phases (max %d)",
+               chain->rate, chain->up, RESAMPLER_MAX_PHASES);
+        return false;
+    }
+
+    // Prototype low-pass at up * rate, cut below the lower of the two Nyquist frequencies
+    const uint32_t length = chain->up * RESAMPLER_TAPS;
+    const double cutoff = 0.92 * 0.5 / (chain->up > chain->down ? chain->up : chain->down);
+    for (uint32_t n = 0; n < length; n++) {
+        double t = n - (length - 1) / 2.0;
+        double x = 2.0 * cutoff * t;
+        double sinc = fabs(x) < 1e-9 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+        double window = 0.5 * (1.0 - cos(2.0 * M_PI * n / (length - 1)));
+        double h = 2.0 * cutoff * sinc * window * chain->up;
+        // Phase-major layout: coeffs[phase][tap] = h[phase + tap * up]
+        uint32_t phase = n % chain->up;
+        uint32_t tap = n / chain->up;
+        chain->coeffs[phase * RESAMPLER_TAPS + tap] = (float)h;
+    }
+
+    chain->position = 0;
+    memset(chain->history, 0, sizeof(chain->history));
+    return true;
+}
+
+/**
+ * Bind the conversion chain for the negotiated capture format
+ */
+static bool bind_conversion_chain(struct conversion_chain *chain, const struct spa_audio_info_raw *raw) {
+    chain->bound = false;
+    chain->format = raw->format;
+    chain->rate = raw->rate;
+    chain->channels = raw->channels;
+    chain->convert = NULL;
+    chain->resample = false;
+
+    const char *format_name = NULL;
+    for (size_t i = 0; i < sizeof(convert_kernels) / sizeof(convert_kernels[0]); i++) {
+        if (convert_kernels[i].format == raw->format) {
+            format_name = convert_kernels[i].name;
+            chain->frame_bytes = convert_kernels[i].sample_bytes * raw->channels;
+            chain->convert = raw->channels == 1 ? convert_kernels[i].mono
+                           : raw->channels == 2 ? convert_kernels[i].stereo
+                           : convert_kernels[i].multi;
+            break;
+        }
+    }
+    if (!format_name || raw->channels == 0 || raw->rate == 0) {
+        syslog(LOG_ERR, "[FORMAT] Unsupported capture format %d, %u channel(s), %u Hz",
+               raw->format, raw->channels, raw->rate);
+        return false;
+    }
+
+    if (raw->rate != TARGET_SAMPLE_RATE) {
+        chain->resample = true;
+        if (!init_resampler(chain)) {
+            return false;
+        }
+    } else if (raw->format == CAPTURE_FORMAT && raw->channels == 1) {
+        chain->convert = NULL;  // Native: no conversion work at all
+    }
+
+    chain->bound = true;
+    if (!chain->convert) {
+        syslog(LOG_INFO, "[FORMAT] Native capture %s mono %u Hz - no conversion", format_name, raw->rate);
+    } else {
+        syslog(LOG_INFO, "[FORMAT] Conversion chain: %s %u ch %u Hz -> %s%s -> mono %d Hz",
+               format_name, raw->channels, raw->rate,
+               raw->channels > 1 ? "downmix" : "convert",
+               chain->resample ? " -> resample" : "", TARGET_SAMPLE_RATE);
+        if (chain->resample) {
+            syslog(LOG_INFO, "[FORMAT] Resampler ratio %u/%u, %d taps per phase",
+                   chain->up, chain->down, RESAMPLER_TAPS);
+        }
+    }
+    return true;
+}
+
+/**
+ * Polyphase resample one block (input is chain_scratch after the history prefix)
+ */
+static uint32_t resample_block(struct conversion_chain *chain, uint32_t frames, float *out) {
+    float *x = chain_scratch;  // [history (TAPS - 1)][frames new samples]
+    memcpy(x, chain->history, sizeof(chain->history));
+
+    uint32_t produced = 0;
+    for (;;) {
+        uint64_t index = chain->position / chain->up;
+        if (index >= frames) {
+            break;
+        }
+        const float *h = chain->coeffs + (chain->position % chain->up) * RESAMPLER_TAPS;
+        const float *xp = x + index + RESAMPLER_TAPS - 1;
+        float acc = 0.0f;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            acc += h[k] * xp[-k];
+        }
+        out[produced++] = acc;
+        chain->position += chain->down;
+    }
+
+    chain->position -= (uint64_t)frames * chain->up;
+    memcpy(chain->history, x + frames, sizeof(chain->history));
+    return produced;
+}
+
+/**
+ * Run the bound chain over one capture buffer, appending to the audio buffer
+ */
+static uint32_t run_conversion_chain(struct conversion_chain *chain, const uint8_t *src, uint32_t frames,
+                                     sample_t *dst) {
+    uint32_t written = 0;
+
+    while (frames > 0) {
+        uint32_t n = frames < CHAIN_BLOCK_FRAMES ? frames : CHAIN_BLOCK_FRAMES;
+
+        if (!chain->convert) {
+            memcpy(dst + written, src, n * sizeof(sample_t));
+            written += n;
+        } else if (chain->resample) {
+            chain->convert(src, n, chain->channels, chain_scratch + RESAMPLER_TAPS - 1);
+            uint32_t produced = resample_block(chain, n, chain_resampled);
+            store_samples(chain_resampled, produced, dst + written);
+            written += produced;
+        } else {
+            chain->convert(src, n, chain->channels, chain_scratch);
+            store_samples(chain_scratch, n, dst + written);
+            written += n;
+        }
+
+        src += n * chain->frame_bytes;
+        frames -= n;
+    }
+    return written;
+}
+
+/**
+ * Upper bound of output samples the chain produces for a number of input frames
+ */
+static uint32_t conversion_chain_max_output(const struct conversion_chain *chain, uint32_t frames) {
+    if (!chain->resample) {
+        return frames;
+    }
+    return (uint32_t)(((uint64_t)frames * chain->up + chain->down - 1) / chain->down) + 1;
+}
+
+/**
+ * Samples to advance between analysis windows, a whole number of mel hops
+ */
+static uint32_t analysis_stride(void) {
+    if (window_stride_ms <= 0) {
+        return WINDOW_SAMPLES;
+    }
+    uint32_t stride = (uint32_t)((uint64_t)window_stride_ms * TARGET_SAMPLE_RATE / 1000);
+    stride -= stride % HOP_LENGTH;
+    if (stride < HOP_LENGTH) stride = HOP_LENGTH;
+    if (stride > WINDOW_SAMPLES) stride = WINDOW_SAMPLES;
+    return stride;
+}
+
+/**
+ * Stride at the current load level: shedding doubles it, up to back-to-back windows
+ */
+static uint32_t load_stride(uint32_t stride) {
+    if (load_level >= GUNSHOT_LOAD_WIDE_STRIDE) {
+        stride *= 2;
+        if (stride > WINDOW_SAMPLES) stride = WINDOW_SAMPLES;
+    }
+    return stride;
+}
+
+/**
+ * Move one step along the load-shedding ladder (+1 sheds, -1 restores); wide stride is skipped
+ * when the configured stride is already a full window, and a streaming model only has energy-only
+ */
+static void load_step(int direction, float rtf, float lag_ms) {
+    static int last_direction = 0;
+    const bool streaming = ml_ready && active_backend->streaming;
+    const bool skip_wide = streaming || analysis_stride() >= WINDOW_SAMPLES;
+    int level = (int)load_level + direction;
+    while ((level == GUNSHOT_LOAD_WIDE_STRIDE && skip_wide) || (level == GUNSHOT_LOAD_CASCADE_ONLY && streaming)) {
+        level += direction;
+    }
+    if (level < GUNSHOT_LOAD_FULL || level >= GUNSHOT_LOAD_LEVELS) {
+        return;
+    }
+    
+    uint64_t now = monotonic_us();
+    if (direction > 0) {
+        // Relapsing soon after a restore: wait twice as long before the next one
+        if (last_direction < 0 && now - load_level_changed_us < (uint64_t)load_restore_hold_ms * 1000) {
+            load_restore_hold_ms = load_restore_hold_ms * 2 < LOAD_RESTORE_HOLD_MAX_MS
+                                       ? load_restore_hold_ms * 2 : LOAD_RESTORE_HOLD_MAX_MS;
+        }
+        syslog(LOG_WARNING, "[LOAD] Falling behind (RTF %.2f, lag %.0f ms): shedding to %s",
+               rtf, lag_ms, gunshot_load_level_names[level]);
+    } else {
+        syslog(LOG_INFO, "[LOAD] Load cleared (RTF %.2f for %u s): restoring %s",
+               rtf, load_restore_hold_ms / 1000, gunshot_load_level_names[level]);
+    }
+    last_direction = direction;
+    load_level = (enum gunshot_load_level)level;
+    load_level_changed_us = now;
+    load_calm_since_us = 0;
+    
+    gunshot_stats_write_begin(stats);
+    stats->load_level = load_level;
+    if (direction > 0) {
+        stats->load_sheds++;
+    } else {
+        stats->load_restores++;
+    }
+    stats->updated_unix_ms = unix_ms();
+    gunshot_stats_write_end(stats);
+}
+
+/**
+ * Feed the latest real-time factor and ring lag into the ladder: shed while analysis falls behind,
+ * restore after the real-time factor has stayed low for the restore hold
+ */
+static void load_update(float rtf, float lag_ms) {
+    uint64_t now = monotonic_us();
+    
+    if (!load_shedding) {
+        if (load_level != GUNSHOT_LOAD_FULL) {
+            syslog(LOG_INFO, "[LOAD] Load shedding disabled: back to full quality");
+            load_level = GUNSHOT_LOAD_FULL;
+            load_level_changed_us = now;
+            gunshot_stats_write_begin(stats);
+            stats->load_level = load_level;
+            gunshot_stats_write_end(stats);
+        }
+        return;
+    }
+    
+    if (rtf > LOAD_SHED_RTF || lag_ms > LOAD_SHED_LAG_MS) {
+        load_calm_since_us = 0;
+        if (now - load_level_changed_us >= LOAD_SHED_HOLD_MS * 1000ULL) {
+            load_step(+1, rtf, lag_ms);
+        }
+        return;
+    }
+    
+    if (rtf >= LOAD_RESTORE_RTF) {
+        load_calm_since_us = 0;
+    } else if (load_level != GUNSHOT_LOAD_FULL) {
+        if (!load_calm_since_us) {
+            load_calm_since_us = now;
+        } else if (now - load_calm_since_us >= (uint64_t)load_restore_hold_ms * 1000) {
+            load_step(-1, rtf, lag_ms);
+        }
+    } else if (load_restore_hold_ms != LOAD_RESTORE_HOLD_MS &&
+               now - load_level_changed_us >= (uint64_t)load_restore_hold_ms * 1000) {
+        load_restore_hold_ms = LOAD_RESTORE_HOLD_MS;  // Stable at full quality again
+    }
+}
+
+/**
+ * Capture format name as used in the node cache, NULL if no conversion kernel handles it
+ */
+static const char *capture_format_name(enum spa_audio_format format) {
+    for (size_t i = 0; i < sizeof(convert_kernels) / sizeof(convert_kernels[0]); i++) {
+        if (convert_kernels[i].format == format) {
+            return convert_kernels[i].name;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Read the last target node and its negotiated format (format: key="value", as in the config file)
+ */
+static void load_node_cache(void) {
+    FILE *f = fopen(NODE_CACHE_PATH, "r");
+    if (!f) {
+        return;
+    }
+    
+    struct node_cache cache = { 0 };
+    bool have_format = false;
+    uint32_t n_positions = 0;
+    char line[512], value[256];
+    unsigned int number;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "node=\"%63[^\"]\"", cache.node) == 1) {
+            continue;
+        }
+        if (sscanf(line, "format=\"%255[^\"]\"", value) == 1) {
+            for (size_t i = 0; i < sizeof(convert_kernels) / sizeof(convert_kernels[0]); i++) {
+                if (strcmp(value, convert_kernels[i].name) == 0) {
+                    cache.format.format = convert_kernels[i].format;
+                    have_format = true;
+                }
+            }
+        } else if (sscanf(line, "rate=\"%u\"", &number) == 1) {
+            cache.format.rate = number;
+        } else if (sscanf(line, "channels=\"%u\"", &number) == 1 && number <= SPA_AUDIO_MAX_CHANNELS) {
+            cache.format.channels = number;
+        } else if (sscanf(line, "positions=\"%255[^\"]\"", value) == 1) {
+            for (char *p = value, *end; *p && n_positions < SPA_AUDIO_MAX_CHANNELS; p = end + (*end == ',')) {
+                cache.format.position[n_positions++] = (uint32_t)strtoul(p, &end, 10);
+                if (end == p) {
+                    break;
+                }
+            }
+        }
+    }
+    fclose(f);
+    
+    cache.valid = cache.node[0] && have_format && cache.format.rate > 0 &&
+                  cache.format.channels > 0 && n_positions == cache.format.channels;
+    if (!cache.valid) {
+        syslog(LOG_WARNING, "[CAMERA] Ignoring incomplete node cache %s", NODE_CACHE_PATH);
+        return;
+    }
+    node_cache = cache;
+    syslog(LOG_INFO, "[CAMERA] Cached audio node: %s (%s %u ch %u Hz)", node_cache.node,
+           capture_format_name(node_cache.format.format), node_cache.format.channels, node_cache.format.rate);
+}
+
+/**
+ * Remember the target node and negotiated format for the next start (only rewritten when it changes)
+ */
+static void save_node_cache(const char *node, const struct spa_audio_info_raw *raw) {
+    if (node_cache.valid && strcmp(node_cache.node, node) == 0 && node_cache.format.format == raw->format &&
+        node_cache.format.rate == raw->rate && node_cache.format.channels == raw->channels &&
+        memcmp(node_cache.format.position, raw->position, raw->channels * sizeof(raw->position[0])) == 0) {
+        return;
+    }
+    
+    const char *tmp_path = NODE_CACHE_PATH ".tmp";
+    FILE *f = fopen(tmp_path, "w");
+    if (!f) {
+        syslog(LOG_WARNING, "[CAMERA] Cannot write node cache %s: %s", tmp_path, strerror(errno));
+        return;
+    }
+    fprintf(f, "node=\"%s\"\nformat=\"%s\"\nrate=\"%u\"\nchannels=\"%u\"\npositions=\"",
+            node, capture_format_name(raw->format), raw->rate, raw->channels);
+    for (uint32_t c = 0; c < raw->channels; c++) {
+        fprintf(f, "%s%u", c ? "," : "", raw->position[c]);
+    }
+    fprintf(f, "\"\n");
+    if (fclose(f) != 0 || rename(tmp_path, NODE_CACHE_PATH) != 0) {
+        syslog(LOG_WARNING, "[CAMERA] Cannot update node cache %s: %s", NODE_CACHE_PATH, strerror(errno));
+        unlink(tmp_path);
+        return;
+    }
+    
+    node_cache.valid = true;
+    snprintf(node_cache.node, sizeof(node_cache.node), "%s", node);
+    node_cache.format = *raw;
+    syslog(LOG_INFO, "[CAMERA] Cached audio node %s for warm start", node);
+}
+
+/**
+ * Forget buffered audio and any scheduled early window (new capture stream)
+ */
+static void audio_buffer_reset(void) {
+    samples_accumulated = 0;
+    window_start = 0;
+    onset.due = 0;
+    confirm.pending = false;
+    onset.block_fill = 0;
+    onset.block_energy = 0.0f;
+    if (active_backend) {
+        model_backend_reset_state(active_backend);
+    }
+}
+
+/**
+ * Drop audio nobody needs any more: everything before the next regular window, except the history kept
+ * for onset-triggered windows and streaming models' clips (a whole window) and confirmation bursts
+ * (their backward shifts)
+ */
+static void audio_buffer_trim(void) {
+    uint32_t keep = onset_trigger || (ml_ready && active_backend->streaming) ? WINDOW_SAMPLES : 0;
+    if (confirm_margin > 0 && keep < CONFIRM_SHIFT_HOPS * HOP_LENGTH) {
+        keep = CONFIRM_SHIFT_HOPS * HOP_LENGTH;
+    }
+    uint32_t drop = samples_accumulated > keep ? samples_accumulated - keep : 0;
+    if (drop > window_start) {
+        drop = window_start;
+    }
+    if (drop > 0) {
+        samples_accumulated -= drop;
+        window_start -= drop;
+        memmove(audio_buffer, audio_buffer + drop, samples_accumulated * sizeof(sample_t));
+    }
+}
+
+/**
+ * Streaming transient detector over newly captured samples: block energy against a slow background.
+ * An onset schedules an early window ending ONSET_POST_MS after it
+ */
+static void onset_scan(const sample_t *samples, uint32_t count, uint64_t position) {
+    const uint64_t refractory = (uint64_t)ONSET_REFRACTORY_MS * TARGET_SAMPLE_RATE / 1000;
+    for (uint32_t i = 0; i < count; i++) {
+#ifdef GUNSHOT_FIXED_POINT
+        const float x = samples[i] * (1.0f / 32768.0f);
+#else
+        const float x = samples[i];
+#endif
+        onset.block_energy += x * x;
+        if (++onset.block_fill < ONSET_BLOCK) {
+            continue;
+        }
+        
+        const float energy = onset.block_energy / ONSET_BLOCK;
+        const uint64_t block_start = position + i + 1 - ONSET_BLOCK;
+        onset.block_energy = 0.0f;
+        onset.block_fill = 0;
+        if (!onset.primed) {
+            onset.background = energy;
+            onset.primed = true;
+            continue;
+        }
+        if (energy > ONSET_RATIO * onset.background && energy > MIN_RMS_THRESHOLD * MIN_RMS_THRESHOLD) {
+            if (!onset.last || block_start - onset.last >= refractory) {
+                onset.last = block_start;
+                if (onset_trigger && !onset.due) {
+                    // On the hop grid, so the window shares mel frames with its neighbours
+                    onset.due = block_start + (uint64_t)ONSET_POST_MS * TARGET_SAMPLE_RATE / 1000;
+                    onset.due += HOP_LENGTH - 1 - (onset.due + HOP_LENGTH - 1) % HOP_LENGTH;
+                }
+            }
+            continue;  // Keep the impulse itself out of the background
+        }
+        onset.background += (energy - onset.background) / ONSET_BACKGROUND_BLOCKS;
+    }
+}
+
+/**
+ * Impulse-to-decision latency of an opened event: audio captured since the onset inside the window,
+ * plus the time this callback spent before the decision
+ */
+static void detection_latency_observe(uint64_t window_end, uint64_t t_callback) {
+    if (!onset.last || onset.last > window_end || onset.last + WINDOW_SAMPLES < window_end) {
+        return;
+    }
+    uint64_t latency_us = (uint64_t)((samples_total - onset.last) * 1e6 / TARGET_SAMPLE_RATE / source_speed)
+                          + (monotonic_us() - t_callback);
+    histogram_observe(&detection_latency_hist, latency_us);
+    if (replay_latency_count < replay_latency_cap) {
+        replay_latencies[replay_latency_count++] = latency_us / 1000.0f;
+    }
+}
+
+/**
+ * One step of a streaming model: mel for its new frames (shared with the ring), one inference with the
+ * state carried over, one decision. Quiet steps still run so the state stays continuous, but cannot vote.
+ * At the energy-only load level the step's peak against the RMS of the window ending there stands in for
+ * the model, and the state restarts after
+ */
+static void stream_step(uint64_t t_callback) {
+    static bool state_stale = false;  // Steps were decided without the model
+    struct model_backend *b = active_backend;
+    const uint64_t buffer_start = samples_total - samples_accumulated;
+    const uint64_t position = buffer_start + window_start;
+    const uint32_t span = (uint32_t)(b->inputFrames - 1) * HOP_LENGTH + N_FFT;
+    const uint32_t step = (uint32_t)b->inputFrames * HOP_LENGTH;
+    const uint64_t step_end = position + span;
+    const sample_t *audio = audio_buffer + window_start;
+    
+    uint64_t t_start = monotonic_us();
+    float lag_ms = (samples_total - step_end) * 1000.0f / TARGET_SAMPLE_RATE / source_speed
+                   + (t_start - t_callback) / 1000.0f;
+    const float rms = window_rms(audio, span);
+    const bool quiet = rms < MIN_RMS_THRESHOLD;
+    float probability = 0.0f;
+    bool vote = false;
+    
+    // An opening event's clip and spectrogram cover the window ending at this step (its frames are in the ring)
+    const sample_t *window = NULL;
+    if (step_end >= buffer_start + WINDOW_SAMPLES) {
+        window = audio_buffer + (step_end - WINDOW_SAMPLES - buffer_start);
+    }
+    
+    if (load_level == GUNSHOT_LOAD_ENERGY_ONLY) {
+        const float background = window ? window_rms(window, WINDOW_SAMPLES) : rms;
+        vote = !quiet && window_peak(audio, span) / background >= ENERGY_ONLY_CREST;
+        probability = vote ? 1.0f : 0.0f;
+        detection_count += vote;
+        state_stale = true;
+        gunshot_stats_write_begin(stats);
+        stats->detection_count = detection_count;
+        stats->windows_gated += quiet;
+        stats->updated_unix_ms = unix_ms();
+        gunshot_stats_write_end(stats);
+    } else {
+        if (state_stale) {
+            model_backend_reset_state(b);  // The skipped steps left a gap in what the state has seen
+            state_stale = false;
+        }
+        float mel[STREAM_MAX_FRAMES * N_MELS];
+        ring_mel_frames(audio, position, b->inputFrames, mel);
+        uint64_t t_mel = monotonic_us();
+        model_write_input(b, mel);
+        uint64_t t_quantize = monotonic_us();
+        larodError *error = NULL;
+        bool job_ok = larodRunJob(b->conn, b->infReq, &error);
+        uint64_t t_inference = monotonic_us();
+        histogram_observe(&inference_latency_hist, t_inference - t_quantize);
+        
+        if (!job_ok) {
+            syslog(LOG_ERR, "[STREAM] Inference failed, state reset: %s", error ? error->msg : "Unknown error");
+            larodClearError(&error);
+            model_backend_reset_state(b);
+        } else {
+            model_backend_carry_state(b);
+            vote = model_read_decision(b, &probability);
+            inference_count++;
+            if (quiet) {
+                vote = false;
+                probability = 0.0f;
+            }
+            if (vote) {
+                detection_count++;
+            }
+        }
+        
+        gunshot_stats_write_begin(stats);
+        stats->inference_count = inference_count;
+        stats->detection_count = detection_count;
+        stats->windows_gated += quiet;
+        stats->last_confidence = probability * 100.0f;
+        stats->threshold = confidence_threshold * 100.0f;
+        stats_record_latency(GUNSHOT_STAGE_MEL, t_mel - t_start);
+        stats_record_latency(GUNSHOT_STAGE_QUANTIZE, t_quantize - t_mel);
+        stats_record_latency(GUNSHOT_STAGE_INFERENCE, t_inference - t_quantize);
+        stats->updated_unix_ms = unix_ms();
+        gunshot_stats_write_end(stats);
+    }
+    syslog(LOG_DEBUG, "[STREAM] Step ending at %.2f s: %.1f%% (thresh: %.0f%%, RMS: %.3f)%s",
+           (double)step_end / TARGET_SAMPLE_RATE, probability * 100.0f, confidence_threshold * 100.0f, rms,
+           vote ? " positive" : "");
+    
+    window_mel_valid = false;
+    if (window && vote && !decision.active) {
+        window_mel(window, step_end - WINDOW_SAMPLES, window_mel_features);
+        window_mel_valid = true;
+    }
+    if (process_gunshot_detection(window, WINDOW_SAMPLES, step_end, span, probability, vote, rms, step)) {
+        detection_latency_observe(step_end, t_callback);
+    }
+    if (step_end > last_window_end) {
+        last_window_end = step_end;
+    }
+    
+    if (!startup_complete) {
+        startup_first_window_ms = (monotonic_us() - startup_begin_us) / 1000;
+        startup_mark("first streaming step analysed");
+        startup_complete = true;
+    }
+    
+    // Real-time factor: processing time over the new audio each step consumes
+    uint64_t step_us = monotonic_us() - t_start;
+    float audio_us = step * 1e6f / TARGET_SAMPLE_RATE / source_speed;
+    gunshot_stats_write_begin(stats);
+    stats_record_latency(GUNSHOT_STAGE_WINDOW, step_us);
+    stats->real_time_factor += ((float)step_us / audio_us - stats->real_time_factor) / 8.0f;
+    stats->ring_lag_ms = lag_ms;
+    stats->windows_by_load_level[load_level]++;
+    stats->capture_rate = capture_rate;
+    gunshot_stats_write_end(stats);
+    load_update(stats->real_time_factor, lag_ms);
+    
+    window_start += step;
+    audio_buffer_trim();
+}
+
+/**
+ * Feed captured frames in the bound capture format into the analysis path (shared by every audio source)
+ */
+static void capture_frames(const uint8_t *samples, uint32_t n_frames) {
+    static bool first_buffer = true;
+    if (first_buffer) {
+        startup_mark("first audio buffer");
+        first_buffer = false;
+        if (realtime_mode) {
+            realtime_setup();
+        }
+    }
+    uint32_t n_samples = conversion_chain_max_output(&capture_chain, n_frames);
+    
+    // Debug: Log every 1000 audio callbacks to show activity
+    if (++debug_counter % 1000 == 1) {
+        syslog(LOG_INFO, "[CAMERA] Audio activity: received %u samples, accumulated %u total", 
+               n_samples, samples_accumulated - window_start);
+    }
+    
+    // Periodically reload config (every ~5000 callbacks)
+    if (debug_counter % 5000 == 0) {
+        load_config();
+    }
+    
+    // Analysis has fallen a whole buffer behind: drop the oldest audio rather than the newest, and shed load
+    uint64_t t_callback = monotonic_us();
+    if (samples_accumulated + n_samples > AUDIO_BUFFER_SIZE && n_samples <= AUDIO_BUFFER_SIZE) {
+        uint32_t excess = samples_accumulated + n_samples - AUDIO_BUFFER_SIZE;
+        bool history_only = excess <= window_start;
+        samples_accumulated -= excess;
+        window_start = history_only ? window_start - excess : 0;
+        memmove(audio_buffer, audio_buffer + excess, samples_accumulated * sizeof(sample_t));
+        if (!history_only) {
+            if (ml_ready && active_backend->streaming) {
+                model_backend_reset_state(active_backend);  // The stream has a gap
+            }
+            stats_buffer_dropped();
+            syslog(LOG_WARNING, "[LOAD] Ring full, dropped the oldest %u samples", excess);
+            load_update(stats->real_time_factor,
+                        ((int32_t)samples_accumulated - WINDOW_SAMPLES) * 1000.0f / TARGET_SAMPLE_RATE / source_speed);
+        }
+    }
+    
+    // Convert into the buffer at TARGET_SAMPLE_RATE mono
+    if (samples_accumulated + n_samples <= AUDIO_BUFFER_SIZE) {
+        uint32_t converted = run_conversion_chain(&capture_chain, samples, n_frames,
+                                                  audio_buffer + samples_accumulated);
+        onset_scan(audio_buffer + samples_accumulated, converted, samples_total);
+        if (samples_total == 0) {
+            stream_anchor_ms = unix_ms() - converted * 1000ULL / TARGET_SAMPLE_RATE;
+        }
+        samples_accumulated += converted;
+        samples_total += converted;
+        
+        // Check for config and model changes periodically
+        check_config_changes();
+        check_model_changes();
+        check_head_changes();
+        
+        // Process every full analysis window, then slide by the stride; a due onset window goes in
+        // between, in stream order, unless a regular window covering the onset is ready anyway.
+        // An ambiguous window holds everything behind it until its confirmation burst has run
+        for (;;) {
+            const uint64_t buffer_start = samples_total - samples_accumulated;
+            if (confirm.pending) {
+                if (ml_ready && samples_total < confirm.window_end + CONFIRM_SHIFT_HOPS * HOP_LENGTH &&
+                    confirm.window_end + CONFIRM_SHIFT_HOPS * HOP_LENGTH <= buffer_start + AUDIO_BUFFER_SIZE) {
+                    break;
+                }
+                // A ring overrun while waiting took the window itself: the single window decides
+                uint64_t t_burst = monotonic_us();
+                const bool overrun = confirm.window_end - WINDOW_SAMPLES < buffer_start;
+                bool vote = confirm.vote;
+                float probability = ml_ready && !overrun ? confirm_burst(audio_buffer, buffer_start, &confirm, &vote)
+                                                         : confirm.probability;
+                const sample_t *window = overrun ? NULL
+                                                 : audio_buffer + (confirm.window_end - WINDOW_SAMPLES - buffer_start);
+                confirm.pending = false;
+                if (process_gunshot_detection(window, WINDOW_SAMPLES, confirm.window_end, WINDOW_SAMPLES,
+                                              probability, vote, confirm.rms, confirm.stride)) {
+                    detection_latency_observe(confirm.window_end, t_callback);
+                }
+                confirm_carry_us += monotonic_us() - t_burst;
+                if (confirm.regular && !overrun) {
+                    window_start += confirm.stride;
+                    audio_buffer_trim();
+                }
+                continue;
+            }
+            
+            // Streaming model: a step per inputFrames hops from window_start on, no windows or onsets
+            if (ml_ready && active_backend->streaming) {
+                onset.due = 0;
+                if (samples_accumulated - window_start <
+                    (uint32_t)(active_backend->inputFrames - 1) * HOP_LENGTH + N_FFT) {
+                    break;
+                }
+                struct model_backend *retired = activate_staged_model();
+                if (retired) {
+                    model_backend_destroy(retired);
+                    continue;  // The new model may step differently, or not stream at all
+                }
+                drop_heads_for_streaming();
+                stream_step(t_callback);
+                continue;
+            }
+            const bool regular = samples_accumulated - window_start >= INFERENCE_THRESHOLD;
+            const uint64_t regular_end = buffer_start + window_start + WINDOW_SAMPLES;
+            bool early = onset.due && samples_total >= onset.due;
+            if (early && (!ml_ready || load_level != GUNSHOT_LOAD_FULL || onset.due < buffer_start + WINDOW_SAMPLES ||
+                          (regular && regular_end >= onset.due && regular_end - WINDOW_SAMPLES <= onset.last))) {
+                onset.due = 0;  // Shedding load, no history yet, or redundant
+                early = false;
+            }
+            if (!early && !regular) {
+                break;
+            }
+            early = early && (!regular || onset.due < regular_end);
+            
+            uint32_t stride = load_stride(analysis_stride());
+            const uint64_t window_end = early ? onset.due : regular_end;
+            const sample_t *window = audio_buffer + (window_end - WINDOW_SAMPLES - buffer_start);
+            if (early) {
+                // Smoothing and the real-time factor count the audio this window adds
+                uint64_t fresh = window_end > last_window_end ? window_end - last_window_end : HOP_LENGTH;
+                stride = fresh < WINDOW_SAMPLES ? (fresh > HOP_LENGTH ? (uint32_t)fresh : HOP_LENGTH) : WINDOW_SAMPLES;
+                onset.due = 0;
+            }
+            
+            // Model still loading: keep only the newest window so the first analysis is current
+            if (!ml_ready) {
+                window_start += stride;
+                audio_buffer_trim();
+                continue;
+            }
+            
+            static bool first_inference = true;
+            if (first_inference) {
+                syslog(LOG_INFO, "*** STARTING REAL CAMERA AUDIO GUNSHOT DETECTION ***");
+                first_inference = false;
+            }
+            struct rusage usage_before, usage_after;
+            getrusage(RUSAGE_THREAD, &usage_before);
+            uint64_t t_window = monotonic_us();
+            enum gunshot_load_level window_level = load_level;
+            
+            // Ring lag: captured audio newer than this window, plus time spent on earlier windows this callback
+            float lag_ms = (samples_total - window_end) * 1000.0f / TARGET_SAMPLE_RATE / source_speed
+                           + (t_window - t_callback) / 1000.0f;
+            struct model_backend *retired = activate_staged_model();
+            if (active_backend->streaming) {
+                model_backend_destroy(retired);
+                continue;  // A streaming model takes over from this window's start
+            }
+            struct head_set *retired_heads = activate_staged_heads();
+            float rms = 0.0f;
+            bool vote = false;
+            float probability = analyse_window(window, WINDOW_SAMPLES, window_end - WINDOW_SAMPLES, &rms, &vote);
+            run_classifier_heads(window, window_end, rms, stride);
+            const bool deferred = confirm_wanted(probability);
+            if (deferred) {
+                confirm = (struct confirm_state){
+                    .pending = true, .regular = !early, .window_end = window_end, .stride = stride,
+                    .probability = probability, .rms = rms, .vote = vote,
+                };
+            } else if (process_gunshot_detection(window, WINDOW_SAMPLES, window_end, WINDOW_SAMPLES, probability, vote,
+                                                 rms, stride)) {
+                detection_latency_observe(window_end, t_callback);
+            }
+            if (window_end > last_window_end) {
+                last_window_end = window_end;
+            }
+            uint64_t window_us = monotonic_us() - t_window;
+            getrusage(RUSAGE_THREAD, &usage_after);
+            if (retired) {
+                model_backend_destroy(retired);
+            }
+            head_set_destroy(retired_heads);
+            if (!startup_complete) {
+                startup_first_window_ms = (monotonic_us() - startup_begin_us) / 1000;
+                startup_mark("first window analysed");
+                startup_complete = true;
+            }
+            
+            // Real-time factor: processing time over the new audio each window consumes
+            float audio_us = stride * 1e6f / TARGET_SAMPLE_RATE / source_speed;
+            float busy_us = (float)(window_us + confirm_carry_us);
+            confirm_carry_us = 0;
+            gunshot_stats_write_begin(stats);
+            stats_record_latency(GUNSHOT_STAGE_WINDOW, window_us);
+            stats->real_time_factor += (busy_us / audio_us - stats->real_time_factor) / 8.0f;
+            stats->ring_lag_ms = lag_ms;
+            stats->windows_by_load_level[window_level]++;
+            stats->capture_rate = capture_rate;
+            stats->window_minor_faults += (uint64_t)(usage_after.ru_minflt - usage_before.ru_minflt);
+            stats->window_major_faults += (uint64_t)(usage_after.ru_majflt - usage_before.ru_majflt);
+            stats->window_involuntary_switches += (uint64_t)(usage_after.ru_nivcsw - usage_before.ru_nivcsw);
+            gunshot_stats_write_end(stats);
+            if (usage_after.ru_majflt > usage_before.ru_majflt) {
+                syslog(LOG_WARNING, "[RT] Window hit %ld major page fault(s)",
+                       usage_after.ru_majflt - usage_before.ru_majflt);
+            }
+            load_update(stats->real_time_factor, lag_ms);
+            
+            if (!early && !deferred) {
+                window_start += stride;
+                audio_buffer_trim();
+            }
+        }
+    } else {
+        stats_buffer_dropped();
+    }
+}
+
+/**
+ * Live capture: re-anchor the stream clock when audio arrives more than a second away from its position
+ * (capture gaps, clock drift), so event times stay wall-clock times
+ */
+static void stream_clock_sync(void) {
+    const int64_t offset_ms = (int64_t)unix_ms() - (int64_t)stream_time_ms(samples_total);
+    if (offset_ms > 1000 || offset_ms < -1000) {
+        syslog(LOG_INFO, "[CAMERA] Stream clock re-anchored by %lld ms", (long long)offset_ms);
+        stream_anchor_ms += (uint64_t)offset_ms;
+    }
+}
+
+/**
+ * Audio processing callback (adapted from official audiocapture.c)
+ */
+static void on_process(void *userdata) {
+    struct stream_data *data = userdata;
+    struct pw_buffer *b;
+    struct spa_buffer *buf;
+
+    if ((b = pw_stream_dequeue_buffer(data->stream)) == NULL) {
+        syslog(LOG_WARNING, "Out of buffers for %s", data->name);
+        stats_buffer_dropped();
+        return;
+    }
+
+    // Only process target stream (AudioDevice0Input0.Unprocessed); audio buffers up while the model loads
+    buf = b->buffer;
+    if (buf->datas[0].data && data->is_target_stream && capture_chain.bound) {
+        capture_frames((const uint8_t *)buf->datas[0].data + buf->datas[0].chunk->offset,
+                       buf->datas[0].chunk->size / capture_chain.frame_bytes);
+        stream_clock_sync();
+    }
+
+    pw_stream_queue_buffer(data->stream, b);
+}
+
+/**
+ * Stream parameter callback (from official audiocapture.c)
+ */
+static void on_param_changed(void *userdata, uint32_t id, const struct spa_pod *param) {
+    struct stream_data *data = userdata;
+    struct spa_audio_info info = { 0 };
+    int ret;
+
+    if (id != SPA_PARAM_Format || param == NULL) {
+        return;
+    }
+
+    if ((ret = spa_format_parse(param, &info.media_type, &info.media_subtype)) < 0) {
+        return;
+    }
+
+    if (info.media_type != SPA_MEDIA_TYPE_audio ||
+        info.media_subtype != SPA_MEDIA_SUBTYPE_raw) {
+        return;
+    }
+
+    spa_format_audio_raw_parse(param, &info.info.raw);
+
+    syslog(LOG_INFO, "[CAMERA] Capturing from node %s, %d channel(s), rate %d.", 
+           data->name, info.info.raw.channels, info.info.raw.rate);
+    
+    if (info.info.raw.rate > 0) {
+        capture_rate = info.info.raw.rate;
+    }
+    
+    // Mark if this is our target stream
+    if (strstr(data->name, "AudioDevice0Input0.Unprocessed") != NULL) {
+        data->is_target_stream = true;
+        syslog(LOG_INFO, "[CAMERA] *** TARGET STREAM FOUND: %s ***", data->name);
+        
+        // Specialize the capture path for exactly what PipeWire picked
+        audio_buffer_reset();
+        if (bind_conversion_chain(&capture_chain, &info.info.raw)) {
+            save_node_cache(data->name, &info.info.raw);
+        }
+    }
+}
+
+/**
+ * Stream state callback (from official audiocapture.c)
+ */
+static void on_state_changed(void *userdata, enum pw_stream_state old, 
+                           enum pw_stream_state state, const char *error) {
+    struct stream_data *data = userdata;
+    
+    switch (state) {
+        case PW_STREAM_STATE_STREAMING:
+            syslog(LOG_INFO, "[CAMERA] Stream %s is now streaming", data->name);
+            data->streaming = true;
+            startup_mark(data->warm_start ? "warm-start stream streaming" : "stream streaming");
+            break;
+        case PW_STREAM_STATE_ERROR:
+            syslog(LOG_ERR, "[CAMERA] Stream %s error: %s", data->name, error);
+            if (data->warm_start && !data->streaming && warm_start_timer) {
+                // Fall back to discovery right away; the stream can't be destroyed from its own callback
+                pw_loop_update_timer(pw_main_loop_get_loop(loop), warm_start_timer,
+                                     &(struct timespec){ 0, 1 }, NULL, false);
+                break;
+            }
+            running = false;
+            break;
+        default:
+            break;
+    }
+}
+
+static const struct pw_stream_events stream_events = {
+    PW_VERSION_STREAM_EVENTS,
+    .param_changed = on_param_changed,
+    .process = on_process,
+    .state_changed = on_state_changed,
+};
+
+/**
+ * Create and connect a capture stream for a node; a preferred format (from the node cache) is offered first
+ */
+static struct stream_data *connect_capture_stream(const char *node_name, uint32_t node_id,
+                                                  const struct spa_audio_info_raw *preferred) {
+    struct stream_data *stream_data;
+    struct pw_properties *stream_props;
+    const struct spa_pod *params[13];
+    uint32_t n_params = 0;
+    uint8_t buffer[8192];
+    struct spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+    
+    size_t slot = 0;
+    while (slot < MAX_CAPTURE_STREAMS && capture_streams[slot]) {
+        slot++;
+    }
+    if (slot == MAX_CAPTURE_STREAMS) {
+        syslog(LOG_ERR, "[CAMERA] Too many capture streams, ignoring %s", node_name);
+        return NULL;
+    }
+
+    stream_data = calloc(1, sizeof(struct stream_data));
+    if (!stream_data) {
+        return NULL;
+    }
+    strncpy(stream_data->name, node_name, sizeof(stream_data->name) - 1);
+    stream_data->is_target_stream = false;
+    stream_data->node_id = node_id;
+    stream_data->warm_start = node_id == PW_ID_ANY;  // Not announced by the registry yet: from the cache
+
+    // No fallback to another source: a stale cached name must fail rather than capture the wrong node
+    stream_props = pw_properties_new(
+        PW_KEY_MEDIA_TYPE, "Audio",
+        PW_KEY_MEDIA_CATEGORY, "Capture",
+        PW_KEY_TARGET_OBJECT, node_name,
+        "node.dont-fallback", "true",
+        NULL);
+
+    stream_data->stream = pw_stream_new(core, "Gunshot Detector", stream_props);
+    if (!stream_data->stream) {
+        free(stream_data);
+        return NULL;
+    }
+
+    pw_stream_add_listener(stream_data->stream, &stream_data->stream_listener,
+                          &stream_events, stream_data);
+
+    // Last negotiated format first, so a warm start settles without another round of negotiation
+    if (preferred) {
+        params[n_params++] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, preferred);
+    }
+
+    // Offer formats in preference order: target rate first, native sample type first, mono first
+    static const uint32_t rates[] = { TARGET_SAMPLE_RATE, SAMPLE_RATE, 16000 };
+#ifdef GUNSHOT_FIXED_POINT
+    static const enum spa_audio_format formats[] = { SPA_AUDIO_FORMAT_S16, SPA_AUDIO_FORMAT_F32 };
+#else
+    static const enum spa_audio_format formats[] = { SPA_AUDIO_FORMAT_F32, SPA_AUDIO_FORMAT_S16 };
+#endif
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            params[n_params++] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat,
+                &SPA_AUDIO_INFO_RAW_INIT(.format = formats[f], .rate = rates[r], .channels = 1,
+                                         .position = { SPA_AUDIO_CHANNEL_MONO }));
+            params[n_params++] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat,
+                &SPA_AUDIO_INFO_RAW_INIT(.format = formats[f], .rate = rates[r], .channels = 2,
+                                         .position = { SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR }));
+        }
+    }
+
+    pw_stream_connect(stream_data->stream,
+                     PW_DIRECTION_INPUT,
+                     PW_ID_ANY,
+                     PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS,
+                     params, n_params);
+    
+    capture_streams[slot] = stream_data;
+    return stream_data;
+}
+
+/**
+ * Disconnect and free a capture stream; losing the target stream unbinds the capture chain
+ */
+static void destroy_capture_stream(struct stream_data *data) {
+    for (size_t i = 0; i < MAX_CAPTURE_STREAMS; i++) {
+        if (capture_streams[i] == data) {
+            capture_streams[i] = NULL;
+        }
+    }
+    if (data->is_target_stream) {
+        capture_chain.bound = false;
+        audio_buffer_reset();
+    }
+    pw_stream_destroy(data->stream);
+    free(data);
+}
+
+static struct stream_data *find_capture_stream(const char *node_name) {
+    for (size_t i = 0; i < MAX_CAPTURE_STREAMS; i++) {
+        if (capture_streams[i] && strcmp(capture_streams[i]->name, node_name) == 0) {
+            return capture_streams[i];
+        }
+    }
+    return NULL;
+}
 
 /**
- * Create and map temporary file for tensor data
+ * Registry global callback (adapted from official audiocapture.c)
  */
-static bool create_and_map_tmp_file(const char *pattern, size_t size, void **addr, int *fd) {
-    char tmp_file[256];
-    
-    snprintf(tmp_file, sizeof(tmp_file), "%s", pattern);
-    *fd = mkstemp(tmp_file);
-    if (*fd < 0) {
-        syslog(LOG_ERR, "Failed to create temporary file: %s", strerror(errno));
-        return false;
+static void registry_event_global(void *data, uint32_t id, uint32_t permissions,
+                                const char *type, uint32_t version,
+                                const struct spa_dict *props) {
+    const char *media_class, *node_name;
+
+    if (strcmp(type, PW_TYPE_INTERFACE_Node) != 0) {
+        return;
     }
-    
-    if (ftruncate(*fd, size) != 0) {
-        syslog(LOG_ERR, "Failed to set file size: %s", strerror(errno));
-        close(*fd);
-        *fd = -1;
-        return false;
+
+    media_class = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
+    node_name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+
+    if (media_class == NULL || node_name == NULL) {
+        return;
     }
-    
-    *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
-    if (*addr == MAP_FAILED) {
-        syslog(LOG_ERR, "Failed to mmap file: %s", strerror(errno));
-        close(*fd);
-        *fd = -1;
-        return false;
+
+    // Log all discovered audio nodes
+    syslog(LOG_INFO, "[REGISTRY] Found %s node %s with id %d.", media_class, node_name, id);
+
+    // Only connect to AudioDevice0Input0 nodes (like official example)
+    if (!strstr(node_name, "AudioDevice0Input0")) {
+        return;
     }
-    
-    unlink(tmp_file);
-    syslog(LOG_DEBUG, "Created temporary tensor file, size: %zu bytes", size);
-    return true;
+
+    // Already connected from the node cache: just learn its id for removal tracking
+    struct stream_data *existing = find_capture_stream(node_name);
+    if (existing) {
+        existing->node_id = id;
+        return;
+    }
+
+    syslog(LOG_INFO, "[CAMERA] *** CONNECTING TO AUDIO INPUT: %s ***", node_name);
+    startup_mark("audio node found");
+
+    bool cached = node_cache.valid && strcmp(node_cache.node, node_name) == 0;
+    connect_capture_stream(node_name, id, cached ? &node_cache.format : NULL);
 }
 
 /**
- * Convert frequency to mel scale
+ * Registry removal callback: drop streams whose node went away, discovery reconnects when it returns
  */
-static float hz_to_mel(float hz) {
-    return 2595.0f * log10f(1.0f + hz / 700.0f);
+static void registry_event_global_remove(void *data, uint32_t id) {
+    for (size_t i = 0; i < MAX_CAPTURE_STREAMS; i++) {
+        struct stream_data *stream_data = capture_streams[i];
+        if (stream_data && stream_data->node_id == id) {
+            syslog(LOG_WARNING, "[CAMERA] Audio node %s (id %u) removed, waiting for it to reappear",
+                   stream_data->name, id);
+            destroy_capture_stream(stream_data);
+        }
+    }
 }
 
+static const struct pw_registry_events registry_events = {
+    PW_VERSION_REGISTRY_EVENTS,
+    .global = registry_event_global,
+    .global_remove = registry_event_global_remove,
+};
+
 /**
- * Convert mel scale to frequency
+ * Fresh registry binding: the registry announces every existing node again
  */
-static float mel_to_hz(float mel) {
-    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+static void restart_discovery(void) {
+    spa_hook_remove(&registry_listener);
+    pw_proxy_destroy((struct pw_proxy*)registry);
+    registry = pw_core_get_registry(core, PW_VERSION_REGISTRY, 0);
+    pw_registry_add_listener(registry, &registry_listener, &registry_events, NULL);
 }
 
 /**
- * Initialize FFT workspace and Hann window
+ * Warm-start deadline: a cached node that isn't streaming by now is dropped in favour of discovery
  */
-static bool init_fft_workspace(void) {
-    if (fft_initialized) {
-        return true;
+static void on_warm_start_timeout(void *data, uint64_t expirations) {
+    for (size_t i = 0; i < MAX_CAPTURE_STREAMS; i++) {
+        struct stream_data *stream_data = capture_streams[i];
+        if (!stream_data || !stream_data->warm_start) {
+            continue;
+        }
+        if (stream_data->streaming) {
+            stream_data->warm_start = false;
+            return;
+        }
+        syslog(LOG_WARNING, "[CAMERA] Warm start to %s failed, falling back to discovery", stream_data->name);
+        destroy_capture_stream(stream_data);
+        node_cache.valid = false;
+        unlink(NODE_CACHE_PATH);
+        restart_discovery();
+        return;
     }
-    
-    fft_in = fftwf_alloc_complex(N_FFT);
-    fft_out = fftwf_alloc_complex(N_FFT);
-    hann_window = malloc(N_FFT * sizeof(float));
-    
-    if (!fft_in || !fft_out || !hann_window) {
-        syslog(LOG_ERR, "[FFT] Failed to allocate FFT workspace");
-        return false;
+}
+
+/**
+ * Connect straight to the cached node through PW_KEY_TARGET_OBJECT, ahead of registry discovery
+ */
+static void start_warm_capture(void) {
+    if (!node_cache.valid) {
+        return;
     }
     
-    fft_plan = fftwf_plan_dft_1d(N_FFT, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
-    if (!fft_plan) {
-        syslog(LOG_ERR, "[FFT] Failed to create FFT plan");
-        return false;
+    syslog(LOG_INFO, "[CAMERA] Warm start: connecting to cached node %s", node_cache.node);
+    startup_mark("warm-start stream connecting");
+    if (!connect_capture_stream(node_cache.node, PW_ID_ANY, &node_cache.format)) {
+        return;
     }
     
-    for (int i = 0; i < N_FFT; i++) {
-        hann_window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (N_FFT - 1)));
+    warm_start_timer = pw_loop_add_timer(pw_main_loop_get_loop(loop), on_warm_start_timeout, NULL);
+    if (warm_start_timer) {
+        pw_loop_update_timer(pw_main_loop_get_loop(loop), warm_start_timer,
+                             &(struct timespec){ WARM_START_TIMEOUT_MS / 1000, (WARM_START_TIMEOUT_MS % 1000) * 1000000L },
+                             NULL, false);
     }
-    
-    fft_initialized = true;
-    syslog(LOG_INFO, "[FFT] FFT workspace initialized successfully");
-    return true;
 }
 
 /**
- * Initialize mel filter bank matrix (librosa-compatible)
+ * Connect to PipeWire and discover the camera's audio node, cached node first
  */
-static bool init_mel_filter_bank(void) {
-    if (mel_filters_initialized) {
-        return true;
+static bool pipewire_source_start(void) {
+    context = pw_context_new(pw_main_loop_get_loop(loop), NULL, 0);
+    core = context ? pw_context_connect(context, NULL, 0) : NULL;
+    if (!core) {
+        syslog(LOG_ERR, "[CAMERA] Failed to connect to PipeWire");
+        return false;
     }
+    startup_mark("PipeWire connected");
     
-    syslog(LOG_INFO, "[MEL] Initializing mel filter bank: %d mels, %d FFT bins", N_MELS, N_FFT_BINS);
-    
-    memset(mel_filter_bank, 0, sizeof(mel_filter_bank));
-    
-    float mel_min = hz_to_mel(MEL_FMIN);
-    float mel_max = hz_to_mel(MEL_FMAX);
+    // Cached node first; discovery below still runs and takes over if the warm start fails
+    start_warm_capture();
+    registry = pw_core_get_registry(core, PW_VERSION_REGISTRY, 0);
     
-    float mel_points[N_MELS + 2];
-    for (int i = 0; i < N_MELS + 2; i++) {
-        mel_points[i] = mel_min + (mel_max - mel_min) * i / (N_MELS + 1);
-    }
+    pw_registry_add_listener(registry, &registry_listener, &registry_events, NULL);
     
-    float hz_points[N_MELS + 2];
-    for (int i = 0; i < N_MELS + 2; i++) {
-        hz_points[i] = mel_to_hz(mel_points[i]);
+    syslog(LOG_INFO, "PipeWire initialized - discovering camera audio devices...");
+    return true;
+}
+
+static void pipewire_source_stop(void) {
+    for (size_t i = 0; i < MAX_CAPTURE_STREAMS; i++) {
+        if (capture_streams[i]) destroy_capture_stream(capture_streams[i]);
     }
+    if (warm_start_timer) pw_loop_destroy_source(pw_main_loop_get_loop(loop), warm_start_timer);
+    if (registry) pw_proxy_destroy((struct pw_proxy*)registry);
+    if (core) pw_core_disconnect(core);
+    if (context) pw_context_destroy(context);
+}
+
+static const struct audio_source pipewire_source = {
+    "pipewire", pipewire_source_start, pipewire_source_stop,
+};
+
+// Synthetic source state, driven by a timer on the main loop like PipeWire's process callback
+static struct spa_source *synthetic_timer = NULL;
+static uint8_t *synthetic_buffer = NULL;
+static size_t synthetic_sample_bytes = 0;
+static uint64_t synthetic_start_us = 0;
+static uint64_t synthetic_buffers = 0;
+static uint32_t synthetic_seed = 0x2545F491u;
+
+/**
+ * Parse --synthetic options: comma-separated key=value pairs, see synthetic_config
+ */
+static bool parse_synthetic_spec(const char *spec) {
+    char copy[512];
+    snprintf(copy, sizeof(copy), "%s", spec);
     
-    int bin_points[N_MELS + 2];
-    for (int i = 0; i < N_MELS + 2; i++) {
-        bin_points[i] = (int)floorf(hz_points[i] * N_FFT / TARGET_SAMPLE_RATE);
-        if (bin_points[i] >= N_FFT_BINS) {
-            bin_points[i] = N_FFT_BINS - 1;
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char key[16], value[32];
+        float v = 0.0f;
+        if (sscanf(item, "%15[^=]=%31s", key, value) != 2) {
+            fprintf(stderr, "Bad synthetic option '%s' (expected key=value)\n", item);
+            return false;
         }
-    }
-    
-    for (int m = 0; m < N_MELS; m++) {
-        int left = bin_points[m];
-        int center = bin_points[m + 1];
-        int right = bin_points[m + 2];
-        
-        for (int k = left; k < center; k++) {
-            if (center > left) {
-                mel_filter_bank[m][k] = (float)(k - left) / (center - left);
+        if (strcmp(key, "format") == 0) {
+            bool found = false;
+            for (size_t i = 0; i < sizeof(convert_kernels) / sizeof(convert_kernels[0]); i++) {
+                if (strcasecmp(value, convert_kernels[i].name) == 0) {
+                    synthetic.format = convert_kernels[i].format;
+                    found = true;
+                }
             }
-        }
-        
-        for (int k = center; k < right; k++) {
-            if (right > center) {
-                mel_filter_bank[m][k] = (float)(right - k) / (right - center);
+            if (!found) {
+                fprintf(stderr, "Unsupported synthetic format '%s' (F32, S16, S24_32 or S32)\n", value);
+                return false;
             }
+            continue;
         }
-        
-        if (MEL_NORM_SLANEY) {
-            float area = 0.0f;
-            for (int k = 0; k < N_FFT_BINS; k++) {
-                area += mel_filter_bank[m][k];
-            }
-            if (area > 0.0f) {
-                for (int k = 0; k < N_FFT_BINS; k++) {
-                    mel_filter_bank[m][k] /= area;
-                }
-            }
+        if (sscanf(value, "%f", &v) != 1) {
+            fprintf(stderr, "Bad value for synthetic option %s: '%s'\n", key, value);
+            return false;
+        }
+        if (strcmp(key, "rate") == 0 && v >= 8000 && v <= 192000) synthetic.rate = (uint32_t)v;
+        else if (strcmp(key, "channels") == 0 && v >= 1 && v <= 8) synthetic.channels = (uint32_t)v;
+        else if (strcmp(key, "quantum") == 0 && v >= 16 && v <= 8192) synthetic.quantum = (uint32_t)v;
+        else if (strcmp(key, "jitter") == 0 && v >= 0 && v <= 10) synthetic.jitter = v;
+        else if (strcmp(key, "noise") == 0 && v >= -120 && v <= 0) synthetic.noise_dbfs = v;
+        else if (strcmp(key, "impulse") == 0 && v >= -120 && v <= 0) synthetic.impulse_dbfs = v;
+        else if (strcmp(key, "interval") == 0 && v >= 0) synthetic.impulse_interval_s = v;
+        else if (strcmp(key, "speed") == 0 && v >= 0) synthetic.speed = v;
+        else if (strcmp(key, "duration") == 0 && v >= 0) synthetic.duration_s = v;
+        else {
+            fprintf(stderr, "Unknown or out-of-range synthetic option %s=%s\n", key, value);
+            return false;
         }
     }
-    
-    mel_filters_initialized = true;
-    syslog(LOG_INFO, "[MEL] Mel filter bank initialized successfully");
     return true;
 }
 
 /**
- * Compute mel-spectrogram for audio (librosa-compatible version)
+ * Fill one buffer: per-channel background noise plus a decaying noise burst every impulse interval
  */
-static void compute_mel_spectrogram(const float *audio, size_t num_samples, float *output) {
-    if (!init_fft_workspace() || !init_mel_filter_bank()) {
-        syslog(LOG_ERR, "[MEL] Failed to initialize FFT workspace or mel filter bank");
-        memset(output, 0, EXPECTED_INPUT_SIZE * sizeof(float));
-        return;
-    }
-    
-    memset(output, 0, EXPECTED_INPUT_SIZE * sizeof(float));
-    
-    float power_spectrum[N_FFT_BINS];
+static void synthetic_fill(uint32_t frames) {
+    const float noise = powf(10.0f, synthetic.noise_dbfs / 20.0f) * 1.7320508f;  // Uniform noise with that RMS
+    const float impulse = powf(10.0f, synthetic.impulse_dbfs / 20.0f);
+    const uint64_t interval = (uint64_t)(synthetic.impulse_interval_s * synthetic.rate);
+    const uint64_t first = synthetic_buffers * synthetic.quantum;
     
-    int frame_count = 0;
-    for (int start = 0; start < (int)num_samples - N_FFT && frame_count < N_FRAMES; start += HOP_LENGTH) {
-        for (int i = 0; i < N_FFT; i++) {
-            if (start + i < (int)num_samples) {
-                fft_in[i] = audio[start + i] * hann_window[i];
-            } else {
-                fft_in[i] = 0.0f;
+    for (uint32_t i = 0; i < frames; i++) {
+        float burst = 0.0f;
+        if (interval) {
+            // First impulse half an interval in, so a window is already full when it arrives
+            float since = (float)((first + i + interval / 2) % interval) / synthetic.rate;
+            if (since < 0.25f) {
+                burst = impulse * expf(-since * 60.0f) * uniform_noise(&synthetic_seed);
             }
         }
-        
-        fftwf_execute(fft_plan);
-        
-        for (int i = 0; i < N_FFT_BINS; i++) {
-            float real = crealf(fft_out[i]);
-            float imag = cimagf(fft_out[i]);
-            power_spectrum[i] = real * real + imag * imag;
-        }
-        
-        for (int m = 0; m < N_MELS; m++) {
-            float mel_energy = 0.0f;
-            for (int k = 0; k < N_FFT_BINS; k++) {
-                mel_energy += mel_filter_bank[m][k] * power_spectrum[k];
+        for (uint32_t c = 0; c < synthetic.channels; c++) {
+            float x = burst + noise * uniform_noise(&synthetic_seed);
+            if (x > 1.0f) x = 1.0f;
+            if (x < -1.0f) x = -1.0f;
+            size_t at = (size_t)i * synthetic.channels + c;
+            switch (synthetic.format) {
+            case SPA_AUDIO_FORMAT_F32: ((float *)synthetic_buffer)[at] = x; break;
+            case SPA_AUDIO_FORMAT_S16: ((int16_t *)synthetic_buffer)[at] = (int16_t)lrintf(x * 32767.0f); break;
+            case SPA_AUDIO_FORMAT_S24_32: ((int32_t *)synthetic_buffer)[at] = (int32_t)lrintf(x * 8388607.0f); break;
+            default: ((int32_t *)synthetic_buffer)[at] = (int32_t)lrint(x * 2147483647.0); break;
             }
-            
-            float mel_db = 10.0f * log10f(fmaxf(mel_energy, 1e-10f));
-            float mel_normalized = (mel_db - (-80.0f)) / (0.0f - (-80.0f));
-            
-            if (mel_normalized < 0.0f) mel_normalized = 0.0f;
-            if (mel_normalized > 1.0f) mel_normalized = 1.0f;
-            
-            output[frame_count * N_MELS + m] = mel_normalized;
         }
-        
-        frame_count++;
     }
-    
-    syslog(LOG_INFO, "[MEL] Computed mel spectrogram: %d frames, %d mels", frame_count, N_MELS);
 }
 
 /**
- * Convert float mel features to int8 with corrected quantization
+ * Log what a synthetic run delivered and what the pipeline made of it
  */
-static void quantize_input(const float *mel_features, int8_t *quantized_output) {
-    const float scale = 0.003921568859368563f;
-    const int zero_point = -128;
-    
-    for (int i = 0; i < EXPECTED_INPUT_SIZE; i++) {
-        float mel_value = mel_features[i];
-        float centered_value = (mel_value - 0.5f) * 2.0f;
-        int quantized = (int)roundf(centered_value / scale) + zero_point;
-        
-        if (quantized < -128) quantized = -128;
-        if (quantized > 127) quantized = 127;
-        
-        quantized_output[i] = (int8_t)quantized;
+static void synthetic_report(void) {
+    struct gunshot_stats snap;
+    if (!gunshot_stats_read(stats, &snap)) {
+        return;
+    }
+    double audio_s = (double)synthetic_buffers * synthetic.quantum / synthetic.rate;
+    double wall_s = (monotonic_us() - synthetic_start_us) / 1e6;
+    uint64_t windows = 0;
+    for (int i = 0; i < GUNSHOT_LOAD_LEVELS; i++) {
+        windows += snap.windows_by_load_level[i];
     }
+    syslog(LOG_INFO, "[SOURCE] Synthetic run: %.1f s of audio in %.1f s (%.2fx real time), %llu windows, "
+           "%llu inferences, %llu events, %llu load sheds, %llu buffers dropped, mean RTF %.3f",
+           audio_s, wall_s, wall_s > 0 ? audio_s / wall_s : 0.0, (unsigned long long)windows,
+           (unsigned long long)snap.inference_count, (unsigned long long)snap.events_count,
+           (unsigned long long)snap.load_sheds, (unsigned long long)snap.buffers_dropped, snap.real_time_factor);
 }
 
 /**
- * Process audio frame and run gunshot detection inference
+ * Deliver every buffer that is due, then sleep until the next one (late by up to the jitter)
  */
-static bool process_gunshot_detection(const float *audio_samples, size_t num_samples) {
-    if (!ml_ready) {
-        return false;
-    }
+static void on_synthetic_timer(void *data, uint64_t expirations) {
+    const double period_us = synthetic.speed > 0 ? synthetic.quantum * 1e6 / synthetic.rate / synthetic.speed : 0.0;
+    const uint64_t frame_limit = (uint64_t)(synthetic.duration_s * synthetic.rate);
     
-    // Calculate RMS to check if audio is too quiet
-    float rms = 0.0f;
-    for (size_t i = 0; i < num_samples; i++) {
-        rms += audio_samples[i] * audio_samples[i];
-    }
-    rms = sqrtf(rms / num_samples);
-    
-    // Skip inference on very quiet audio to prevent false positives
-    const float MIN_RMS_THRESHOLD = 0.001f;  // -60 dB
-    if (rms < MIN_RMS_THRESHOLD) {
-        syslog(LOG_DEBUG, "[SILENCE] Skipping inference on quiet audio (RMS: %.6f < %.6f)", rms, MIN_RMS_THRESHOLD);
-        return false;
-    }
-    
-    // Compute mel spectrogram
-    float mel_features[EXPECTED_INPUT_SIZE];
-    compute_mel_spectrogram(audio_samples, num_samples, mel_features);
-    
-    // Quantize for model input
-    int8_t quantized_input[EXPECTED_INPUT_SIZE];
-    quantize_input(mel_features, quantized_input);
-    
-    // Copy quantized input to tensor memory
-    memcpy(inputTensorAddr, quantized_input, inputTensorSize);
-    
-    // Run inference
-    larodError *error = NULL;
-    if (larodRunJob(conn, infReq, &error)) {
-        // Read results
-        int8_t *output_data = (int8_t *)outputTensorAddr;
-        float output1 = output_data[0] * 0.003921568859368563f + (-128 * 0.003921568859368563f);
-        float output2 = output_data[1] * 0.003921568859368563f + (-128 * 0.003921568859368563f);
-        
-        // Apply softmax
-        float exp1 = expf(output1);
-        float exp2 = expf(output2);
-        float sum = exp1 + exp2;
-        float prob1 = exp1 / sum;
-        float prob2 = exp2 / sum;
-        
-        float gunshot_confidence = prob2 * 100.0f;
-        
-        inference_count++;
-        
-        // Detection logic
-        if (prob2 > confidence_threshold) {
-            detection_count++;
-            syslog(LOG_WARNING, "🔫 [GUNSHOT DETECTED - CAMERA AUDIO] Confidence: %.1f%%, RMS: %.3f", 
-                   gunshot_confidence, rms);
-            syslog(LOG_INFO, "🔫 [CAMERA] Gunshot: %.1f%% (thresh: %.0f%%, RMS: %.3f)", 
-                   gunshot_confidence, confidence_threshold * 100.0f, rms);
-            
-            // Send email notification
-            if (email_enabled) {
-                send_email_notification(gunshot_confidence, rms);
-            }
-            
-            return true;
-        } else {
-            syslog(LOG_INFO, "❌ [CAMERA] Gunshot: %.1f%% (thresh: %.0f%%, RMS: %.3f)", 
-                   gunshot_confidence, confidence_threshold * 100.0f, rms);
+    // A late wakeup finds several buffers due; unthrottled runs deliver one per wakeup
+    uint64_t due = period_us > 0 ? (uint64_t)((monotonic_us() - synthetic_start_us) / period_us) + 1
+                                 : synthetic_buffers + 1;
+    while (synthetic_buffers < due) {
+        synthetic_fill(synthetic.quantum);
+        capture_frames(synthetic_buffer, synthetic.quantum);
+        synthetic_buffers++;
+        if (frame_limit && synthetic_buffers * synthetic.quantum >= frame_limit) {
+            pw_main_loop_quit(loop);
+            return;
         }
-        
-        larodClearError(&error);
-        return false;
-    } else {
-        syslog(LOG_ERR, "Failed to run inference: %s", error ? error->msg : "Unknown error");
-        larodClearError(&error);
-        return false;
     }
+    
+    double delay_us = synthetic_buffers * period_us + synthetic.jitter * period_us * (0.5f + 0.5f * uniform_noise(&synthetic_seed))
+                      - (double)(monotonic_us() - synthetic_start_us);
+    long delay_ns = delay_us > 0.001 ? (long)(delay_us * 1000.0) : 1;
+    pw_loop_update_timer(pw_main_loop_get_loop(loop), synthetic_timer,
+                         &(struct timespec){ delay_ns / 1000000000L, delay_ns % 1000000000L }, NULL, false);
 }
 
 /**
- * Audio processing callback (adapted from official audiocapture.c)
+ * Bind the capture path to the synthetic format and start delivering buffers from the main loop
  */
-static void on_process(void *userdata) {
-    struct stream_data *data = userdata;
-    struct pw_buffer *b;
-    struct spa_buffer *buf;
-    float *samples;
-    uint32_t n_channels, n_samples;
-
-    if ((b = pw_stream_dequeue_buffer(data->stream)) == NULL) {
-        syslog(LOG_WARNING, "Out of buffers for %s", data->name);
-        return;
+static bool synthetic_source_start(void) {
+    struct spa_audio_info_raw raw = {
+        .format = synthetic.format, .rate = synthetic.rate, .channels = synthetic.channels,
+    };
+    if (!bind_conversion_chain(&capture_chain, &raw)) {
+        return false;
     }
-
-    buf = b->buffer;
-    if ((samples = buf->datas[0].data) == NULL) {
-        goto done;
+    capture_rate = synthetic.rate;
+    synthetic_sample_bytes = capture_chain.frame_bytes / synthetic.channels;
+    synthetic_buffer = malloc((size_t)synthetic.quantum * capture_chain.frame_bytes);
+    synthetic_timer = pw_loop_add_timer(pw_main_loop_get_loop(loop), on_synthetic_timer, NULL);
+    if (!synthetic_buffer || !synthetic_timer) {
+        syslog(LOG_ERR, "[SOURCE] Failed to set up the synthetic source");
+        return false;
     }
+    
+    // Analysis timing is judged against audio time as delivered
+    source_speed = synthetic.speed > 0 ? synthetic.speed : 1.0f;
+    syslog(LOG_INFO, "[SOURCE] Synthetic source: %u Hz, %u ch, %zu-byte samples, %u-frame buffers, jitter %.0f%%, "
+           "noise %.0f dBFS, impulses %.0f dBFS every %.1f s, %s%.1fx real time",
+           synthetic.rate, synthetic.channels, synthetic_sample_bytes, synthetic.quantum, synthetic.jitter * 100.0f,
+           synthetic.noise_dbfs, synthetic.impulse_dbfs, synthetic.impulse_interval_s,
+           synthetic.speed > 0 ? "" : "unthrottled, judged at ", source_speed);
+    synthetic_start_us = monotonic_us();
+    pw_loop_update_timer(pw_main_loop_get_loop(loop), synthetic_timer, &(struct timespec){ 0, 1 }, NULL, false);
+    startup_mark("synthetic source started");
+    return true;
+}
 
-    n_channels = buf->datas[0].chunk->size / sizeof(float);
-    n_samples = n_channels; // Simplified for now
-
-    // Only process target stream (AudioDevice0Input0.Unprocessed)
-    if (data->is_target_stream && ml_ready) {
-        // Debug: Log every 1000 audio callbacks to show activity
-        if (++debug_counter % 1000 == 1) {
-            syslog(LOG_INFO, "[CAMERA] Audio activity: received %u samples, accumulated %u total", 
-                   n_samples, samples_accumulated);
-        }
-        
-        // Periodically reload config (every ~5000 callbacks)
-        if (debug_counter % 5000 == 0) {
-            load_config();
-        }
-        
-        // Add samples to buffer
-        if (samples_accumulated + n_samples <= AUDIO_BUFFER_SIZE) {
-            memcpy(audio_buffer + samples_accumulated, samples, n_samples * sizeof(float));
-            samples_accumulated += n_samples;
-            
-            // Check for config changes periodically
-            check_config_changes();
-            
-            // Process when we have enough samples (~2 seconds at 48kHz)
-            if (samples_accumulated >= INFERENCE_THRESHOLD) {
-                static bool first_inference = true;
-                if (first_inference) {
-                    syslog(LOG_INFO, "*** STARTING REAL CAMERA AUDIO GUNSHOT DETECTION ***");
-                    first_inference = false;
-                }
-                process_gunshot_detection(audio_buffer, AUDIO_BUFFER_SIZE);
-                samples_accumulated = 0; // Reset for next batch
-            }
-        }
+static void synthetic_source_stop(void) {
+    if (synthetic_timer) {
+        synthetic_report();
+        pw_loop_destroy_source(pw_main_loop_get_loop(loop), synthetic_timer);
+        synthetic_timer = NULL;
     }
-
-done:
-    pw_stream_queue_buffer(data->stream, b);
+    free(synthetic_buffer);
+    synthetic_buffer = NULL;
 }
 
+static const struct audio_source synthetic_source = {
+    "synthetic", synthetic_source_start, synthetic_source_stop,
+};
+
 /**
- * Stream parameter callback (from official audiocapture.c)
+ * Read a PCM/float WAV file and convert it to mono TARGET_SAMPLE_RATE through the capture chain
  */
-static void on_param_changed(void *userdata, uint32_t id, const struct spa_pod *param) {
-    struct stream_data *data = userdata;
-    struct spa_audio_info info = { 0 };
-    int ret;
-
-    if (id != SPA_PARAM_Format || param == NULL) {
-        return;
-    }
-
-    if ((ret = spa_format_parse(param, &info.media_type, &info.media_subtype)) < 0) {
-        return;
+static sample_t *load_wav_file(const char *path, size_t *num_samples) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return NULL;
     }
-
-    if (info.media_type != SPA_MEDIA_TYPE_audio ||
-        info.media_subtype != SPA_MEDIA_SUBTYPE_raw) {
-        return;
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    size_t size = file_size > 12 ? (size_t)file_size : 0;
+    fseek(f, 0, SEEK_SET);
+    uint8_t *file = size ? malloc(size) : NULL;
+    if (!file || fread(file, 1, size, f) != size ||
+        memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s is not a RIFF/WAVE file\n", path);
+        fclose(f);
+        free(file);
+        return NULL;
     }
-
-    spa_format_audio_raw_parse(param, &info.info.raw);
-
-    syslog(LOG_INFO, "[CAMERA] Capturing from node %s, %d channel(s), rate %d.", 
-           data->name, info.info.raw.channels, info.info.raw.rate);
+    fclose(f);
     
-    // Mark if this is our target stream
-    if (strstr(data->name, "AudioDevice0Input0.Unprocessed") != NULL) {
-        data->is_target_stream = true;
-        syslog(LOG_INFO, "[CAMERA] *** TARGET STREAM FOUND: %s ***", data->name);
+    struct spa_audio_info_raw raw = { .format = SPA_AUDIO_FORMAT_UNKNOWN };
+    const uint8_t *data = NULL;
+    uint32_t data_bytes = 0;
+    for (size_t pos = 12; pos + 8 <= size; ) {
+        uint32_t chunk_bytes;
+        memcpy(&chunk_bytes, file + pos + 4, sizeof(chunk_bytes));
+        const uint8_t *body = file + pos + 8;
+        if (chunk_bytes > size - pos - 8) {
+            chunk_bytes = (uint32_t)(size - pos - 8);
+        }
+        if (memcmp(file + pos, "fmt ", 4) == 0 && chunk_bytes >= 16) {
+            uint16_t tag, channels, bits;
+            memcpy(&tag, body, 2);
+            memcpy(&channels, body + 2, 2);
+            memcpy(&raw.rate, body + 4, 4);
+            memcpy(&bits, body + 14, 2);
+            if (tag == 0xFFFE && chunk_bytes >= 26) {
+                memcpy(&tag, body + 24, 2);  // WAVE_FORMAT_EXTENSIBLE sub-format
+            }
+            raw.channels = channels;
+            if (tag == 1 && bits == 16) raw.format = SPA_AUDIO_FORMAT_S16;
+            else if (tag == 1 && bits == 32) raw.format = SPA_AUDIO_FORMAT_S32;
+            else if (tag == 3 && bits == 32) raw.format = SPA_AUDIO_FORMAT_F32;
+        } else if (memcmp(file + pos, "data", 4) == 0) {
+            data = body;
+            data_bytes = chunk_bytes;
+        }
+        pos += 8 + chunk_bytes + (chunk_bytes & 1);
     }
+    
+    sample_t *samples = NULL;
+    if (!data || !bind_conversion_chain(&capture_chain, &raw)) {
+        fprintf(stderr, "%s: unsupported WAV (need 16/32-bit PCM or 32-bit float)\n", path);
+    } else {
+        uint32_t frames = (uint32_t)(data_bytes / capture_chain.frame_bytes);
+        samples = malloc(((size_t)conversion_chain_max_output(&capture_chain, frames) + CHAIN_BLOCK_FRAMES) *
+                         sizeof(sample_t));
+        if (samples) {
+            *num_samples = run_conversion_chain(&capture_chain, data, frames, samples);
+        }
+    }
+    free(file);
+    return samples;
+}
+
+#define REPLAY_QUANTUM 1024  // Samples per simulated capture buffer
+
+static int compare_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
 }
 
 /**
- * Stream state callback (from official audiocapture.c)
+ * Stream a recording through the live capture path, decision engine included, and collect the
+ * impulse-to-decision latency of every event it opens
  */
-static void on_state_changed(void *userdata, enum pw_stream_state old, 
-                           enum pw_stream_state state, const char *error) {
-    struct stream_data *data = userdata;
+static size_t replay_stream(const sample_t *samples, size_t num_samples, bool trigger) {
+    const bool saved_trigger = onset_trigger;
+    onset_trigger = trigger;
+    memset(&decision, 0, sizeof(decision));
+    for (size_t i = 0; active_heads && i < active_heads->count; i++) {
+        memset(&active_heads->heads[i].decision, 0, sizeof(active_heads->heads[i].decision));
+    }
+    memset(&onset, 0, sizeof(onset));
+    memset(mel_ring, 0, sizeof(mel_ring));
+    audio_buffer_reset();
+    samples_total = 0;
+    last_window_end = 0;
+    replay_latency_count = 0;
     
-    switch (state) {
-        case PW_STREAM_STATE_STREAMING:
-            syslog(LOG_INFO, "[CAMERA] Stream %s is now streaming", data->name);
-            break;
-        case PW_STREAM_STATE_ERROR:
-            syslog(LOG_ERR, "[CAMERA] Stream %s error: %s", data->name, error);
-            running = false;
-            break;
-        default:
-            break;
+    for (size_t off = 0; off < num_samples; off += REPLAY_QUANTUM) {
+        size_t n = num_samples - off < REPLAY_QUANTUM ? num_samples - off : REPLAY_QUANTUM;
+        capture_frames((const uint8_t *)(samples + off), (uint32_t)n);
     }
+    onset_trigger = saved_trigger;
+    return replay_latency_count;
 }
 
-static const struct pw_stream_events stream_events = {
-    PW_VERSION_STREAM_EVENTS,
-    .param_changed = on_param_changed,
-    .process = on_process,
-    .state_changed = on_state_changed,
-};
-
 /**
- * Registry global callback (adapted from official audiocapture.c)
+ * Latency report: regular windows only against onset-triggered windows, fed in capture-sized buffers
  */
-static void registry_event_global(void *data, uint32_t id, uint32_t permissions,
-                                const char *type, uint32_t version,
-                                const struct spa_dict *props) {
-    const char *media_class, *node_name;
-    struct stream_data *stream_data;
-    struct pw_properties *stream_props;
-    const struct spa_pod *params[1];
-    uint8_t buffer[1024];
-    struct spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
-
-    if (strcmp(type, PW_TYPE_INTERFACE_Node) != 0) {
+static void replay_latency_report(const sample_t *samples, size_t num_samples) {
+    struct spa_audio_info_raw raw = { .format = CAPTURE_FORMAT, .rate = TARGET_SAMPLE_RATE, .channels = 1 };
+    replay_latency_cap = num_samples / HOP_LENGTH + 1;
+    replay_latencies = calloc(replay_latency_cap, sizeof(float));
+    if (!replay_latencies || !bind_conversion_chain(&capture_chain, &raw)) {
+        free(replay_latencies);
+        replay_latencies = NULL;
         return;
     }
-
-    media_class = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
-    node_name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
-
-    if (media_class == NULL || node_name == NULL) {
-        return;
+    realtime_mode = false;
+    ml_ready = true;
+    
+    printf("\nImpulse-to-decision latency, streamed in %d-sample buffers:\n", REPLAY_QUANTUM);
+    printf("windows            events  median_ms  p90_ms  max_ms\n");
+    // Onset windows do not apply to a streaming model, so it gets a single pass
+    const int passes = active_backend->streaming ? 1 : 2;
+    for (int pass = 0; pass < passes; pass++) {
+        size_t n = replay_stream(samples, num_samples, pass == 1);
+        qsort(replay_latencies, n, sizeof(float), compare_float);
+        printf("%-17s  %6zu", passes == 1 ? "streaming" : pass ? "onset-triggered" : "regular only", n);
+        if (n > 0) {
+            printf("  %9.0f  %6.0f  %6.0f", replay_latencies[n / 2], replay_latencies[n * 9 / 10],
+                   replay_latencies[n - 1]);
+        }
+        printf("\n");
     }
+    free(replay_latencies);
+    replay_latencies = NULL;
+    replay_latency_cap = 0;
+}
 
-    // Log all discovered audio nodes
-    syslog(LOG_INFO, "[REGISTRY] Found %s node %s with id %d.", media_class, node_name, id);
-
-    // Only connect to AudioDevice0Input0 nodes (like official example)
-    if (!strstr(node_name, "AudioDevice0Input0")) {
-        return;
+/**
+ * Offline replay: run a WAV through both cascade stages and report recall loss against compute saved,
+ * then stream it through the live path to compare detection latency with and without onset triggering
+ */
+static int run_replay(const char *wav_path) {
+    static const int sweep[] = { 0, 1, 2, 5, 10, 15, 20, 30, 40, 50 };
+    size_t num_samples = 0;
+    sample_t *samples = load_wav_file(wav_path, &num_samples);
+    if (!samples) {
+        return 1;
     }
+    
+    // A streaming model has no windows to screen: only the live-path latency comparison applies
+    if (active_backend->streaming) {
+        printf("Replay %s: streaming model, %d new frame(s) per step\n", wav_path, active_backend->inputFrames);
+        replay_latency_report(samples, num_samples);
+        free(samples);
+        return 0;
+    }
+    
+    size_t num_windows = num_samples / WINDOW_SAMPLES;
+    float *screens = calloc(num_windows + 1, sizeof(float));
+    bool *detections = calloc(num_windows + 1, sizeof(bool));
+    uint64_t stage_us[GUNSHOT_STAGE_COUNT] = { 0 };
+    size_t analysed = 0, gated = 0, detected = 0;
+    
+    for (size_t w = 0; w < num_windows; w++) {
+        const sample_t *window = samples + w * WINDOW_SAMPLES;
+        if (window_rms(window, WINDOW_SAMPLES) < MIN_RMS_THRESHOLD) {
+            gated++;
+            continue;
+        }
+        
+        float mel_features[EXPECTED_INPUT_SIZE];
+        larodError *error = NULL;
+        uint64_t t0 = monotonic_us();
+        compute_mel_spectrogram(window, WINDOW_SAMPLES, mel_features);
+        uint64_t t1 = monotonic_us();
+        float screen = screen_score(mel_features);
+        uint64_t t2 = monotonic_us();
+        model_write_input(active_backend, mel_features);
+        uint64_t t3 = monotonic_us();
+        
+        // Every window reaches the full model here so both stages can be compared
+        if (!larodRunJob(active_backend->conn, active_backend->infReq, &error)) {
+            fprintf(stderr, "Inference failed: %s\n", error ? error->msg : "Unknown error");
+            larodClearError(&error);
+            free(samples);
+            free(screens);
+            free(detections);
+            return 1;
+        }
+        uint64_t t4 = monotonic_us();
+        
+        stage_us[GUNSHOT_STAGE_MEL] += t1 - t0;
+        stage_us[GUNSHOT_STAGE_SCREEN] += t2 - t1;
+        stage_us[GUNSHOT_STAGE_QUANTIZE] += t3 - t2;
+        stage_us[GUNSHOT_STAGE_INFERENCE] += t4 - t3;
+        screens[analysed] = screen;
+        float probability = 0.0f;
+        detections[analysed] = model_read_decision(active_backend, &probability);
+        detected += detections[analysed];
+        analysed++;
+    }
+    
+    printf("Replay %s: %zu windows of %.2f s (%zu gated as silent, %zu analysed)\n",
+           wav_path, num_windows, (double)WINDOW_SAMPLES / TARGET_SAMPLE_RATE, gated, analysed);
+    printf("Full-model detections at %.0f%%: %zu\n", confidence_threshold * 100.0f, detected);
+    if (analysed == 0) {
+        free(samples);
+        free(screens);
+        free(detections);
+        return 0;
+    }
+    
+    double mean_us[GUNSHOT_STAGE_COUNT];
+    double window_cost = 0.0;
+    printf("Mean stage time per analysed window:");
+    for (int i = GUNSHOT_STAGE_MEL; i <= GUNSHOT_STAGE_INFERENCE; i++) {
+        mean_us[i] = (double)stage_us[i] / analysed;
+        window_cost += mean_us[i];
+        printf(" %s %.0f us", gunshot_stage_names[i], mean_us[i]);
+    }
+    printf("\n\n");
+    
+    // Screened-out windows skip quantization and inference; recall is relative to the full model alone
+    printf("screen  pass_rate  recall   missed  compute_saved\n");
+    for (size_t t = 0; t < sizeof(sweep) / sizeof(sweep[0]); t++) {
+        float threshold = sweep[t] / 100.0f;
+        size_t passed = 0, kept = 0;
+        for (size_t i = 0; i < analysed; i++) {
+            if (screens[i] >= threshold) {
+                passed++;
+                kept += detections[i];
+            }
+        }
+        double saved = (analysed - passed) * (mean_us[GUNSHOT_STAGE_QUANTIZE] + mean_us[GUNSHOT_STAGE_INFERENCE]) /
+                       (analysed * window_cost);
+        printf("%4d%%%c  %8.1f%%  %6.1f%%  %6zu  %12.1f%%\n", sweep[t],
+               sweep[t] == (int)lrintf(cascade_threshold * 100.0f) ? '*' : ' ',
+               100.0 * passed / analysed, detected ? 100.0 * kept / detected : 100.0,
+               detected - kept, 100.0 * saved);
+    }
+    printf("(* = configured cascade_threshold)\n");
+    
+    replay_latency_report(samples, num_samples);
+    
+    free(samples);
+    free(screens);
+    free(detections);
+    return 0;
+}
 
-    syslog(LOG_INFO, "[CAMERA] *** CONNECTING TO AUDIO INPUT: %s ***", node_name);
-
-    stream_data = calloc(1, sizeof(struct stream_data));
-    strncpy(stream_data->name, node_name, sizeof(stream_data->name) - 1);
-    stream_data->is_target_stream = false;
-
-    stream_props = pw_properties_new(
-        PW_KEY_MEDIA_TYPE, "Audio",
-        PW_KEY_MEDIA_CATEGORY, "Capture",
-        PW_KEY_TARGET_OBJECT, node_name,
-        NULL);
-
-    stream_data->stream = pw_stream_new(core, "Gunshot Detector", stream_props);
-
-    pw_stream_add_listener(stream_data->stream, &stream_data->stream_listener,
-                          &stream_events, stream_data);
+// Numerical parity self-check: the compiled front-end against a double-precision reference
+#define SELFCHECK_GOLDEN_MAGIC "GSGV"
+#define SELFCHECK_GOLDEN_VERSION 1
+#define SELFCHECK_WINDOWS 6
+#define SELFCHECK_INPUT_SCALE (80.0f / 255.0f)  // Bundled model's input quantization
+#define SELFCHECK_INPUT_ZERO_POINT 127
+#ifdef GUNSHOT_FIXED_POINT
+#define SELFCHECK_MEL_TOLERANCE_DB 0.5      // Q15 window/FFT rounding and 8-bit log2 mantissa
+#define SELFCHECK_FLIP_TOLERANCE 0.05       // Fraction of tensor elements one step off
+#define SELFCHECK_DYNAMIC_RANGE_DB 50.0f    // Q15 twiddle noise floor below a frame's loudest band
+#else
+#define SELFCHECK_MEL_TOLERANCE_DB 0.05     // float32 FFT rounding near the -80 dB floor
+#define SELFCHECK_FLIP_TOLERANCE 0.01
+#define SELFCHECK_DYNAMIC_RANGE_DB 80.0f    // The whole -80..0 dB feature range
+#endif
 
-    params[0] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat,
-                                          &SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32));
+/**
+ * Golden vector file header; each window follows as WINDOW_SAMPLES float input (full scale),
+ * N_FRAMES x N_MELS float mel dB (frame-major) and the N_MELS x N_FRAMES int8 tensor (mel-major)
+ */
+struct selfcheck_golden_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t windows;
+    uint32_t window_samples;
+    uint32_t n_frames;
+    uint32_t n_mels;
+    float input_scale;
+    int32_t input_zero_point;
+};
 
-    pw_stream_connect(stream_data->stream,
-                     PW_DIRECTION_INPUT,
-                     PW_ID_ANY,
-                     PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS,
-                     params, 1);
-}
+struct selfcheck_window {
+    char name[32];
+    float input[WINDOW_SAMPLES];
+    float mel_db[N_FRAMES * N_MELS];
+    int8_t tensor[N_MELS * N_FRAMES];
+};
 
-static const struct pw_registry_events registry_events = {
-    PW_VERSION_REGISTRY_EVENTS,
-    .global = registry_event_global,
+/**
+ * Input tensor layouts model_write_input is checked in
+ */
+static const struct selfcheck_layout {
+    const char *name;
+    larodTensorDataType type;
+    bool mel_major;
+    int32_t zero_point;
+} selfcheck_layouts[] = {
+    { "int8 mel-major", LAROD_TENSOR_DATA_TYPE_INT8, true, SELFCHECK_INPUT_ZERO_POINT },
+    { "int8 frame-major", LAROD_TENSOR_DATA_TYPE_INT8, false, SELFCHECK_INPUT_ZERO_POINT },
+    { "uint8 mel-major", LAROD_TENSOR_DATA_TYPE_UINT8, true, SELFCHECK_INPUT_ZERO_POINT + 128 },
+    { "float32 frame-major", LAROD_TENSOR_DATA_TYPE_FLOAT32, false, 0 },
 };
 
 /**
- * Initialize LAROD (from v1.1.78 working model)
+ * Deterministic test windows covering level extremes, tones, sweeps and impulses
  */
-static bool init_larod(const char *model_path) {
-    larodError *error = NULL;
-    
-    syslog(LOG_INFO, "Initializing LAROD with model: %s", model_path);
+static void selfcheck_synthesize(struct selfcheck_window *w, int index) {
+    static const char *const names[SELFCHECK_WINDOWS] = {
+        "noise -20 dBFS", "tone 1 kHz -6 dBFS", "chirp 50 Hz-10 kHz", "impulses over -50 dBFS",
+        "noise -70 dBFS", "clipped square",
+    };
+    uint32_t seed = 0x9E3779B9u + (uint32_t)index;
+    snprintf(w->name, sizeof(w->name), "%s", names[index]);
     
-    if (!larodConnect(&conn, &error)) {
-        syslog(LOG_ERR, "Failed to connect to LAROD: %s", error->msg);
-        larodClearError(&error);
-        return false;
+    for (int i = 0; i < WINDOW_SAMPLES; i++) {
+        double t = (double)i / TARGET_SAMPLE_RATE;
+        float x = 0.0f;
+        switch (index) {
+        case 0: x = 0.1f * uniform_noise(&seed); break;
+        case 1: x = 0.5f * (float)sin(2.0 * M_PI * 1000.0 * t) + 0.001f * uniform_noise(&seed); break;
+        case 2: {
+            double duration = (double)WINDOW_SAMPLES / TARGET_SAMPLE_RATE;
+            double k = log(10000.0 / 50.0) / duration;
+            x = 0.25f * (float)sin(2.0 * M_PI * 50.0 * (exp(k * t) - 1.0) / k);
+            break;
+        }
+        case 3: {
+            // Decaying noise bursts every 0.9 s, a crude muzzle blast
+            double since = fmod(t + 0.2, 0.9);
+            x = 0.003f * uniform_noise(&seed) + 0.8f * (float)exp(-since * 60.0) * uniform_noise(&seed);
+            break;
+        }
+        case 4: x = 0.0003f * uniform_noise(&seed); break;
+        default: x = sin(2.0 * M_PI * 440.0 * t) >= 0.0 ? 1.0f : -1.0f; break;
+        }
+        if (x > 1.0f) x = 1.0f;
+        if (x < -1.0f) x = -1.0f;
+        // On the S16 grid, so float and Q15 builds see the same samples and share golden files
+        w->input[i] = lrintf(x * 32767.0f) / 32768.0f;
     }
+}
+
+/**
+ * Reference mel dB (frame-major, clamped to -80..0): direct DFT and a freshly computed filter bank, all in double
+ */
+static void selfcheck_reference_mel(const float *input, float *mel_db) {
+    static double filters[N_MELS][N_FFT_BINS];
+    static double cos_table[N_FFT], sin_table[N_FFT], window[N_FFT];
+    static bool ready = false;
     
-    dev = larodGetDevice(conn, "cpu-tflite", 0, &error);
-    if (!dev) {
-        syslog(LOG_ERR, "CPU-tflite device not available: %s", error->msg);
-        larodClearError(&error);
-        return false;
+    if (!ready) {
+        double mel_min = 2595.0 * log10(1.0 + MEL_FMIN / 700.0);
+        double mel_max = 2595.0 * log10(1.0 + MEL_FMAX / 700.0);
+        int bins[N_MELS + 2];
+        for (int i = 0; i < N_MELS + 2; i++) {
+            double hz = 700.0 * (pow(10.0, (mel_min + (mel_max - mel_min) * i / (N_MELS + 1)) / 2595.0) - 1.0);
+            double bin = floor(hz * N_FFT / TARGET_SAMPLE_RATE);
+            bins[i] = (int)bin;
+            if (bins[i] >= N_FFT_BINS) bins[i] = N_FFT_BINS - 1;
+        }
+        for (int m = 0; m < N_MELS; m++) {
+            double area = 0.0;
+            for (int k = bins[m]; k < bins[m + 2]; k++) {
+                filters[m][k] = k < bins[m + 1] ? (double)(k - bins[m]) / (bins[m + 1] - bins[m])
+                                                : (double)(bins[m + 2] - k) / (bins[m + 2] - bins[m + 1]);
+                area += filters[m][k];
+            }
+            for (int k = 0; k < N_FFT_BINS && MEL_NORM_SLANEY && area > 0.0; k++) {
+                filters[m][k] /= area;
+            }
+        }
+        for (int i = 0; i < N_FFT; i++) {
+            cos_table[i] = cos(2.0 * M_PI * i / N_FFT);
+            sin_table[i] = sin(2.0 * M_PI * i / N_FFT);
+            window[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / (N_FFT - 1)));
+        }
+        ready = true;
     }
     
-    int modelFd = open(model_path, O_RDONLY);
-    if (modelFd < 0) {
-        syslog(LOG_ERR, "Failed to open model file: %s", model_path);
-        return false;
+    for (int f = 0; f < N_FRAMES; f++) {
+        double frame[N_FFT], power[N_FFT_BINS];
+        for (int i = 0; i < N_FFT; i++) {
+            frame[i] = input[f * HOP_LENGTH + i] * window[i];
+        }
+        for (int k = 0; k < N_FFT_BINS; k++) {
+            double re = 0.0, im = 0.0;
+            for (int i = 0; i < N_FFT; i++) {
+                re += frame[i] * cos_table[(k * i) % N_FFT];
+                im -= frame[i] * sin_table[(k * i) % N_FFT];
+            }
+            power[k] = re * re + im * im;
+        }
+        for (int m = 0; m < N_MELS; m++) {
+            double energy = 0.0;
+            for (int k = 0; k < N_FFT_BINS; k++) {
+                energy += filters[m][k] * power[k];
+            }
+            double db = 10.0 * log10(fmax(energy, 1e-10));
+            mel_db[f * N_MELS + m] = (float)fmin(fmax(db, -80.0), 0.0);
+        }
     }
-    
-    model = larodLoadModel(conn, modelFd, dev, LAROD_ACCESS_PRIVATE, 
-                          "GunShotModel", NULL, &error);
-    close(modelFd);
-    
-    if (!model) {
-        syslog(LOG_ERR, "Failed to load model: %s", error->msg);
-        larodClearError(&error);
-        return false;
+}
+
+/**
+ * Reference quantization of one mel dB value for a layout
+ */
+static int32_t selfcheck_quantize(float db, const struct selfcheck_layout *layout) {
+    const int32_t q_min = layout->type == LAROD_TENSOR_DATA_TYPE_UINT8 ? 0 : -128;
+    const int32_t q_max = layout->type == LAROD_TENSOR_DATA_TYPE_UINT8 ? 255 : 127;
+    double q = nearbyint(db / (double)SELFCHECK_INPUT_SCALE + layout->zero_point);
+    return q < q_min ? q_min : q > q_max ? q_max : (int32_t)q;
+}
+
+/**
+ * Read golden vectors written by --selfcheck-write
+ */
+static struct selfcheck_window *selfcheck_read_golden(const char *path, uint32_t *windows) {
+    struct selfcheck_golden_header header;
+    struct selfcheck_window *golden = NULL;
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return NULL;
     }
-    
-    // Create temporary files for tensors
-    if (!create_and_map_tmp_file("/tmp/gunshot_input_XXXXXX", inputTensorSize, 
-                                 &inputTensorAddr, &inputTensorFd)) {
-        return false;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, SELFCHECK_GOLDEN_MAGIC, 4) != 0 ||
+        header.version != SELFCHECK_GOLDEN_VERSION || header.window_samples != WINDOW_SAMPLES ||
+        header.n_frames != N_FRAMES || header.n_mels != N_MELS || header.windows == 0 ||
+        fabsf(header.input_scale - SELFCHECK_INPUT_SCALE) > 1e-6f ||
+        header.input_zero_point != SELFCHECK_INPUT_ZERO_POINT) {
+        fprintf(stderr, "%s: not a golden vector file for this front-end configuration\n", path);
+        fclose(file);
+        return NULL;
     }
-    
-    if (!create_and_map_tmp_file("/tmp/gunshot_output_XXXXXX", outputTensorSize, 
-                                 &outputTensorAddr, &outputTensorFd)) {
-        return false;
+    golden = calloc(header.windows, sizeof(*golden));
+    for (uint32_t w = 0; golden && w < header.windows; w++) {
+        snprintf(golden[w].name, sizeof(golden[w].name), "golden %u", w);
+        if (fread(golden[w].input, sizeof(golden[w].input), 1, file) != 1 ||
+            fread(golden[w].mel_db, sizeof(golden[w].mel_db), 1, file) != 1 ||
+            fread(golden[w].tensor, sizeof(golden[w].tensor), 1, file) != 1) {
+            fprintf(stderr, "%s: truncated at window %u\n", path, w);
+            free(golden);
+            golden = NULL;
+        }
     }
-    
-    // Create model tensors
-    inputTensors = larodCreateModelInputs(model, &numInputs, &error);
-    if (!inputTensors || numInputs != 1) {
-        syslog(LOG_ERR, "Failed to create input tensors");
-        larodClearError(&error);
-        return false;
+    fclose(file);
+    *windows = header.windows;
+    return golden;
+}
+
+/**
+ * Write the synthetic windows and their reference features as golden vectors
+ */
+static int selfcheck_write_golden(const char *path) {
+    struct selfcheck_golden_header header = {
+        .version = SELFCHECK_GOLDEN_VERSION, .windows = SELFCHECK_WINDOWS, .window_samples = WINDOW_SAMPLES,
+        .n_frames = N_FRAMES, .n_mels = N_MELS, .input_scale = SELFCHECK_INPUT_SCALE,
+        .input_zero_point = SELFCHECK_INPUT_ZERO_POINT,
+    };
+    memcpy(header.magic, SELFCHECK_GOLDEN_MAGIC, 4);
+    struct selfcheck_window *w = malloc(sizeof(*w));
+    FILE *file = fopen(path, "wb");
+    if (!w || !file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        free(w);
+        if (file) fclose(file);
+        return 1;
     }
     
-    outputTensors = larodCreateModelOutputs(model, &numOutputs, &error);
-    if (!outputTensors || numOutputs < 1) {
-        syslog(LOG_ERR, "Failed to create output tensors");
-        larodClearError(&error);
-        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; ok && i < SELFCHECK_WINDOWS; i++) {
+        selfcheck_synthesize(w, i);
+        selfcheck_reference_mel(w->input, w->mel_db);
+        for (int f = 0; f < N_FRAMES; f++) {
+            for (int m = 0; m < N_MELS; m++) {
+                w->tensor[m * N_FRAMES + f] = (int8_t)selfcheck_quantize(w->mel_db[f * N_MELS + m], &selfcheck_layouts[0]);
+            }
+        }
+        ok = fwrite(w->input, sizeof(w->input), 1, file) == 1 && fwrite(w->mel_db, sizeof(w->mel_db), 1, file) == 1 &&
+             fwrite(w->tensor, sizeof(w->tensor), 1, file) == 1;
     }
-    
-    // Associate file descriptors with tensors
-    if (!larodSetTensorFd(inputTensors[0], inputTensorFd, &error)) {
-        syslog(LOG_ERR, "Failed to set input tensor fd: %s", error->msg);
-        larodClearError(&error);
-        return false;
+    ok = fclose(file) == 0 && ok;
+    free(w);
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", path);
+        return 1;
     }
-    
-    if (!larodSetTensorFd(outputTensors[0], outputTensorFd, &error)) {
-        syslog(LOG_ERR, "Failed to set output tensor fd: %s", error->msg);
-        larodClearError(&error);
-        return false;
+    printf("Wrote %d golden windows to %s\n", SELFCHECK_WINDOWS, path);
+    return 0;
+}
+
+/**
+ * Compare the compiled mel kernel and every input tensor layout against reference or golden vectors.
+ * Returns 0 when every window is within tolerance
+ */
+static int run_selfcheck(const char *golden_path) {
+    uint32_t windows = SELFCHECK_WINDOWS;
+    struct selfcheck_window *expected = golden_path ? selfcheck_read_golden(golden_path, &windows)
+                                                    : calloc(SELFCHECK_WINDOWS, sizeof(*expected));
+    sample_t *samples = malloc(WINDOW_SAMPLES * sizeof(sample_t));
+    float *mel_features = malloc(EXPECTED_INPUT_SIZE * sizeof(float));
+    float *tensor = malloc(EXPECTED_INPUT_SIZE * sizeof(float));  // Large enough for every layout
+    if (!expected || !samples || !mel_features || !tensor) {
+        free(expected);
+        free(samples);
+        free(mel_features);
+        free(tensor);
+        return 1;
     }
     
-    // Create job request
-    infReq = larodCreateJobRequest(model, inputTensors, numInputs, 
-                                   outputTensors, numOutputs, NULL, &error);
-    if (!infReq) {
-        syslog(LOG_ERR, "Failed to create job request: %s", error->msg);
-        larodClearError(&error);
-        return false;
+    const size_t n_layouts = sizeof(selfcheck_layouts) / sizeof(selfcheck_layouts[0]);
+    const int flip_limit = (int)(SELFCHECK_FLIP_TOLERANCE * EXPECTED_INPUT_SIZE);
+    bool pass = true;
+    
+    printf("Front-end self-check (%s, %s): mel within %.3f dB and at most %d int flips (one step) per window,\n"
+           "over values within %.0f dB of their frame's loudest band\n",
+#ifdef GUNSHOT_FIXED_POINT
+           "Q15",
+#else
+           "float",
+#endif
+           golden_path ? golden_path : "double-precision reference", SELFCHECK_MEL_TOLERANCE_DB, flip_limit,
+           SELFCHECK_DYNAMIC_RANGE_DB);
+    printf("%-24s %-20s %12s %12s %8s %8s %6s\n", "window", "stage", "max_abs_err", "mean_abs_err", "flips",
+           "floored", "result");
+    
+    for (uint32_t w = 0; w < windows; w++) {
+        struct selfcheck_window *x = &expected[w];
+        if (!golden_path) {
+            selfcheck_synthesize(x, (int)w);
+            selfcheck_reference_mel(x->input, x->mel_db);
+        }
+        for (int i = 0; i < WINDOW_SAMPLES; i++) {
+#ifdef GUNSHOT_FIXED_POINT
+            long v = lrintf(x->input[i] * 32768.0f);
+            samples[i] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+#else
+            samples[i] = x->input[i];
+#endif
+        }
+        compute_mel_spectrogram(samples, WINDOW_SAMPLES, mel_features);
+        
+        // Values under the front-end's dynamic range are counted but not held to the tolerance
+        float floor_db[N_FRAMES];
+        int floored = 0;
+        for (int f = 0; f < N_FRAMES; f++) {
+            floor_db[f] = -80.0f;
+            for (int m = 0; m < N_MELS; m++) {
+                floor_db[f] = fmaxf(floor_db[f], x->mel_db[f * N_MELS + m] - SELFCHECK_DYNAMIC_RANGE_DB);
+            }
+            for (int m = 0; m < N_MELS; m++) {
+                floored += x->mel_db[f * N_MELS + m] < floor_db[f];
+            }
+        }
+        
+        // Mel stage, compared in dB
+        double max_err = 0.0, sum_err = 0.0;
+        for (int i = 0; i < EXPECTED_INPUT_SIZE; i++) {
+            if (x->mel_db[i] < floor_db[i / N_MELS]) {
+                continue;
+            }
+            double err = fabs((80.0 * mel_features[i] - 80.0) - x->mel_db[i]);
+            max_err = fmax(max_err, err);
+            sum_err += err;
+        }
+        const int compared = EXPECTED_INPUT_SIZE - floored;
+        bool ok = max_err <= SELFCHECK_MEL_TOLERANCE_DB;
+        pass = pass && ok;
+        printf("%-24s %-20s %9.4f dB %9.4f dB %8s %8d %6s\n", x->name, "mel", max_err,
+               compared ? sum_err / compared : 0.0, "-", floored, ok ? "ok" : "FAIL");
+        
+        // Quantize stage, in each layout the model loader accepts
+        for (size_t l = 0; l < n_layouts; l++) {
+            const struct selfcheck_layout *layout = &selfcheck_layouts[l];
+            struct model_backend backend = {
+                .inputType = layout->type, .inputMelMajor = layout->mel_major, .inputFrames = N_FRAMES,
+                .inputScale = SELFCHECK_INPUT_SCALE,
+                .inputZeroPoint = layout->zero_point, .inputTensorAddr = tensor,
+            };
+            model_write_input(&backend, mel_features);
+            
+            int flips = 0, max_step = 0;
+            max_err = 0.0;
+            sum_err = 0.0;
+            for (int f = 0; f < N_FRAMES; f++) {
+                for (int m = 0; m < N_MELS; m++) {
+                    int i = layout->mel_major ? m * N_FRAMES + f : f * N_MELS + m;
+                    float db = x->mel_db[f * N_MELS + m];
+                    if (db < floor_db[f]) {
+                        continue;
+                    }
+                    if (layout->type == LAROD_TENSOR_DATA_TYPE_FLOAT32) {
+                        double err = fabs(tensor[i] - db);
+                        max_err = fmax(max_err, err);
+                        sum_err += err;
+                        continue;
+                    }
+                    int32_t want = golden_path && l == 0 ? x->tensor[i] : selfcheck_quantize(db, layout);
+                    int32_t got = layout->type == LAROD_TENSOR_DATA_TYPE_UINT8 ? ((uint8_t *)tensor)[i]
+                                                                               : ((int8_t *)tensor)[i];
+                    int step = abs(got - want);
+                    flips += step != 0;
+                    if (step > max_step) max_step = step;
+                }
+            }
+            if (layout->type == LAROD_TENSOR_DATA_TYPE_FLOAT32) {
+                ok = max_err <= SELFCHECK_MEL_TOLERANCE_DB;
+                printf("%-24s %-20s %9.4f dB %9.4f dB %8s %8d %6s\n", "", layout->name, max_err,
+                       compared ? sum_err / compared : 0.0, "-", floored, ok ? "ok" : "FAIL");
+            } else {
+                ok = flips <= flip_limit && max_step <= 1;
+                printf("%-24s %-20s %9d q  %12s %8d %8d %6s\n", "", layout->name, max_step, "-", flips, floored,
+                       ok ? "ok" : "FAIL");
+            }
+            pass = pass && ok;
+        }
     }
     
-    syslog(LOG_INFO, "LAROD inference engine initialized successfully");
-    return true;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    free(expected);
+    free(samples);
+    free(mel_features);
+    free(tensor);
+    return pass ? 0 : 1;
 }
 
 /**
@@ -1067,11 +7499,44 @@ static void signal_handler(int sig) {
     pw_main_loop_quit(loop);
 }
 
+/**
+ * SIGHUP: reload the model in the background, audio keeps flowing
+ */
+static void reload_signal_handler(int sig) {
+    model_reload_requested = 1;
+    heads_reload_requested = 1;
+}
+
 /**
  * Main function (adapted from official audiocapture.c structure)
  */
-int main(void) {
-    openlog("gunshot_detector", LOG_PID | LOG_CONS, LOG_USER);
+int main(int argc, char *argv[]) {
+    const char *replay_path = NULL;
+    const char *golden_path = NULL;
+    bool selfcheck = false, selfcheck_write = false;
+    const struct audio_source *source = &pipewire_source;
+    if (argc == 3 && strcmp(argv[1], "--replay") == 0) {
+        replay_path = argv[2];
+    } else if ((argc == 2 || argc == 3) && strcmp(argv[1], "--synthetic") == 0) {
+        if (argc == 3 && !parse_synthetic_spec(argv[2])) {
+            return 2;
+        }
+        source = &synthetic_source;
+    } else if ((argc == 2 || argc == 3) && strcmp(argv[1], "--selfcheck") == 0) {
+        selfcheck = true;
+        golden_path = argc == 3 ? argv[2] : NULL;
+    } else if (argc == 3 && strcmp(argv[1], "--selfcheck-write") == 0) {
+        selfcheck_write = true;
+        golden_path = argv[2];
+    } else if (argc > 1) {
+        fprintf(stderr, "Usage: %s [--replay file.wav | --selfcheck [golden.bin] | --selfcheck-write golden.bin |\n"
+                "        --synthetic [rate=,channels=,format=,quantum=,jitter=,noise=,impulse=,interval=,speed=,duration=]]\n",
+                argv[0]);
+        return 2;
+    }
+    
+    startup_begin_us = monotonic_us();
+    openlog("gunshot_detector", LOG_PID | LOG_CONS | (source == &synthetic_source ? LOG_PERROR : 0), LOG_USER);
     syslog(LOG_INFO, "Gunshot Detector v1.1.100 starting - Debug Parameter Parsing");
     
     // Initialize curl for email notifications
@@ -1080,63 +7545,117 @@ int main(void) {
     // Debug parameter file locations
     debug_parameter_locations();
     
-    // Load configuration
+    // Load configuration and the last known audio node
     load_config();
+    load_node_cache();
+    startup_mark("config loaded");
     
     // Setup safe config file monitoring  
     setup_config_monitoring();
     
-    
     // Install signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGHUP, reload_signal_handler);
     
-    // Initialize LAROD
-    if (!init_larod("/usr/local/packages/gunshot_detector/gunshot_model_real_audio.tflite")) {
-        syslog(LOG_ERR, "Failed to initialize LAROD");
+#ifndef GUNSHOT_FIXED_POINT
+    // FFTW workspace; window and mel tables are generated at build time
+    if (!init_fft_workspace()) {
+        syslog(LOG_ERR, "Failed to initialize audio processing");
         return 1;
     }
+#endif
+    init_canned_window();
+    init_screen_weights();
+    startup_mark("DSP ready");
     
-    // Initialize FFT and mel filters
-    if (!init_fft_workspace() || !init_mel_filter_bank()) {
-        syslog(LOG_ERR, "Failed to initialize audio processing");
-        return 1;
+    // Front-end parity check, no model or PipeWire needed
+    if (selfcheck || selfcheck_write) {
+        int rc = selfcheck_write ? selfcheck_write_golden(golden_path) : run_selfcheck(golden_path);
+        curl_global_cleanup();
+        closelog();
+        return rc;
     }
     
-    ml_ready = true;
-    syslog(LOG_INFO, "Machine learning pipeline ready");
+    // Offline cascade report, leaves the live detector's stats block alone
+    if (replay_path) {
+        active_backend = model_backend_load_initial(model_path);
+        if (!active_backend) {
+            syslog(LOG_ERR, "Failed to initialize LAROD");
+            return 1;
+        }
+        int rc = run_replay(replay_path);
+        model_backend_destroy(active_backend);
+        curl_global_cleanup();
+        closelog();
+        return rc;
+    }
+    
+    // Publish live stats for other processes
+    init_stats_shm();
+    
+    // Detection reactions run on their own threads, started before the analysis thread can go real-time
+    event_bus_start();
     
     // Initialize PipeWire (following official audiocapture.c pattern)
     pw_init(NULL, NULL);
     
     loop = pw_main_loop_new(NULL);
-    context = pw_context_new(pw_main_loop_get_loop(loop), NULL, 0);
-    core = pw_context_connect(context, NULL, 0);
-    registry = pw_core_get_registry(core, PW_VERSION_REGISTRY, 0);
     
-    pw_registry_add_listener(registry, &registry_listener, &registry_events, NULL);
-    
-    syslog(LOG_INFO, "PipeWire initialized - discovering camera audio devices...");
+    // Load, warm up and verify the model while PipeWire connects and discovers the audio node
+    model_startup_event = pw_loop_add_event(pw_main_loop_get_loop(loop), on_model_startup_done, NULL);
+    snprintf(startup_model_path, sizeof(startup_model_path), "%s", model_path);
+    if (!model_startup_event || pthread_create(&model_startup_thread, NULL, model_startup_main, NULL) != 0) {
+        syslog(LOG_ERR, "[MODEL] Failed to start model loader thread");
+        return 1;
+    }
+    model_startup_running = true;
+    startup_mark("model load started");
     
-    // Run main loop
-    pw_main_loop_run(loop);
+    if (source->start()) {
+        // Optional Prometheus endpoint, serviced from the same main loop
+        setup_metrics_endpoint();
+        
+        // Run main loop
+        pw_main_loop_run(loop);
+    } else {
+        syslog(LOG_ERR, "Failed to start the %s audio source", source->name);
+        startup_failed = true;
+    }
     
     syslog(LOG_INFO, "Shutting down gunshot detector...");
     
     
     // Cleanup
-    if (registry) pw_proxy_destroy((struct pw_proxy*)registry);
-    if (core) pw_core_disconnect(core);
-    if (context) pw_context_destroy(context);
+    cleanup_metrics_endpoint();
+    source->stop();
+    event_bus_stop();
+    
+    // The startup loader may still be inside larod; wait for it before releasing models
+    if (model_startup_running) {
+        pthread_join(model_startup_thread, NULL);
+    }
+    if (model_startup_event) pw_loop_destroy_source(pw_main_loop_get_loop(loop), model_startup_event);
     if (loop) pw_main_loop_destroy(loop);
     
     pw_deinit();
     
+    // Release models (a reload still in flight is left to process exit)
+    model_backend_destroy(atomic_exchange(&startup_backend, NULL));
+    model_backend_destroy(atomic_exchange(&staged_backend, NULL));
+    model_backend_destroy(active_backend);
+    active_backend = NULL;
+    head_set_destroy(atomic_exchange(&staged_heads, NULL));
+    head_set_destroy(active_heads);
+    active_heads = NULL;
+    
     // Cleanup curl
     curl_global_cleanup();
     
+    cleanup_stats_shm();
+    
     syslog(LOG_INFO, "Gunshot detector stopped");
     closelog();
     
-    return 0;
+    return startup_failed ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+/**
+ * Edge Gunshot Detector - DSP configuration
+ * Shared by the detector and gen_dsp_tables, which bakes the window, twiddle and
+ * mel tables for this configuration into gunshot_dsp_tables.h at build time.
+ * © 2025 Claude Coding. All rights reserved.
+ */
+
+#ifndef GUNSHOT_DSP_CONFIG_H
+#define GUNSHOT_DSP_CONFIG_H
+
+// Audio processing constants (from v1.1.78 working model)
+#define TARGET_SAMPLE_RATE 22050
+#define N_FFT 1024
+#define HOP_LENGTH 512
+#define N_MELS 28
+#define N_FRAMES 160
+
+// Mel filter bank parameters
+#define N_FFT_BINS (N_FFT / 2 + 1)  // 513 bins
+#define MEL_FMIN 0.0f
+#define MEL_FMAX (TARGET_SAMPLE_RATE / 2.0f)  // Nyquist frequency
+#define MEL_NORM_SLANEY 1  // Use Slaney normalization (librosa default)
+
+#endif
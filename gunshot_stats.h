@@ -0,0 +1,134 @@
+/**
+ * Edge Gunshot Detector - shared-memory stats block
+ * Layout shared by the detector (single writer) and gunshot_stats_reader.
+ * © 2025 Claude Coding. All rights reserved.
+ */
+
+#ifndef GUNSHOT_STATS_H
+#define GUNSHOT_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define GUNSHOT_STATS_SHM_NAME "/gunshot_detector_stats"
+#define GUNSHOT_STATS_MAGIC 0x54534753u  // "GSST"
+#define GUNSHOT_STATS_VERSION 5
+#define GUNSHOT_STATS_READ_RETRIES 1000
+
+/**
+ * Pipeline stages with a latency summary
+ */
+enum gunshot_stage {
+    GUNSHOT_STAGE_MEL = 0,
+    GUNSHOT_STAGE_SCREEN,
+    GUNSHOT_STAGE_QUANTIZE,
+    GUNSHOT_STAGE_INFERENCE,
+    GUNSHOT_STAGE_WINDOW,
+    GUNSHOT_STAGE_COUNT
+};
+
+static const char *const gunshot_stage_names[GUNSHOT_STAGE_COUNT] = {
+    "mel", "screen", "quantize", "inference", "window"
+};
+
+/**
+ * Load-shedding ladder, cheapest last; each level keeps the savings of the ones before it
+ */
+enum gunshot_load_level {
+    GUNSHOT_LOAD_FULL = 0,
+    GUNSHOT_LOAD_WIDE_STRIDE,    // Fewer, more widely spaced windows
+    GUNSHOT_LOAD_CASCADE_ONLY,   // The screen decides, no model inference
+    GUNSHOT_LOAD_ENERGY_ONLY,    // Silence gate and crest factor only, no mel
+    GUNSHOT_LOAD_LEVELS
+};
+
+static const char *const gunshot_load_level_names[GUNSHOT_LOAD_LEVELS] = {
+    "full", "wide_stride", "cascade_only", "energy_only"
+};
+
+/**
+ * Latency summary for one stage (microseconds)
+ */
+struct gunshot_latency_summary {
+    uint64_t count;
+    float last_us;
+    float mean_us;  // Exponential moving average
+    float min_us;
+    float max_us;
+};
+
+/**
+ * Stats block; seq is odd while the writer is updating it
+ */
+struct gunshot_stats {
+    uint32_t magic;
+    uint32_t version;
+    _Atomic uint32_t seq;
+    uint32_t pid;
+    uint64_t started_unix;
+    uint64_t updated_unix_ms;
+
+    uint64_t inference_count;
+    uint64_t detection_count;
+    uint64_t windows_gated;
+    uint64_t windows_screened_out;  // Rejected by the first cascade stage
+    uint64_t buffers_dropped;
+    uint64_t events_count;       // Merged gunshot detection events (extra heads not included)
+    uint32_t event_active;       // 1 while an event is open
+    uint64_t window_minor_faults;          // Analysis thread, summed over analysed windows
+    uint64_t window_major_faults;
+    uint64_t window_involuntary_switches;
+    uint64_t windows_by_load_level[GUNSHOT_LOAD_LEVELS];
+    uint64_t load_sheds;         // Steps down the ladder
+    uint64_t load_restores;      // Steps back towards full quality
+    uint32_t load_level;         // enum gunshot_load_level
+
+    float last_confidence;       // Percent
+    float smoothed_confidence;   // Percent, decision engine EMA
+    float threshold;             // Percent
+    float real_time_factor;      // Processing time / audio time, EMA
+    float ring_lag_ms;           // How far the newest analysed window trails captured audio
+    uint32_t capture_rate;
+
+    struct gunshot_latency_summary stages[GUNSHOT_STAGE_COUNT];
+};
+
+/**
+ * Open a write section (single writer only)
+ */
+static inline void gunshot_stats_write_begin(struct gunshot_stats *s) {
+    uint32_t seq = atomic_load_explicit(&s->seq, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * Close a write section, publishing everything stored since begin
+ */
+static inline void gunshot_stats_write_end(struct gunshot_stats *s) {
+    uint32_t seq = atomic_load_explicit(&s->seq, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * Take a consistent snapshot without ever blocking the writer
+ */
+static inline bool gunshot_stats_read(const struct gunshot_stats *s, struct gunshot_stats *out) {
+    for (int attempt = 0; attempt < GUNSHOT_STATS_READ_RETRIES; attempt++) {
+        uint32_t before = atomic_load_explicit((_Atomic uint32_t *)&s->seq, memory_order_acquire);
+        if (before & 1) {
+            continue;  // Writer mid-update
+        }
+        memcpy((void *)out, (const void *)s, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t after = atomic_load_explicit((_Atomic uint32_t *)&s->seq, memory_order_relaxed);
+        if (before == after) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * Edge Gunshot Detector - stats reader
+ * Prints the detector's shared-memory stats block without blocking the detector.
+ * Usage: gunshot_stats_reader [-j]   (-j prints JSON for the web UI CGI)
+ * © 2025 Claude Coding. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "gunshot_stats.h"
+
+/**
+ * Print snapshot as key=value lines
+ */
+static void print_text(const struct gunshot_stats *s) {
+    printf("pid=%u\n", s->pid);
+    printf("started_unix=%llu\n", (unsigned long long)s->started_unix);
+    printf("updated_unix_ms=%llu\n", (unsigned long long)s->updated_unix_ms);
+    printf("inference_count=%llu\n", (unsigned long long)s->inference_count);
+    printf("detection_count=%llu\n", (unsigned long long)s->detection_count);
+    printf("windows_gated=%llu\n", (unsigned long long)s->windows_gated);
+    printf("windows_screened_out=%llu\n", (unsigned long long)s->windows_screened_out);
+    printf("buffers_dropped=%llu\n", (unsigned long long)s->buffers_dropped);
+    printf("events_count=%llu\n", (unsigned long long)s->events_count);
+    printf("event_active=%u\n", s->event_active);
+    printf("window_minor_faults=%llu\n", (unsigned long long)s->window_minor_faults);
+    printf("window_major_faults=%llu\n", (unsigned long long)s->window_major_faults);
+    printf("window_involuntary_switches=%llu\n", (unsigned long long)s->window_involuntary_switches);
+    printf("load_level=%s\n", s->load_level < GUNSHOT_LOAD_LEVELS ? gunshot_load_level_names[s->load_level] : "unknown");
+    printf("load_sheds=%llu\n", (unsigned long long)s->load_sheds);
+    printf("load_restores=%llu\n", (unsigned long long)s->load_restores);
+    for (int i = 0; i < GUNSHOT_LOAD_LEVELS; i++) {
+        printf("windows_%s=%llu\n", gunshot_load_level_names[i], (unsigned long long)s->windows_by_load_level[i]);
+    }
+    printf("last_confidence=%.1f\n", s->last_confidence);
+    printf("smoothed_confidence=%.1f\n", s->smoothed_confidence);
+    printf("threshold=%.0f\n", s->threshold);
+    printf("real_time_factor=%.4f\n", s->real_time_factor);
+    printf("ring_lag_ms=%.1f\n", s->ring_lag_ms);
+    printf("capture_rate=%u\n", s->capture_rate);
+    for (int i = 0; i < GUNSHOT_STAGE_COUNT; i++) {
+        const struct gunshot_latency_summary *l = &s->stages[i];
+        printf("latency_%s_us=count:%llu last:%.0f mean:%.0f min:%.0f max:%.0f\n",
+               gunshot_stage_names[i], (unsigned long long)l->count,
+               l->last_us, l->mean_us, l->min_us, l->max_us);
+    }
+}
+
+/**
+ * Print snapshot as a single JSON object
+ */
+static void print_json(const struct gunshot_stats *s) {
+    printf("{\"pid\":%u,\"started_unix\":%llu,\"updated_unix_ms\":%llu,",
+           s->pid, (unsigned long long)s->started_unix, (unsigned long long)s->updated_unix_ms);
+    printf("\"inference_count\":%llu,\"detection_count\":%llu,\"windows_gated\":%llu,"
+           "\"windows_screened_out\":%llu,\"buffers_dropped\":%llu,",
+           (unsigned long long)s->inference_count, (unsigned long long)s->detection_count,
+           (unsigned long long)s->windows_gated, (unsigned long long)s->windows_screened_out,
+           (unsigned long long)s->buffers_dropped);
+    printf("\"events_count\":%llu,\"event_active\":%u,",
+           (unsigned long long)s->events_count, s->event_active);
+    printf("\"window_minor_faults\":%llu,\"window_major_faults\":%llu,\"window_involuntary_switches\":%llu,",
+           (unsigned long long)s->window_minor_faults, (unsigned long long)s->window_major_faults,
+           (unsigned long long)s->window_involuntary_switches);
+    printf("\"load_level\":\"%s\",\"load_sheds\":%llu,\"load_restores\":%llu,\"windows_by_load_level\":{",
+           s->load_level < GUNSHOT_LOAD_LEVELS ? gunshot_load_level_names[s->load_level] : "unknown",
+           (unsigned long long)s->load_sheds, (unsigned long long)s->load_restores);
+    for (int i = 0; i < GUNSHOT_LOAD_LEVELS; i++) {
+        printf("%s\"%s\":%llu", i ? "," : "", gunshot_load_level_names[i],
+               (unsigned long long)s->windows_by_load_level[i]);
+    }
+    printf("},");
+    printf("\"last_confidence\":%.1f,\"smoothed_confidence\":%.1f,\"threshold\":%.0f,"
+           "\"real_time_factor\":%.4f,\"ring_lag_ms\":%.1f,\"capture_rate\":%u,",
+           s->last_confidence, s->smoothed_confidence, s->threshold, s->real_time_factor, s->ring_lag_ms,
+           s->capture_rate);
+    printf("\"latency_us\":{");
+    for (int i = 0; i < GUNSHOT_STAGE_COUNT; i++) {
+        const struct gunshot_latency_summary *l = &s->stages[i];
+        printf("%s\"%s\":{\"count\":%llu,\"last\":%.0f,\"mean\":%.0f,\"min\":%.0f,\"max\":%.0f}",
+               i ? "," : "", gunshot_stage_names[i], (unsigned long long)l->count,
+               l->last_us, l->mean_us, l->min_us, l->max_us);
+    }
+    printf("}}\n");
+}
+
+int main(int argc, char *argv[]) {
+    bool json = (argc > 1 && strcmp(argv[1], "-j") == 0);
+
+    int fd = shm_open(GUNSHOT_STATS_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Detector stats not available (%s): %s\n", GUNSHOT_STATS_SHM_NAME, strerror(errno));
+        return 1;
+    }
+
+    // Read-only mapping: the reader can never disturb the writer
+    const struct gunshot_stats *shared = mmap(NULL, sizeof(struct gunshot_stats), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shared == MAP_FAILED) {
+        fprintf(stderr, "Failed to map stats block: %s\n", strerror(errno));
+        return 1;
+    }
+
+    struct gunshot_stats snapshot;
+    if (!gunshot_stats_read(shared, &snapshot)) {
+        fprintf(stderr, "Stats block busy, try again\n");
+        return 2;
+    }
+    if (snapshot.magic != GUNSHOT_STATS_MAGIC || snapshot.version != GUNSHOT_STATS_VERSION) {
+        fprintf(stderr, "Stats block version mismatch (magic 0x%08x, version %u)\n",
+                snapshot.magic, snapshot.version);
+        return 1;
+    }
+
+    if (json) {
+        print_json(&snapshot);
+    } else {
+        print_text(&snapshot);
+    }
+    return 0;
+}
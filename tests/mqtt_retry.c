@@ -0,0 +1,50 @@
+/**
+ * Edge Gunshot Detector - MQTT resend test
+ * Connects the MQTT sink, lets the stand-in broker break the connection, then delivers one event so it
+ * has to be resent on a new connection. The broker's log shows how the resend went out. With "outage" there
+ * is no broker: events have to fail at once for the spool, with one connection attempt per backoff.
+ * Usage: mqtt_retry host:port qos [outage]
+ */
+
+#define main detector_main
+int detector_main(int argc, char *argv[]);
+#include "gunshot_detector_v1192_official.c"
+#undef main
+
+int main(int argc, char **argv) {
+    if (argc != 3 && (argc != 4 || strcmp(argv[3], "outage") != 0)) {
+        fprintf(stderr, "usage: %s host:port qos [outage]\n", argv[0]);
+        return 2;
+    }
+    snprintf(mqtt_broker, sizeof(mqtt_broker), "%s", argv[1]);
+    snprintf(mqtt_topic, sizeof(mqtt_topic), "test/gunshot");
+    mqtt_qos = atoi(argv[2]);
+    mqtt_heartbeat_s = 0;
+    struct detection_event e = { .id = 7, .confidence = 0.9f, .load_level = GUNSHOT_LOAD_FULL };
+    snprintf(e.label, sizeof(e.label), "%s", PRIMARY_LABEL);
+    uint32_t targets = SINK_TARGETS_ALL;
+    
+    if (argc == 4) {
+        int failed = 0;
+        for (uint32_t id = 1; id <= 5; id++) {
+            e.id = id;
+            failed += mqtt_sink_deliver(&e, &targets) == SINK_FAILED;
+        }
+        // Each failed connection attempt doubles the backoff
+        printf("%d of 5 events failed for the spool, backoff %u ms\n", failed, mqtt_backoff_ms);
+        return failed == 5 && mqtt_backoff_ms == 2 * MQTT_RECONNECT_MIN_MS ? 0 : 1;
+    }
+    
+    // Connect ahead of the event and give the broker time to reset the connection. Connecting directly
+    // rather than through mqtt_sink_poll() keeps the reset unread until the event goes out
+    if (!mqtt_refresh_config() || !mqtt_connect()) {
+        fprintf(stderr, "no connection to %s\n", mqtt_broker);
+        return 1;
+    }
+    usleep(300000);
+    
+    enum sink_result result = mqtt_sink_deliver(&e, &targets);
+    mqtt_cleanup();
+    printf("QoS %d event %s\n", mqtt_qos, result == SINK_DELIVERED ? "delivered" : "not delivered");
+    return result == SINK_DELIVERED ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Edge Gunshot Detector - MQTT stand-in broker
+Minimal MQTT 3.1.1 broker for the MQTT tests. It logs every packet to LOG and, like mosquitto, drops the
+connection on a malformed PUBLISH: DUP set on QoS 0 (MQTT-3.3.1-2), or DUP on a packet id it never
+received. MODE breaks the first connection: "reset" resets it after the client's status message,
+"noack" resets it instead of acknowledging the first event.
+Usage: mqtt_standin.py port log [reset|noack]
+"""
+
+import os
+import socket
+import struct
+import sys
+import threading
+import time
+
+lock = threading.Lock()
+connections = 0
+seen_ids = set()
+
+
+def read_exact(conn, n):
+    data = b""
+    while len(data) < n:
+        chunk = conn.recv(n - len(data))
+        if not chunk:
+            raise EOFError
+        data += chunk
+    return data
+
+
+def read_length(conn):
+    length, multiplier = 0, 1
+    while True:
+        digit = read_exact(conn, 1)[0]
+        length += (digit & 0x7F) * multiplier
+        multiplier *= 128
+        if not digit & 0x80:
+            return length
+
+
+def reset(conn):
+    """Close with RST, as a crashed broker or a broken path would"""
+    conn.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+    conn.close()
+
+
+def client(conn, number, log):
+    def note(text):
+        with lock:
+            log.write(f"conn{number} {text}\n")
+            log.flush()
+
+    try:
+        while True:
+            header = read_exact(conn, 1)[0]
+            body = read_exact(conn, read_length(conn))
+            kind = header >> 4
+            if kind == 1:  # CONNECT
+                note("CONNECT")
+                conn.sendall(b"\x20\x02\x00\x00")
+            elif kind == 3:  # PUBLISH
+                qos, dup = (header >> 1) & 3, (header >> 3) & 1
+                topic_len = int.from_bytes(body[:2], "big")
+                topic = body[2:2 + topic_len].decode()
+                packet_id = int.from_bytes(body[2 + topic_len:4 + topic_len], "big") if qos else 0
+                with lock:
+                    known = packet_id in seen_ids
+                    seen_ids.add(packet_id)
+                if dup and (qos == 0 or not known):
+                    note(f"REJECT {topic} qos={qos} dup={dup} id={packet_id}")
+                    conn.close()
+                    return
+                note(f"PUBLISH {topic} qos={qos} dup={dup} id={packet_id}")
+                if number == 1 and MODE == "reset" and topic.endswith("/status"):
+                    note("RESET")
+                    reset(conn)
+                    return
+                if number == 1 and MODE == "noack" and topic.endswith("/event"):
+                    note("RESET")
+                    reset(conn)
+                    return
+                if qos:
+                    conn.sendall(b"\x40\x02" + packet_id.to_bytes(2, "big"))
+            elif kind == 12:  # PINGREQ
+                conn.sendall(b"\xd0\x00")
+            elif kind == 14:  # DISCONNECT
+                note("DISCONNECT")
+                break
+    except (EOFError, OSError):
+        pass
+    conn.close()
+
+
+def exit_with_parent(parent):
+    """Stop when the test runner goes away, even if it could not clean up"""
+    while os.getppid() == parent:
+        time.sleep(0.5)
+    os._exit(0)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        sys.exit(__doc__.strip().splitlines()[-1])
+    MODE = sys.argv[3] if len(sys.argv) > 3 else ""
+    threading.Thread(target=exit_with_parent, args=(os.getppid(),), daemon=True).start()
+    log = open(sys.argv[2], "w")
+    server = socket.socket()
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("127.0.0.1", int(sys.argv[1])))
+    server.listen()
+    print("ready", flush=True)
+    while True:
+        conn, _ = server.accept()
+        connections += 1
+        threading.Thread(target=client, args=(conn, connections, log), daemon=True).start()
@@ -0,0 +1,119 @@
+#!/bin/sh
+# Runs the host tests against their network stand-ins. Ports are on 127.0.0.1 and can be moved with
+# TEST_PORT_BASE when something else is listening there
+set -u
+cd "$(dirname "$0")"
+
+PORT_BASE=${TEST_PORT_BASE:-18080}
+WORK=$(mktemp -d)
+PIDS=""
+FAILED=0
+
+cleanup() {
+    [ -n "$PIDS" ] && kill $PIDS 2>/dev/null
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+# Start a stand-in in the background and wait until it reports that it is listening
+standin() {
+    port=$1
+    shift
+    "$@" > "$WORK/ready.$port" &
+    pid=$!
+    PIDS="$PIDS $pid"
+    for _ in $(seq 50); do
+        kill -0 $pid 2>/dev/null || break
+        grep -q ready "$WORK/ready.$port" && return 0
+        sleep 0.1
+    done
+    echo "stand-in on port $port did not start"
+    return 1
+}
+
+result() {
+    if [ "$2" -eq 0 ]; then
+        echo "PASS $1"
+    else
+        echo "FAIL $1"
+        FAILED=1
+    fi
+}
+
+# Webhook keep-alive: a burst to two endpoints, one failing its first two requests, has to go out
+# over one connection per endpoint
+webhook_burst_test() {
+    a=$((PORT_BASE + 1))
+    b=$((PORT_BASE + 2))
+    standin $a ./webhook_standin.py $a 0 || return 1
+    standin $b ./webhook_standin.py $b 2 || return 1
+    ./webhook_burst "http://127.0.0.1:$a/hook,http://127.0.0.1:$b/hook" "${WEBHOOK_EVENTS:-200}" || return 1
+    for port in $a $b; do
+        stats=$(curl -s "http://127.0.0.1:$port/")
+        echo "endpoint $port: ${stats% *} requests over ${stats#* } connection(s)"
+        [ "${stats#* }" = 1 ] || return 1
+    done
+}
+
+# A refused endpoint has to give up after its retries instead of holding the sink
+webhook_refused_test() {
+    ! ./webhook_burst "http://127.0.0.1:$((PORT_BASE + 9))/hook retries=1" 1
+}
+
+# Webhook spool: one event to a good endpoint, one failing twice with 503 and one answering 404. Only the
+# 503 endpoint is retried from the spool; the good one gets exactly one POST and the 404 is not spooled
+webhook_spool_test() {
+    good=$((PORT_BASE + 6))
+    flaky=$((PORT_BASE + 7))
+    gone=$((PORT_BASE + 10))
+    standin $good ./webhook_standin.py $good 0 || return 1
+    standin $flaky ./webhook_standin.py $flaky 2 || return 1
+    standin $gone ./webhook_standin.py $gone 1000 0 404 || return 1
+    mkdir -p "$WORK/webhook" && (cd "$WORK/webhook" && "$OLDPWD/webhook_burst" \
+        "http://127.0.0.1:$good/hook,http://127.0.0.1:$flaky/hook retries=0,http://127.0.0.1:$gone/hook retries=0" \
+        1 spool 2> curl.log) || return 1
+    posts=""
+    for port in $good $flaky $gone; do
+        stats=$(curl -s "http://127.0.0.1:$port/")
+        posts="$posts ${stats% *}"
+    done
+    echo "POSTs to the good, 503 and 404 endpoints:$posts"
+    [ "$posts" = " 1 3 1" ]
+}
+
+# MQTT resend: after the broker breaks the connection, the event goes out again on a new one. A QoS 0
+# resend must not carry DUP; a QoS 1 resend carries DUP and the packet id the broker already has
+mqtt_retry_test() {
+    port=$((PORT_BASE + $3))
+    log="$WORK/mqtt.$port"
+    standin $port ./mqtt_standin.py $port "$log" $2 || return 1
+    ./mqtt_retry 127.0.0.1:$port $1 || return 1
+    grep -v CONNECT "$log"
+    ! grep -q REJECT "$log" && grep -q "conn2 PUBLISH test/gunshot/event qos=$1 dup=$4" "$log"
+}
+
+# Email spool: a spooled event coalesced into the digest stays in the spool file until the digest is sent
+spool_digest_test() {
+    port=$((PORT_BASE + 5))
+    standin $port ./smtp_standin.py $port || return 1
+    mkdir -p "$WORK/spool" && (cd "$WORK/spool" && "$OLDPWD/spool_digest" $port 2> curl.log)
+}
+
+webhook_burst_test
+result webhook_burst $?
+webhook_refused_test
+result webhook_refused $?
+webhook_spool_test
+result webhook_spool $?
+mqtt_retry_test 0 reset 3 0
+result mqtt_retry_qos0 $?
+mqtt_retry_test 1 noack 4 1
+result mqtt_retry_qos1 $?
+./mqtt_retry 127.0.0.1:$((PORT_BASE + 8)) 1 outage
+result mqtt_outage $?
+spool_digest_test
+result spool_digest $?
+./stream_replay ../gunshot_model_real_audio.tflite
+result stream_replay $?
+
+exit $FAILED
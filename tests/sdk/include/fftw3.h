@@ -0,0 +1,23 @@
+#ifndef STUB_FFTW3_H
+#define STUB_FFTW3_H
+#include <stddef.h>
+#ifdef _Complex_I
+typedef float _Complex fftwf_complex;
+#else
+typedef float fftwf_complex[2];
+#endif
+typedef struct fftwf_plan_s *fftwf_plan;
+#define FFTW_FORWARD (-1)
+#define FFTW_BACKWARD (+1)
+#define FFTW_MEASURE (0U)
+#define FFTW_ESTIMATE (1U << 6)
+fftwf_complex *fftwf_alloc_complex(size_t n);
+float *fftwf_alloc_real(size_t n);
+void *fftwf_malloc(size_t n);
+void fftwf_free(void *p);
+fftwf_plan fftwf_plan_dft_1d(int n, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags);
+fftwf_plan fftwf_plan_dft_r2c_1d(int n, float *in, fftwf_complex *out, unsigned flags);
+void fftwf_execute(const fftwf_plan p);
+void fftwf_execute_dft_r2c(const fftwf_plan p, float *in, fftwf_complex *out);
+void fftwf_destroy_plan(fftwf_plan p);
+#endif
@@ -0,0 +1,5 @@
+#ifndef STUB_GIO_H
+#define STUB_GIO_H
+#include <glib.h>
+typedef struct _GDBusConnection GDBusConnection;
+#endif
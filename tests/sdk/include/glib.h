@@ -0,0 +1,15 @@
+#ifndef STUB_GLIB_H
+#define STUB_GLIB_H
+#include <stddef.h>
+typedef char gchar;
+typedef int gint;
+typedef int gboolean;
+typedef void *gpointer;
+typedef struct _GVariant GVariant;
+void g_variant_get(GVariant *value, const gchar *format_string, ...);
+void g_free(gpointer mem);
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+#endif
@@ -0,0 +1,45 @@
+#ifndef STUB_LAROD_H
+#define STUB_LAROD_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#define LAROD_TENSOR_DIMS_LEN 12
+typedef struct larodConnection larodConnection;
+typedef struct larodDevice larodDevice;
+typedef struct larodModel larodModel;
+typedef struct larodJobRequest larodJobRequest;
+typedef struct larodTensor larodTensor;
+typedef struct larodMap larodMap;
+typedef enum { LAROD_ERROR_NONE = 0 } larodErrorCode;
+typedef struct { larodErrorCode code; const char *msg; } larodError;
+typedef enum { LAROD_ACCESS_INVALID, LAROD_ACCESS_PRIVATE, LAROD_ACCESS_PUBLIC } larodAccess;
+typedef enum {
+    LAROD_TENSOR_DATA_TYPE_INVALID, LAROD_TENSOR_DATA_TYPE_UNSPECIFIED, LAROD_TENSOR_DATA_TYPE_BOOL,
+    LAROD_TENSOR_DATA_TYPE_UINT8, LAROD_TENSOR_DATA_TYPE_INT8, LAROD_TENSOR_DATA_TYPE_UINT16,
+    LAROD_TENSOR_DATA_TYPE_INT16, LAROD_TENSOR_DATA_TYPE_UINT32, LAROD_TENSOR_DATA_TYPE_INT32,
+    LAROD_TENSOR_DATA_TYPE_UINT64, LAROD_TENSOR_DATA_TYPE_INT64, LAROD_TENSOR_DATA_TYPE_FLOAT16,
+    LAROD_TENSOR_DATA_TYPE_FLOAT32, LAROD_TENSOR_DATA_TYPE_FLOAT64
+} larodTensorDataType;
+typedef enum {
+    LAROD_TENSOR_LAYOUT_INVALID, LAROD_TENSOR_LAYOUT_UNSPECIFIED, LAROD_TENSOR_LAYOUT_NHWC,
+    LAROD_TENSOR_LAYOUT_NCHW, LAROD_TENSOR_LAYOUT_420SP
+} larodTensorLayout;
+typedef struct { size_t dims[LAROD_TENSOR_DIMS_LEN]; size_t len; } larodTensorDims;
+bool larodConnect(larodConnection **conn, larodError **error);
+bool larodDisconnect(larodConnection **conn, larodError **error);
+const larodDevice *larodGetDevice(const larodConnection *conn, const char *name, uint32_t instance, larodError **error);
+larodModel *larodLoadModel(larodConnection *conn, const int fd, const larodDevice *dev, const larodAccess access, const char *name, const larodMap *params, larodError **error);
+void larodDestroyModel(larodModel **model);
+larodTensor **larodCreateModelInputs(const larodModel *model, size_t *numTensors, larodError **error);
+larodTensor **larodCreateModelOutputs(const larodModel *model, size_t *numTensors, larodError **error);
+bool larodDestroyTensors(larodConnection *conn, larodTensor ***tensors, size_t numTensors, larodError **error);
+bool larodSetTensorFd(larodTensor *tensor, const int fd, larodError **error);
+const larodTensorDims *larodGetTensorDims(const larodTensor *tensor, larodError **error);
+larodTensorDataType larodGetTensorDataType(const larodTensor *tensor, larodError **error);
+larodTensorLayout larodGetTensorLayout(const larodTensor *tensor, larodError **error);
+bool larodGetTensorByteSize(const larodTensor *tensor, size_t *byteSize, larodError **error);
+larodJobRequest *larodCreateJobRequest(const larodModel *model, larodTensor **inTensors, size_t numInputs, larodTensor **outTensors, size_t numOutputs, larodMap *params, larodError **error);
+void larodDestroyJobRequest(larodJobRequest **jobReq);
+bool larodRunJob(larodConnection *conn, const larodJobRequest *jobReq, larodError **error);
+void larodClearError(larodError **error);
+#endif
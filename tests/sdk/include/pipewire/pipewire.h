@@ -0,0 +1,72 @@
+#ifndef STUB_PIPEWIRE_H
+#define STUB_PIPEWIRE_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <spa/param/audio/format-utils.h>
+struct pw_main_loop; struct pw_loop; struct pw_context; struct pw_core; struct pw_registry; struct pw_stream; struct pw_properties; struct pw_proxy;
+#define PW_TYPE_INTERFACE_Node "PipeWire:Interface:Node"
+#define PW_KEY_MEDIA_CLASS "media.class"
+#define PW_KEY_NODE_NAME "node.name"
+#define PW_KEY_MEDIA_TYPE "media.type"
+#define PW_KEY_MEDIA_CATEGORY "media.category"
+#define PW_KEY_MEDIA_ROLE "media.role"
+#define PW_KEY_TARGET_OBJECT "target.object"
+#define PW_KEY_NODE_LATENCY "node.latency"
+#define PW_VERSION_REGISTRY 3
+#define PW_VERSION_REGISTRY_EVENTS 0
+#define PW_VERSION_STREAM_EVENTS 2
+#define PW_ID_ANY ((uint32_t)0xffffffff)
+#define PW_DIRECTION_INPUT SPA_DIRECTION_INPUT
+enum pw_stream_flags { PW_STREAM_FLAG_NONE = 0, PW_STREAM_FLAG_AUTOCONNECT = (1 << 0), PW_STREAM_FLAG_INACTIVE = (1 << 1), PW_STREAM_FLAG_MAP_BUFFERS = (1 << 2), PW_STREAM_FLAG_DRIVER = (1 << 3), PW_STREAM_FLAG_RT_PROCESS = (1 << 4), PW_STREAM_FLAG_NO_CONVERT = (1 << 5), PW_STREAM_FLAG_EXCLUSIVE = (1 << 6), PW_STREAM_FLAG_DONT_RECONNECT = (1 << 7) };
+enum pw_stream_state { PW_STREAM_STATE_ERROR = -1, PW_STREAM_STATE_UNCONNECTED = 0, PW_STREAM_STATE_CONNECTING = 1, PW_STREAM_STATE_PAUSED = 2, PW_STREAM_STATE_STREAMING = 3 };
+struct pw_buffer { struct spa_buffer *buffer; void *user_data; uint64_t size; uint64_t requested; };
+struct pw_stream_events {
+    uint32_t version;
+    void (*destroy)(void *data);
+    void (*state_changed)(void *data, enum pw_stream_state old, enum pw_stream_state state, const char *error);
+    void (*control_info)(void *data, uint32_t id, const void *control);
+    void (*io_changed)(void *data, uint32_t id, void *area, uint32_t size);
+    void (*param_changed)(void *data, uint32_t id, const struct spa_pod *param);
+    void (*add_buffer)(void *data, struct pw_buffer *buffer);
+    void (*remove_buffer)(void *data, struct pw_buffer *buffer);
+    void (*process)(void *data);
+    void (*drained)(void *data);
+    void (*command)(void *data, const void *command);
+    void (*trigger_done)(void *data);
+};
+struct pw_registry_events {
+    uint32_t version;
+    void (*global)(void *data, uint32_t id, uint32_t permissions, const char *type, uint32_t version, const struct spa_dict *props);
+    void (*global_remove)(void *data, uint32_t id);
+};
+void pw_init(int *argc, char **argv[]);
+void pw_deinit(void);
+struct pw_main_loop *pw_main_loop_new(const struct spa_dict *props);
+struct pw_loop *pw_main_loop_get_loop(struct pw_main_loop *loop);
+int pw_main_loop_run(struct pw_main_loop *loop);
+int pw_main_loop_quit(struct pw_main_loop *loop);
+void pw_main_loop_destroy(struct pw_main_loop *loop);
+struct pw_context *pw_context_new(struct pw_loop *main_loop, struct pw_properties *props, size_t user_data_size);
+void pw_context_destroy(struct pw_context *context);
+struct pw_core *pw_context_connect(struct pw_context *context, struct pw_properties *properties, size_t user_data_size);
+int pw_core_disconnect(struct pw_core *core);
+struct pw_registry *pw_core_get_registry(struct pw_core *core, uint32_t version, size_t user_data_size);
+int pw_registry_add_listener(struct pw_registry *registry, struct spa_hook *listener, const struct pw_registry_events *events, void *data);
+void pw_proxy_destroy(struct pw_proxy *proxy);
+struct pw_properties *pw_properties_new(const char *key, ...);
+struct pw_stream *pw_stream_new(struct pw_core *core, const char *name, struct pw_properties *props);
+void pw_stream_add_listener(struct pw_stream *stream, struct spa_hook *listener, const struct pw_stream_events *events, void *data);
+int pw_stream_connect(struct pw_stream *stream, enum spa_direction direction, uint32_t target_id, enum pw_stream_flags flags, const struct spa_pod **params, uint32_t n_params);
+int pw_stream_disconnect(struct pw_stream *stream);
+void pw_stream_destroy(struct pw_stream *stream);
+struct pw_buffer *pw_stream_dequeue_buffer(struct pw_stream *stream);
+int pw_stream_queue_buffer(struct pw_stream *stream, struct pw_buffer *buffer);
+struct spa_source *pw_loop_add_io(struct pw_loop *loop, int fd, uint32_t mask, bool close, spa_source_io_func_t func, void *data);
+int pw_loop_update_io(struct pw_loop *loop, struct spa_source *source, uint32_t mask);
+struct spa_source *pw_loop_add_timer(struct pw_loop *loop, spa_source_timer_func_t func, void *data);
+int pw_loop_update_timer(struct pw_loop *loop, struct spa_source *source, struct timespec *value, struct timespec *interval, bool absolute);
+struct spa_source *pw_loop_add_event(struct pw_loop *loop, spa_source_event_func_t func, void *data);
+int pw_loop_signal_event(struct pw_loop *loop, struct spa_source *source);
+void pw_loop_destroy_source(struct pw_loop *loop, struct spa_source *source);
+#endif
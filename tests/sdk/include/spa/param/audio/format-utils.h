@@ -0,0 +1,70 @@
+#ifndef STUB_SPA_FORMAT_UTILS_H
+#define STUB_SPA_FORMAT_UTILS_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#define SPA_AUDIO_MAX_CHANNELS 64u
+#define SPA_ID_INVALID ((uint32_t)0xffffffff)
+enum spa_direction { SPA_DIRECTION_INPUT = 0, SPA_DIRECTION_OUTPUT = 1 };
+enum spa_audio_format {
+    SPA_AUDIO_FORMAT_UNKNOWN, SPA_AUDIO_FORMAT_ENCODED,
+    SPA_AUDIO_FORMAT_S8 = 0x101, SPA_AUDIO_FORMAT_U8, SPA_AUDIO_FORMAT_S16_LE, SPA_AUDIO_FORMAT_S16_BE,
+    SPA_AUDIO_FORMAT_U16_LE, SPA_AUDIO_FORMAT_U16_BE, SPA_AUDIO_FORMAT_S24_32_LE, SPA_AUDIO_FORMAT_S24_32_BE,
+    SPA_AUDIO_FORMAT_U24_32_LE, SPA_AUDIO_FORMAT_U24_32_BE, SPA_AUDIO_FORMAT_S32_LE, SPA_AUDIO_FORMAT_S32_BE,
+    SPA_AUDIO_FORMAT_U32_LE, SPA_AUDIO_FORMAT_U32_BE, SPA_AUDIO_FORMAT_S24_LE, SPA_AUDIO_FORMAT_S24_BE,
+    SPA_AUDIO_FORMAT_U24_LE, SPA_AUDIO_FORMAT_U24_BE, SPA_AUDIO_FORMAT_S20_LE, SPA_AUDIO_FORMAT_S20_BE,
+    SPA_AUDIO_FORMAT_U20_LE, SPA_AUDIO_FORMAT_U20_BE, SPA_AUDIO_FORMAT_S18_LE, SPA_AUDIO_FORMAT_S18_BE,
+    SPA_AUDIO_FORMAT_U18_LE, SPA_AUDIO_FORMAT_U18_BE, SPA_AUDIO_FORMAT_F32_LE, SPA_AUDIO_FORMAT_F32_BE,
+    SPA_AUDIO_FORMAT_F64_LE, SPA_AUDIO_FORMAT_F64_BE,
+    SPA_AUDIO_FORMAT_U8P = 0x201, SPA_AUDIO_FORMAT_S16P, SPA_AUDIO_FORMAT_S24_32P, SPA_AUDIO_FORMAT_S32P,
+    SPA_AUDIO_FORMAT_S24P, SPA_AUDIO_FORMAT_F32P, SPA_AUDIO_FORMAT_F64P, SPA_AUDIO_FORMAT_S8P,
+    SPA_AUDIO_FORMAT_S16 = SPA_AUDIO_FORMAT_S16_LE,
+    SPA_AUDIO_FORMAT_S24_32 = SPA_AUDIO_FORMAT_S24_32_LE,
+    SPA_AUDIO_FORMAT_S32 = SPA_AUDIO_FORMAT_S32_LE,
+    SPA_AUDIO_FORMAT_S24 = SPA_AUDIO_FORMAT_S24_LE,
+    SPA_AUDIO_FORMAT_F32 = SPA_AUDIO_FORMAT_F32_LE,
+    SPA_AUDIO_FORMAT_F64 = SPA_AUDIO_FORMAT_F64_LE,
+};
+#define SPA_AUDIO_FLAG_NONE 0
+#define SPA_AUDIO_FLAG_UNPOSITIONED (1 << 0)
+enum spa_audio_channel { SPA_AUDIO_CHANNEL_UNKNOWN, SPA_AUDIO_CHANNEL_NA, SPA_AUDIO_CHANNEL_MONO, SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR };
+struct spa_audio_info_raw {
+    enum spa_audio_format format;
+    uint32_t flags;
+    uint32_t rate;
+    uint32_t channels;
+    uint32_t position[SPA_AUDIO_MAX_CHANNELS];
+};
+#define SPA_AUDIO_INFO_RAW_INIT(...) ((struct spa_audio_info_raw) { __VA_ARGS__ })
+enum { SPA_MEDIA_TYPE_unknown, SPA_MEDIA_TYPE_audio, SPA_MEDIA_TYPE_video };
+enum { SPA_MEDIA_SUBTYPE_unknown, SPA_MEDIA_SUBTYPE_raw };
+enum { SPA_PARAM_Invalid, SPA_PARAM_PropInfo, SPA_PARAM_Props, SPA_PARAM_EnumFormat, SPA_PARAM_Format, SPA_PARAM_Buffers };
+struct spa_audio_info {
+    uint32_t media_type;
+    uint32_t media_subtype;
+    union { struct spa_audio_info_raw raw; } info;
+};
+struct spa_pod { uint32_t size; uint32_t type; };
+struct spa_pod_builder { void *data; uint32_t size; uint32_t offset; };
+#define SPA_POD_BUILDER_INIT(buffer, size) ((struct spa_pod_builder){ (buffer), (size), 0 })
+int spa_format_parse(const struct spa_pod *format, uint32_t *media_type, uint32_t *media_subtype);
+int spa_format_audio_raw_parse(const struct spa_pod *format, struct spa_audio_info_raw *info);
+struct spa_pod *spa_format_audio_raw_build(struct spa_pod_builder *builder, uint32_t id, const struct spa_audio_info_raw *info);
+struct spa_dict_item { const char *key; const char *value; };
+struct spa_dict { uint32_t flags; uint32_t n_items; const struct spa_dict_item *items; };
+const char *spa_dict_lookup(const struct spa_dict *dict, const char *key);
+struct spa_list { struct spa_list *next, *prev; };
+struct spa_hook { struct spa_list link; const void *cb; void *priv; };
+static inline void spa_hook_remove(struct spa_hook *hook) { (void)hook; }
+struct spa_chunk { uint32_t offset; uint32_t size; int32_t stride; int32_t flags; };
+struct spa_data { uint32_t type; uint32_t flags; int64_t fd; uint32_t mapoffset; uint32_t maxsize; void *data; struct spa_chunk *chunk; };
+struct spa_buffer { uint32_t n_metas; uint32_t n_datas; void *metas; struct spa_data *datas; };
+struct spa_source;
+#define SPA_IO_IN (1 << 0)
+#define SPA_IO_OUT (1 << 2)
+#define SPA_IO_ERR (1 << 3)
+#define SPA_IO_HUP (1 << 4)
+typedef void (*spa_source_io_func_t)(void *data, int fd, uint32_t mask);
+typedef void (*spa_source_timer_func_t)(void *data, uint64_t expirations);
+typedef void (*spa_source_event_func_t)(void *data, uint64_t count);
+#endif
@@ -0,0 +1,5 @@
+#ifndef STUB_SPA_RESULT_H
+#define STUB_SPA_RESULT_H
+#include <string.h>
+#define spa_strerror(err) strerror(-(err))
+#endif
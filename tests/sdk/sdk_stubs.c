@@ -0,0 +1,183 @@
+/*
+ * Host stand-ins for the camera SDK (glib, FFTW, larod, PipeWire) so the detector links and runs on a
+ * build machine. The larod model is a fake classifier whose score follows the fraction of loud input
+ * cells; with STUB_STREAMING it is a streaming model instead (one mel frame in, a state tensor carried
+ * between steps) that fires only after several loud frames in a row. PipeWire only provides a poll-based
+ * main loop. Environment knobs: STUB_NODE, STUB_STREAM_OK, STUB_NO_PW, STUB_SLOW_US, STUB_STREAMING.
+ */
+#define _GNU_SOURCE
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <glib.h>
+#include <fftw3.h>
+#include <larod.h>
+#include <pipewire/pipewire.h>
+
+void g_variant_get(GVariant *v, const gchar *f, ...) { (void)v; (void)f; }
+void g_free(gpointer p) { free(p); }
+
+/* ---- fftw ---- */
+struct fftwf_plan_s { int n; fftwf_complex *in, *out; float *rin; int r2c; };
+fftwf_complex *fftwf_alloc_complex(size_t n) { return aligned_alloc(64, ((n * sizeof(fftwf_complex)) + 63) / 64 * 64); }
+float *fftwf_alloc_real(size_t n) { return aligned_alloc(64, ((n * sizeof(float)) + 63) / 64 * 64); }
+void *fftwf_malloc(size_t n) { return aligned_alloc(64, (n + 63) / 64 * 64); }
+void fftwf_free(void *p) { free(p); }
+fftwf_plan fftwf_plan_dft_1d(int n, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags) {
+    fftwf_plan p = calloc(1, sizeof(*p)); p->n = n; p->in = in; p->out = out; return p; }
+fftwf_plan fftwf_plan_dft_r2c_1d(int n, float *in, fftwf_complex *out, unsigned flags) {
+    fftwf_plan p = calloc(1, sizeof(*p)); p->n = n; p->rin = in; p->out = out; p->r2c = 1; return p; }
+static void fft_core(int n, const double complex *x, double complex *y) {
+    for (int i = 0; i < n; i++) { int j = 0; for (int b = 1, k = i; b < n; b <<= 1, k >>= 1) j = (j << 1) | (k & 1); y[j] = x[i]; }
+    for (int len = 2; len <= n; len <<= 1) {
+        double complex w = cexp(-2.0 * M_PI * I / len);
+        for (int i = 0; i < n; i += len) { double complex wk = 1; for (int k = 0; k < len / 2; k++) {
+            double complex a = y[i + k], b = y[i + k + len / 2] * wk; y[i + k] = a + b; y[i + k + len / 2] = a - b; wk *= w; } }
+    }
+}
+static void run_plan(fftwf_plan p, float *rin, fftwf_complex *in, fftwf_complex *out) {
+    int n = p->n; double complex *x = malloc(sizeof(*x) * n), *y = malloc(sizeof(*y) * n);
+    for (int i = 0; i < n; i++) x[i] = rin ? rin[i] : in[i];
+    fft_core(n, x, y);
+    int m = p->r2c ? n / 2 + 1 : n;
+    for (int i = 0; i < m; i++) out[i] = (float complex)y[i];
+    free(x); free(y);
+}
+void fftwf_execute(const fftwf_plan p) { run_plan(p, p->rin, p->in, p->out); }
+void fftwf_execute_dft_r2c(const fftwf_plan p, float *in, fftwf_complex *out) { run_plan(p, in, NULL, out); }
+void fftwf_destroy_plan(fftwf_plan p) { free(p); }
+
+/* ---- larod ---- */
+struct larodConnection { int x; };
+struct larodDevice { int x; };
+struct larodModel { int nin, nout; larodTensorDims in[4], out[4]; };
+struct larodTensor { int fd; larodTensorDims dims; size_t bytes; };
+struct larodJobRequest { larodTensor **in, **out; size_t nin, nout; };
+static larodConnection the_conn; static larodDevice the_dev;
+static larodError stub_err = { 1, "stub error" };
+bool larodConnect(larodConnection **c, larodError **e) { *c = &the_conn; return true; }
+bool larodDisconnect(larodConnection **c, larodError **e) { *c = NULL; return true; }
+const larodDevice *larodGetDevice(const larodConnection *c, const char *n, uint32_t i, larodError **e) { return &the_dev; }
+larodModel *larodLoadModel(larodConnection *c, const int fd, const larodDevice *d, const larodAccess a, const char *n, const larodMap *p, larodError **e) {
+    if (fd < 0) { *e = &stub_err; return NULL; }
+    larodModel *m = calloc(1, sizeof(*m)); m->nin = 1; m->nout = 1;
+    m->in[0] = (larodTensorDims){ { 1, 1, 28, 160 }, 4 }; m->out[0] = (larodTensorDims){ { 1, 2 }, 2 };
+    if (getenv("STUB_STREAMING")) { m->nin = 2; m->nout = 2; m->in[0] = (larodTensorDims){ { 1, 28, 1, 1 }, 4 };
+        m->in[1] = (larodTensorDims){ { 1, 64 }, 2 }; m->out[1] = m->in[1]; }
+    return m; }
+void larodDestroyModel(larodModel **m) { free(*m); *m = NULL; }
+static larodTensor **mk(const larodTensorDims *d, int n, size_t *num) {
+    larodTensor **t = calloc(n, sizeof(*t)); for (int i = 0; i < n; i++) { t[i] = calloc(1, sizeof(**t)); t[i]->fd = -1; t[i]->dims = d[i];
+        t[i]->bytes = 1; for (size_t k = 0; k < d[i].len; k++) t[i]->bytes *= d[i].dims[k]; } *num = n; return t; }
+larodTensor **larodCreateModelInputs(const larodModel *m, size_t *n, larodError **e) { return mk(m->in, m->nin, n); }
+larodTensor **larodCreateModelOutputs(const larodModel *m, size_t *n, larodError **e) { return mk(m->out, m->nout, n); }
+bool larodDestroyTensors(larodConnection *c, larodTensor ***t, size_t n, larodError **e) { for (size_t i = 0; i < n; i++) free((*t)[i]); free(*t); *t = NULL; return true; }
+bool larodSetTensorFd(larodTensor *t, const int fd, larodError **e) { t->fd = fd; return true; }
+const larodTensorDims *larodGetTensorDims(const larodTensor *t, larodError **e) { return &t->dims; }
+larodTensorDataType larodGetTensorDataType(const larodTensor *t, larodError **e) { return LAROD_TENSOR_DATA_TYPE_INT8; }
+larodTensorLayout larodGetTensorLayout(const larodTensor *t, larodError **e) { return LAROD_TENSOR_LAYOUT_NHWC; }
+bool larodGetTensorByteSize(const larodTensor *t, size_t *b, larodError **e) { *b = t->bytes; return true; }
+larodJobRequest *larodCreateJobRequest(const larodModel *m, larodTensor **in, size_t ni, larodTensor **out, size_t no, larodMap *p, larodError **e) {
+    larodJobRequest *r = calloc(1, sizeof(*r)); r->in = in; r->out = out; r->nin = ni; r->nout = no; return r; }
+void larodDestroyJobRequest(larodJobRequest **r) { free(*r); *r = NULL; }
+/* Fake classifier: score rises with the fraction of loud (high int8) input cells. */
+bool larodRunJob(larodConnection *c, const larodJobRequest *r, larodError **e) {
+    larodTensor *ti = r->in[0], *to = r->out[0];
+    int8_t *in = mmap(NULL, ti->bytes, PROT_READ, MAP_SHARED, ti->fd, 0);
+    int8_t *out = mmap(NULL, to->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, to->fd, 0);
+    if (in == MAP_FAILED || out == MAP_FAILED) { *e = &stub_err; return false; }
+    size_t loud = 0; for (size_t i = 0; i < ti->bytes; i++) if (in[i] > 60) loud++;
+    double frac = (double)loud / ti->bytes;
+    out[0] = 60; out[1] = (int8_t)(frac * 4000.0 > 127 ? 127 : frac * 4000.0 - 0);
+    if (r->nin > 1) { /* Streaming: state[0] leaks and integrates loud frames; one frame alone stays below 40 */
+        larodTensor *si = r->in[1], *so = r->out[1];
+        int8_t *st = mmap(NULL, si->bytes, PROT_READ, MAP_SHARED, si->fd, 0);
+        int8_t *sn = mmap(NULL, so->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, so->fd, 0);
+        long sum = 0; for (size_t i = 0; i < ti->bytes; i++) sum += in[i];
+        int v = st[0] * 7 / 8 + ((double)sum / ti->bytes > 95 ? 16 : 0); if (v > 127) v = 127;
+        memcpy(sn, st, so->bytes); sn[0] = (int8_t)v;
+        out[1] = (int8_t)(v > 40 ? 127 : 0);
+        munmap(st, si->bytes); munmap(sn, so->bytes); }
+    if (getenv("STUB_SLOW_US")) usleep(atoi(getenv("STUB_SLOW_US")));
+    munmap(in, ti->bytes); munmap(out, to->bytes); return true; }
+void larodClearError(larodError **e) { *e = NULL; }
+
+/* ---- spa/pipewire ---- */
+int spa_format_parse(const struct spa_pod *f, uint32_t *t, uint32_t *s) { *t = SPA_MEDIA_TYPE_audio; *s = SPA_MEDIA_SUBTYPE_raw; return 0; }
+int spa_format_audio_raw_parse(const struct spa_pod *f, struct spa_audio_info_raw *i) { memcpy(i, (const char *)f + sizeof(struct spa_pod), sizeof(*i)); return 0; }
+struct spa_pod *spa_format_audio_raw_build(struct spa_pod_builder *b, uint32_t id, const struct spa_audio_info_raw *i) {
+    size_t need = sizeof(struct spa_pod) + sizeof(*i); if (b->offset + need > b->size) return NULL;
+    struct spa_pod *p = (struct spa_pod *)((char *)b->data + b->offset); p->size = sizeof(*i); p->type = id;
+    memcpy((char *)p + sizeof(*p), i, sizeof(*i)); b->offset += (need + 7) & ~7u; return p; }
+const char *spa_dict_lookup(const struct spa_dict *d, const char *k) {
+    for (uint32_t i = 0; i < d->n_items; i++) if (!strcmp(d->items[i].key, k)) return d->items[i].value; return NULL; }
+
+struct spa_source { int fd; int kind; bool close; void *func; void *data; bool dead; uint32_t mask; };
+#define MAXSRC 64
+struct pw_loop { struct spa_source *src[MAXSRC]; int n; };
+struct pw_main_loop { struct pw_loop loop; volatile int quit; };
+static int dummy_obj;
+void pw_init(int *a, char **v[]) {}
+void pw_deinit(void) {}
+struct pw_main_loop *pw_main_loop_new(const struct spa_dict *p) { return calloc(1, sizeof(struct pw_main_loop)); }
+struct pw_loop *pw_main_loop_get_loop(struct pw_main_loop *l) { return &l->loop; }
+static struct spa_source *add(struct pw_loop *l, int fd, int kind, bool cl, void *f, void *d) {
+    struct spa_source *s = calloc(1, sizeof(*s)); s->fd = fd; s->kind = kind; s->close = cl; s->func = f; s->data = d; s->mask = SPA_IO_IN;
+    for (int i = 0; i < l->n; i++) if (l->src[i]->dead) { free(l->src[i]); l->src[i] = s; return s; }
+    l->src[l->n++] = s; return s; }
+int pw_main_loop_run(struct pw_main_loop *ml) {
+    struct pw_loop *l = &ml->loop;
+    while (!ml->quit) {
+        struct pollfd pf[MAXSRC]; int n = l->n;
+        for (int i = 0; i < n; i++) { pf[i].fd = l->src[i]->dead ? -1 : l->src[i]->fd; pf[i].events = ((l->src[i]->mask & SPA_IO_IN) ? POLLIN : 0) | ((l->src[i]->mask & SPA_IO_OUT) ? POLLOUT : 0); pf[i].revents = 0; }
+        int r = poll(pf, n, 200); if (r < 0 && errno != EINTR) return -1; if (r <= 0) continue;
+        for (int i = 0; i < n && !ml->quit; i++) { struct spa_source *s = l->src[i]; if (s->dead || !pf[i].revents) continue;
+            uint64_t v = 0;
+            if (s->kind == 0) ((spa_source_io_func_t)s->func)(s->data, s->fd, ((pf[i].revents & POLLIN) ? SPA_IO_IN : 0) | ((pf[i].revents & POLLOUT) ? SPA_IO_OUT : 0) | ((pf[i].revents & POLLHUP) ? SPA_IO_HUP : 0) | ((pf[i].revents & POLLERR) ? SPA_IO_ERR : 0));
+            else { if (read(s->fd, &v, 8) != 8) continue;
+                if (s->kind == 1) ((spa_source_timer_func_t)s->func)(s->data, v); else ((spa_source_event_func_t)s->func)(s->data, v); } }
+    }
+    return 0; }
+int pw_main_loop_quit(struct pw_main_loop *l) { l->quit = 1; return 0; }
+void pw_main_loop_destroy(struct pw_main_loop *l) { free(l); }
+struct pw_context *pw_context_new(struct pw_loop *l, struct pw_properties *p, size_t s) { return (struct pw_context *)&dummy_obj; }
+void pw_context_destroy(struct pw_context *c) {}
+struct pw_core *pw_context_connect(struct pw_context *c, struct pw_properties *p, size_t s) { return getenv("STUB_NO_PW") ? NULL : (struct pw_core *)&dummy_obj; }
+int pw_core_disconnect(struct pw_core *c) { return 0; }
+struct pw_registry *pw_core_get_registry(struct pw_core *c, uint32_t v, size_t s) { return (struct pw_registry *)&dummy_obj; }
+int pw_registry_add_listener(struct pw_registry *r, struct spa_hook *h, const struct pw_registry_events *e, void *d) {
+    const char *node = getenv("STUB_NODE");
+    if (node) { struct spa_dict_item it[2] = { { "media.class", "Audio/Source" }, { "node.name", node } }; struct spa_dict dict = { 0, 2, it };
+        e->global(d, 42, 0, "PipeWire:Interface:Node", 3, &dict); }
+    return 0; }
+void pw_proxy_destroy(struct pw_proxy *p) {}
+struct pw_properties *pw_properties_new(const char *k, ...) { return (struct pw_properties *)&dummy_obj; }
+struct pw_stream { const struct pw_stream_events *e; void *d; };
+struct pw_stream *pw_stream_new(struct pw_core *c, const char *n, struct pw_properties *p) { return calloc(1, sizeof(struct pw_stream)); }
+void pw_stream_add_listener(struct pw_stream *s, struct spa_hook *h, const struct pw_stream_events *e, void *d) { s->e = e; s->d = d; }
+int pw_stream_connect(struct pw_stream *s, enum spa_direction d, uint32_t t, enum pw_stream_flags f, const struct spa_pod **p, uint32_t n) {
+    fprintf(stderr, "stub: stream connect with %u formats, first rate %u ch %u\n", n, ((const struct spa_audio_info_raw *)((const char *)p[0] + sizeof(struct spa_pod)))->rate, ((const struct spa_audio_info_raw *)((const char *)p[0] + sizeof(struct spa_pod)))->channels);
+    if (getenv("STUB_STREAM_OK")) { s->e->param_changed(s->d, SPA_PARAM_Format, p[0]); s->e->state_changed(s->d, PW_STREAM_STATE_PAUSED, PW_STREAM_STATE_STREAMING, NULL); }
+    return 0; }
+int pw_stream_disconnect(struct pw_stream *s) { return 0; }
+void pw_stream_destroy(struct pw_stream *s) { free(s); }
+struct pw_buffer *pw_stream_dequeue_buffer(struct pw_stream *s) { return NULL; }
+int pw_stream_queue_buffer(struct pw_stream *s, struct pw_buffer *b) { return 0; }
+struct spa_source *pw_loop_add_io(struct pw_loop *l, int fd, uint32_t m, bool c, spa_source_io_func_t f, void *d) { struct spa_source *s = add(l, fd, 0, c, (void *)f, d); s->mask = m; return s; }
+int pw_loop_update_io(struct pw_loop *l, struct spa_source *s, uint32_t m) { s->mask = m; return 0; }
+struct spa_source *pw_loop_add_timer(struct pw_loop *l, spa_source_timer_func_t f, void *d) { return add(l, timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK), 1, true, (void *)f, d); }
+int pw_loop_update_timer(struct pw_loop *l, struct spa_source *s, struct timespec *v, struct timespec *i, bool abs) {
+    struct itimerspec its = { 0 }; if (v) its.it_value = *v; if (i) its.it_interval = *i;
+    return timerfd_settime(s->fd, abs ? TFD_TIMER_ABSTIME : 0, &its, NULL); }
+struct spa_source *pw_loop_add_event(struct pw_loop *l, spa_source_event_func_t f, void *d) { return add(l, eventfd(0, EFD_NONBLOCK), 2, true, (void *)f, d); }
+int pw_loop_signal_event(struct pw_loop *l, struct spa_source *s) { uint64_t one = 1; return write(s->fd, &one, 8) == 8 ? 0 : -errno; }
+void pw_loop_destroy_source(struct pw_loop *l, struct spa_source *s) { s->dead = true; if (s->close) close(s->fd); }
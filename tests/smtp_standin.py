@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+Edge Gunshot Detector - SMTP stand-in server
+Accepts any login and message without TLS and discards the messages, for the email tests.
+Usage: smtp_standin.py port
+"""
+
+import os
+import socketserver
+import sys
+import threading
+import time
+
+
+class Handler(socketserver.StreamRequestHandler):
+    def reply(self, text):
+        self.wfile.write((text + "\r\n").encode())
+
+    def handle(self):
+        self.reply("220 stand-in")
+        in_data = False
+        for raw in self.rfile:
+            line = raw.decode().rstrip("\r\n")
+            if in_data:
+                if line == ".":
+                    in_data = False
+                    self.reply("250 OK")
+                continue
+            command = line[:4].upper()
+            if command == "EHLO":
+                self.reply("250-stand-in")
+                self.reply("250 AUTH PLAIN LOGIN")
+            elif command == "AUTH":
+                if len(line.split()) == 2:
+                    self.reply("334 ")
+                    self.rfile.readline()
+                self.reply("235 OK")
+            elif command == "DATA":
+                in_data = True
+                self.reply("354 go ahead")
+            elif command == "QUIT":
+                self.reply("221 bye")
+                return
+            else:
+                self.reply("250 OK")
+
+
+class Server(socketserver.ThreadingMixIn, socketserver.TCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+def exit_with_parent(parent):
+    """Stop when the test runner goes away, even if it could not clean up"""
+    while os.getppid() == parent:
+        time.sleep(0.5)
+    os._exit(0)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit(__doc__.strip().splitlines()[-1])
+    threading.Thread(target=exit_with_parent, args=(os.getppid(),), daemon=True).start()
+    server = Server(("127.0.0.1", int(sys.argv[1])), Handler)
+    print("ready", flush=True)
+    server.serve_forever()
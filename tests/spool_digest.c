@@ -0,0 +1,79 @@
+/**
+ * Edge Gunshot Detector - spooled events in the email digest
+ * A spooled email event that the retry coalesces into the digest has to stay in the spool file until the
+ * digest is sent, so a crash in between still retries it. Runs in the current directory as the spool dir.
+ * Usage: spool_digest smtp_port
+ */
+
+#define SPOOL_DIR "."
+#define main detector_main
+int detector_main(int argc, char *argv[]);
+#include "gunshot_detector_v1192_official.c"
+#undef main
+
+/**
+ * Pending entries a restarted detector would find in the email spool
+ */
+static size_t pending_after_restart(void) {
+    struct event_sink probe = { .name = "email", .spool_fd = -1 };
+    spool_open(&probe);
+    if (probe.spool_fd >= 0) {
+        close(probe.spool_fd);
+    }
+    return probe.spool_count;
+}
+
+static int check(bool ok, const char *what) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s smtp_port\n", argv[0]);
+        return 2;
+    }
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    unlink("./alert_spool_email.bin");
+    email_enabled = true;
+    smtp_port = atoi(argv[1]);
+    snprintf(smtp_server, sizeof(smtp_server), "127.0.0.1");
+    snprintf(smtp_username, sizeof(smtp_username), "camera@example.com");
+    snprintf(recipient_email, sizeof(recipient_email), "security@example.com");
+    
+    struct event_sink *sink = &email_sink;
+    sink->spool_fd = -1;
+    spool_open(sink);
+    int failures = check(sink->spool_fd >= 0, "spool opened");
+    
+    // An alert just went out, and the next event's delivery failed, so it was spooled
+    last_email_us = monotonic_us();
+    struct detection_event e = {
+        .kind = DETECTION_EVENT_OPENED, .id = 42, .time_ms = unix_ms(), .confidence = 0.9f,
+        .routes = EVENT_ROUTE_ALL,
+    };
+    snprintf(e.label, sizeof(e.label), "%s", PRIMARY_LABEL);
+    const struct spool_entry *entry = spool_add(sink, ++sink->spool_sequence, &e, SINK_TARGETS_ALL);
+    spool_write(sink, SPOOL_PENDING, entry->sequence, entry);
+    
+    // The retry finds the sink within its quiet period, so the event joins the digest
+    spool_retry(sink);
+    failures += check(email_digest.count == 1, "retried event is in the digest");
+    failures += check(sink->spool_count == 1, "spool still holds it");
+    failures += check(pending_after_restart() == 1, "a restart before the digest would retry it");
+    
+    // Quiet period over: the digest goes out and the held entry is retired
+    email_digest.last_event_us -= EMAIL_QUIET_SECONDS * 1000000ull;
+    email_sink_poll();
+    failures += check(email_digest.count == 0, "digest sent");
+    if (!sink->holding()) {
+        spool_release_held(sink);
+    }
+    failures += check(sink->spool_count == 0, "spool empty after the digest");
+    failures += check(pending_after_restart() == 0, "nothing left to retry after a restart");
+    
+    close(sink->spool_fd);
+    unlink("./alert_spool_email.bin");
+    curl_global_cleanup();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * Edge Gunshot Detector - streaming model on the live path
+ * Streams synthetic shots through capture_frames with the SDK stand-in's streaming model, which only
+ * fires once its carried state has seen several loud frames. Checks that events open at the audio their
+ * step covered, that the first step closes the startup timeline, that extra heads staged next to it are
+ * dropped rather than left waiting for a window, and that a slow model sheds straight to energy-only
+ * (wide stride and cascade-only do not apply to a streaming model) and still detects there.
+ * Usage: stream_replay model.tflite   (any model file; the stand-in only reads its tensor quantization)
+ */
+
+#define main detector_main
+int detector_main(int argc, char *argv[]);
+#include "gunshot_detector_v1192_official.c"
+#undef main
+
+#define SHOT_SECONDS 20
+#define SHOT_INTERVAL (2 * TARGET_SAMPLE_RATE)
+
+static int check(bool ok, const char *what) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    return ok ? 0 : 1;
+}
+
+/**
+ * Quiet noise with a decaying broadband burst every SHOT_INTERVAL samples, the first one after a quiet interval
+ */
+static sample_t *synthesize_shots(size_t num_samples) {
+    sample_t *samples = malloc(num_samples * sizeof(sample_t));
+    uint32_t seed = 12345;
+    for (size_t i = 0; samples && i < num_samples; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float noise = (float)(seed >> 8) / (1 << 24) * 2.0f - 1.0f;
+        size_t since = i % SHOT_INTERVAL;
+        float gain = i >= SHOT_INTERVAL / 2 && since < TARGET_SAMPLE_RATE / 5
+                     ? 0.9f * expf(-(float)since / (TARGET_SAMPLE_RATE / 20)) : 0.002f;
+        samples[i] = (sample_t)(noise * gain);
+    }
+    return samples;
+}
+
+/**
+ * Stream the recording and count the events it opened, checking each one's start against its step
+ */
+static unsigned replay_events(const sample_t *samples, size_t num_samples, unsigned *misplaced) {
+    const uint32_t span = (active_backend->inputFrames - 1) * HOP_LENGTH + N_FFT;
+    const uint64_t span_ms = span * 1000ULL / TARGET_SAMPLE_RATE + 1;
+    uint64_t head = atomic_load(&event_bus_head);
+    replay_stream(samples, num_samples, false);
+
+    unsigned opened = 0;
+    for (uint64_t i = head; i < atomic_load(&event_bus_head); i++) {
+        const struct detection_event *e = &event_bus[i & (EVENT_BUS_SLOTS - 1)].event;
+        if (e->kind == DETECTION_EVENT_OPENED) {
+            opened++;
+            *misplaced += e->start_ms > e->end_ms || e->end_ms - e->start_ms > span_ms;
+        }
+    }
+    return opened;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s model.tflite\n", argv[0]);
+        return 2;
+    }
+    startup_begin_us = monotonic_us();
+#ifndef GUNSHOT_FIXED_POINT
+    if (!init_fft_workspace()) {
+        return 1;
+    }
+#endif
+    init_canned_window();
+    init_screen_weights();
+
+    // A window head staged before the streaming model takes over must not wait for a window boundary
+    // that never comes
+    snprintf(model_path, sizeof(model_path), "%s", argv[1]);
+    snprintf(extra_models, sizeof(extra_models), "glass %s", argv[1]);
+    snprintf(heads_attempt_spec, sizeof(heads_attempt_spec), "%s", extra_models);
+    atomic_store(&staged_heads, head_set_load(extra_models));
+    setenv("STUB_STREAMING", "1", 1);
+    active_backend = model_backend_load_initial(model_path);
+    if (!atomic_load(&staged_heads) || !active_backend || !active_backend->streaming) {
+        fprintf(stderr, "stand-in models did not load\n");
+        return 1;
+    }
+    struct spa_audio_info_raw raw = { .format = CAPTURE_FORMAT, .rate = TARGET_SAMPLE_RATE, .channels = 1 };
+    if (!bind_conversion_chain(&capture_chain, &raw)) {
+        return 1;
+    }
+    realtime_mode = false;
+    ml_ready = true;
+
+    const size_t num_samples = (size_t)SHOT_SECONDS * TARGET_SAMPLE_RATE;
+    const unsigned shots = (num_samples - 1) / SHOT_INTERVAL;
+    sample_t *samples = synthesize_shots(num_samples);
+    if (!samples) {
+        return 1;
+    }
+    int failed = 0;
+
+    // Full quality: detections need state carried across steps
+    load_shedding = false;
+    unsigned misplaced = 0;
+    unsigned events = replay_events(samples, num_samples, &misplaced);
+    printf("full quality: %u events for %u shots, %u inferences\n", events, shots, inference_count);
+    failed |= check(events == shots, "every shot opens one event");
+    failed |= check(misplaced == 0, "events start within the step that detected them");
+    failed |= check(startup_complete && startup_first_window_ms > 0, "first step closes the startup timeline");
+    failed |= check(stats->windows_by_load_level[GUNSHOT_LOAD_FULL] > 0 && stats->real_time_factor > 0.0f,
+                    "steps feed the load statistics");
+    failed |= check(!atomic_load(&staged_heads) && !active_heads && !atomic_load(&heads_loading),
+                    "extra heads dropped next to a streaming model");
+
+    // A model slower than real time: shed to energy-only, where steps stop running the model
+    setenv("STUB_SLOW_US", "40000", 1);
+    load_shedding = true;
+    misplaced = 0;
+    events = replay_events(samples, num_samples, &misplaced);
+    printf("slow model: %u events, load level %s, %u inferences\n", events,
+           gunshot_load_level_names[load_level], inference_count);
+    failed |= check(load_level == GUNSHOT_LOAD_ENERGY_ONLY, "slow steps shed to energy-only");
+    failed |= check(stats->windows_by_load_level[GUNSHOT_LOAD_WIDE_STRIDE] == 0 &&
+                    stats->windows_by_load_level[GUNSHOT_LOAD_CASCADE_ONLY] == 0,
+                    "no steps at levels a streaming model cannot use");
+    failed |= check(events > 0 && misplaced == 0, "energy-only steps still open events");
+
+    free(samples);
+    model_backend_destroy(active_backend);
+    return failed;
+}
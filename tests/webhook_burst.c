@@ -0,0 +1,97 @@
+/**
+ * Edge Gunshot Detector - webhook burst test
+ * Delivers events back-to-back through the webhook sink and reports throughput and per-event latency.
+ * With "spool", failed events go through the sink's spool (in the current directory) and are retried until
+ * it is empty, ignoring the backoff; the stand-ins' request counts show which endpoints got them again.
+ * Usage: webhook_burst "url[,url...]" events [spool]
+ */
+
+#define SPOOL_DIR "."
+#define main detector_main
+int detector_main(int argc, char *argv[]);
+#include "gunshot_detector_v1192_official.c"
+#undef main
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Deliver the events through the sink's spool and retry it to the end; true once nothing is pending
+ */
+static bool spool_run(int n) {
+    struct event_sink *sink = &webhook_sink;
+    char path[256];
+    spool_path(sink, path, sizeof(path));
+    unlink(path);
+    sink->spool_fd = -1;
+    spool_open(sink);
+    if (sink->spool_fd < 0) {
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        struct detection_event e = {
+            .kind = DETECTION_EVENT_OPENED, .id = (uint32_t)i + 1, .routes = EVENT_ROUTE_ALL, .time_ms = unix_ms(),
+        };
+        snprintf(e.label, sizeof(e.label), "%s", PRIMARY_LABEL);
+        event_sink_handle(sink, &e);
+    }
+    for (int round = 0; round < 10 && sink->spool_count > 0; round++) {
+        sink->spool_retry_at_us = 0;
+        spool_retry(sink);
+    }
+    printf("%llu delivered, %llu rejected, %llu spooled, %zu still pending\n",
+           (unsigned long long)atomic_load(&sink->delivered), (unsigned long long)atomic_load(&sink->failed),
+           (unsigned long long)atomic_load(&sink->spool_added), sink->spool_count);
+    close(sink->spool_fd);
+    unlink(path);
+    return sink->spool_count == 0;
+}
+
+int main(int argc, char **argv) {
+    if ((argc != 3 && (argc != 4 || strcmp(argv[3], "spool") != 0)) || atoi(argv[2]) <= 0) {
+        fprintf(stderr, "usage: %s \"url[,url...]\" events [spool]\n", argv[0]);
+        return 2;
+    }
+    int n = atoi(argv[2]);
+    uint64_t *latency = calloc((size_t)n, sizeof(*latency));
+    if (!latency) {
+        return 2;
+    }
+    
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    snprintf(webhook_urls, sizeof(webhook_urls), "%s", argv[1]);
+    if (argc == 4) {
+        bool ok = spool_run(n);
+        webhook_cleanup();
+        curl_global_cleanup();
+        free(latency);
+        return ok ? 0 : 1;
+    }
+    
+    int delivered = 0;
+    uint64_t start = monotonic_us();
+    for (int i = 0; i < n; i++) {
+        struct detection_event e = {
+            .id = (uint32_t)i + 1, .confidence = 0.9f, .load_level = GUNSHOT_LOAD_FULL,
+        };
+        snprintf(e.label, sizeof(e.label), "%s", PRIMARY_LABEL);
+        uint64_t t = monotonic_us();
+        uint32_t targets = SINK_TARGETS_ALL;
+        if (webhook_sink_deliver(&e, &targets) == SINK_DELIVERED) {
+            delivered++;
+        }
+        latency[i] = monotonic_us() - t;
+    }
+    double seconds = (double)(monotonic_us() - start) / 1e6;
+    webhook_cleanup();
+    curl_global_cleanup();
+    
+    qsort(latency, (size_t)n, sizeof(*latency), compare_u64);
+    printf("%d/%d delivered in %.3f s (%.0f events/s), median %.2f ms, p99 %.2f ms, worst %.2f ms\n",
+           delivered, n, seconds, n / seconds, latency[n / 2] / 1000.0,
+           latency[(n * 99) / 100] / 1000.0, latency[n - 1] / 1000.0);
+    free(latency);
+    return delivered == n ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""
+Edge Gunshot Detector - webhook stand-in server
+Keep-alive HTTP/1.1 endpoint for the webhook tests. POST bodies must be JSON; the first FAIL_FIRST
+requests get STATUS (503) and each request is held DELAY seconds. GET returns "<requests> <connections>".
+Usage: webhook_standin.py port [fail_first [delay [status]]]
+"""
+
+import http.server
+import json
+import os
+import socketserver
+import sys
+import threading
+import time
+
+lock = threading.Lock()
+connections = set()
+requests = 0
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, *args):
+        pass
+
+    def do_POST(self):
+        global requests
+        json.loads(self.rfile.read(int(self.headers["Content-Length"])))
+        with lock:
+            connections.add(self.client_address)
+            requests += 1
+            count = requests
+        time.sleep(DELAY)
+        self.send_response(STATUS if count <= FAIL_FIRST else 200)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def do_GET(self):
+        with lock:
+            body = f"{requests} {len(connections)}".encode()
+        self.send_response(200)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+
+def exit_with_parent(parent):
+    """Stop when the test runner goes away, even if it could not clean up"""
+    while os.getppid() == parent:
+        time.sleep(0.5)
+    os._exit(0)
+
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(__doc__.strip().splitlines()[-1])
+    FAIL_FIRST = int(sys.argv[2]) if len(sys.argv) > 2 else 0
+    DELAY = float(sys.argv[3]) if len(sys.argv) > 3 else 0.0
+    STATUS = int(sys.argv[4]) if len(sys.argv) > 4 else 503
+    threading.Thread(target=exit_with_parent, args=(os.getppid(),), daemon=True).start()
+    server = Server(("127.0.0.1", int(sys.argv[1])), Handler)
+    print("ready", flush=True)
+    server.serve_forever()